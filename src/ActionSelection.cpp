@@ -1,5 +1,8 @@
 #include "ActionSelection.h"
 
+#include <algorithm>
+#include <cassert>
+
 using namespace BWAPI;
 
 AbstractOrder::Order getAbstractOrder(const BWAPI::Order& order, const RegionID& targetRegion, const RegionID& actualRegion)
@@ -46,57 +49,18 @@ AbstractOrder::Order getAbstractOrder(const BWAPI::Order& order, const RegionID&
 	}
 }
 
-ActionSelection::ActionSelection()
+ActionSelection::ActionSelection(const MapModel& map)
+	: map(map),
+	regionUnits(std::max<size_t>(1, map.regionFromID.size()) * MAX_PLAYERS, 0),
+	regionPlayers(std::max<size_t>(1, map.regionFromID.size()), 0),
+	occupancyUpdates(0)
 {
 	// creating the output file
-	std::string outFilePath = Broodwar->mapPathName() + ".asd";
+	std::string outFilePath = game->mapPathName() + ".asd";
 	outFile.open(outFilePath);
 
-	// Sort regions
-	const std::set<BWTA::Region*>& unsortedRegions = BWTA::getRegions();
-	std::set<BWTA::Region*, SortByXY> sortedRegions(unsortedRegions.begin(), unsortedRegions.end());
-
-	// Fill map to regionID variable
-	RegionID id = 0;
-	for (const auto& r : sortedRegions) {
-		regionID[r] = id;
-		regionFromID[id] = r;
-		id++;
-	}
-
-	// creating regionIdMap
-	regionIdMap.resize(BWAPI::Broodwar->mapWidth(), BWAPI::Broodwar->mapHeight());
-	regionIdMap.setTo(0);
-	for (int x = 0; x < Broodwar->mapWidth(); ++x) {
-		for (int y = 0; y < Broodwar->mapHeight(); ++y) {
-			BWTA::Region* tileRegion = BWTA::getRegion(x, y);
-			if (tileRegion == nullptr) tileRegion = getNearestRegion(x, y);
-			regionIdMap[x][y] = regionID[tileRegion];
-		}
-	}
-
-	// Calculate distance between regions
-	distanceBetweenRegions.resize(sortedRegions.size(), sortedRegions.size());
-	for (const auto& j : sortedRegions) {
-		for (const auto& k : sortedRegions) {
-			int dist;
-			Position pos1 = j->getCenter();
-			Position pos2 = k->getCenter();
-			// sometimes the center of the region is in an unwalkable area
-			if (Broodwar->isWalkable(BWAPI::WalkPosition(pos1)) &&
-				Broodwar->isWalkable(BWAPI::WalkPosition(pos2))) {
-				dist = (int)BWTA::getGroundDistance(BWAPI::TilePosition(pos1), BWAPI::TilePosition(pos2));
-			} else { // TODO improve this to get a proper position and compute groundDistance
-				dist = (int)pos1.getDistance(pos2);
-			}
-			RegionID id1 = regionID[j];
-			RegionID id2 = regionID[k];
-			distanceBetweenRegions[id1][id2] = dist;
-		}
-	}
-
 	// detect real players
-	for (const auto& player : Broodwar->getPlayers()){
+	for (const auto& player : game->getPlayers()){
 		if (!player->getUnits().empty() && !player->isNeutral()) {
 			activePlayers.insert(player);
 		}
@@ -114,7 +78,7 @@ void ActionSelection::onFrame()
 
 	// create abstract groups
 	AbstractGroupVector abstractGroup;
-	for (const auto& u : Broodwar->getAllUnits()) {
+	for (const auto& u : game->getAllUnits()) {
 		if (u->getType().isWorker()) continue; // ignore workers
 		if (!u->getType().canMove()) continue; // ignore units that cannot move
 		if (u->getType() == UnitTypes::Terran_Vulture_Spider_Mine
@@ -199,7 +163,7 @@ void ActionSelection::onFrame()
 
 	
 	for (auto& it : abstractGroup) {
-		Player p(it.first);
+		Dump::Player p(it.first);
 		for (auto& it2 : it.second) {
 			UnitType ut(it2.first);
 			for (auto& it3 : it2.second) {
@@ -247,12 +211,12 @@ void ActionSelection::onFrame()
 						// print regions features
 						outFile << "#" << getRegionProperties(regId, p, regId);
 						// for each neighbor region
-						for (const auto& r : getNeighbors(regId)) {
-							RegionID nr = regionID.at(r);
+						for (const auto& r : map.getNeighbors(regId)) {
+							RegionID nr = map.regionID.at(r);
 							outFile << "#" << getRegionProperties(nr, p, regId);
 						}
 
-// 						outFile << ",Enemy:" << isEnemyAtRegion(p, regId) << ",Size:" << it3.second.orderVector.size() << ",Frame:" << Broodwar->getFrameCount();
+// 						outFile << ",Enemy:" << isEnemyAtRegion(p, regId) << ",Size:" << it3.second.orderVector.size() << ",Frame:" << game->getFrameCount();
 						outFile << '\n';
 
 						// update last print
@@ -272,7 +236,7 @@ const bool ActionSelection::isMovingToSameRegion(AllOrders order, RegionID regId
 	return order.commonOrder == AbstractOrder::Move && regId == order.commonTargetRegion;
 }
 
-const bool ActionSelection::groupExist(BWAPI::Player p, BWAPI::UnitType ut, RegionID regId, AllOrders order) const
+const bool ActionSelection::groupExist(Dump::Player p, BWAPI::UnitType ut, RegionID regId, AllOrders order) const
 {
 	return lastAbstractGroup.count(p)
 		&& lastAbstractGroup.at(p).count(ut)
@@ -280,7 +244,7 @@ const bool ActionSelection::groupExist(BWAPI::Player p, BWAPI::UnitType ut, Regi
 		&& lastAbstractGroup.at(p).at(ut).at(regId) == order;
 }
 
-const bool ActionSelection::isEqualToLastPrintedOrder(BWAPI::Player p, BWAPI::UnitType ut, RegionID regId, AbstractOrder::Order order) const
+const bool ActionSelection::isEqualToLastPrintedOrder(Dump::Player p, BWAPI::UnitType ut, RegionID regId, AbstractOrder::Order order) const
 {
 	return lastAbstractGroupOrder.count(p)
 		&& lastAbstractGroupOrder.at(p).count(ut)
@@ -288,134 +252,104 @@ const bool ActionSelection::isEqualToLastPrintedOrder(BWAPI::Player p, BWAPI::Un
 		&& lastAbstractGroupOrder.at(p).at(ut).at(regId) == order;
 }
 
-BWTA::Region* ActionSelection::getNearestRegion(int x, int y)
-{
-	//searches outward in a spiral.
-	int length = 1;
-	int j = 0;
-	bool first = true;
-	int dx = 0;
-	int dy = 1;
-	BWTA::Region* tileRegion = nullptr;
-	while (length < Broodwar->mapWidth()) //We'll ride the spiral to the end
-	{
-		//if is a valid regions, return it
-		tileRegion = BWTA::getRegion(x, y);
-		if (tileRegion != nullptr) return tileRegion;
-
-		//otherwise, move to another position
-		x = x + dx;
-		y = y + dy;
-		//count how many steps we take in this direction
-		j++;
-		if (j == length) { //if we've reached the end, its time to turn
-			j = 0;	//reset step counter
-
-			//Spiral out. Keep going.
-			if (!first)
-				length++; //increment step counter if needed
-
-
-			first = !first; //first=true for every other turn so we spiral out at the right rate
-
-			//turn counter clockwise 90 degrees:
-			if (dx == 0) {
-				dx = dy;
-				dy = 0;
-			} else {
-				dy = -dx;
-				dx = 0;
-			}
-		}
-		//Spiral out. Keep going.
-	}
-	return tileRegion;
-}
-
-const RegionID ActionSelection::getRegionID(const BWAPI::Unit& u) const
+const RegionID ActionSelection::getRegionID(const Dump::Unit& u) const
 {
 	return getRegionID(u->getTilePosition());
 }
 
 const RegionID ActionSelection::getRegionID(const BWAPI::TilePosition& tilePos) const
 {
-	return regionIdMap[tilePos.x][tilePos.y];
+	return map.regionIdMap[tilePos];
 }
 
 void ActionSelection::updateRegionOccupancyMap()
 {
-	playerRegionOccupancyMap.clear();
+	++occupancyUpdates;
 	for (const auto& p : activePlayers) {
+		auto index = playerIndex.insert(std::make_pair(p, static_cast<int>(playerIndex.size()))).first;
+		assert(index->second < MAX_PLAYERS);
 		for (const auto& u : p->getUnits()) {
-			playerRegionOccupancyMap[getRegionID(u)].insert(p);
+			RegionID r = getRegionID(u);
+			auto it = unitRegions.find(u);
+			if (it == unitRegions.end()) {
+				UnitRegion ur = { r, index->second, occupancyUpdates };
+				unitRegions.insert(std::make_pair(u, ur));
+				countUnit(r, index->second, 1);
+				continue;
+			}
+			if (it->second.region != r || it->second.player != index->second) {
+				countUnit(it->second.region, it->second.player, -1);
+				it->second.region = r;
+				it->second.player = index->second;
+				countUnit(r, index->second, 1);
+			}
+			it->second.update = occupancyUpdates;
+		}
+	}
+	// dead or given to a non active player
+	for (auto it = unitRegions.begin(); it != unitRegions.end();) {
+		if (it->second.update != occupancyUpdates) {
+			countUnit(it->second.region, it->second.player, -1);
+			it = unitRegions.erase(it);
+		} else {
+			++it;
 		}
 	}
 }
 
-const bool ActionSelection::isEnemyAtRegion(BWAPI::Player p, RegionID r) const
+void ActionSelection::countUnit(RegionID r, int player, int delta)
 {
-	if (!playerRegionOccupancyMap.count(r)) return false;
-	for (const auto& p2 : playerRegionOccupancyMap.at(r)) {
-		if (p != p2) return true;
-	}
-	return false;
+	int& units = regionUnits[r * MAX_PLAYERS + player];
+	units += delta;
+	if (units > 0) regionPlayers[r] |= 1u << player;
+	else regionPlayers[r] &= ~(1u << player);
 }
 
-const bool ActionSelection::isFriendAtRegion(BWAPI::Player p, RegionID r) const
+// 0 for the players which are not active
+uint32_t ActionSelection::playerBit(Dump::Player p) const
 {
-	if (!playerRegionOccupancyMap.count(r)) return false;
-	for (const auto& p2 : playerRegionOccupancyMap.at(r)) {
-		if (p == p2) return true;
-	}
-	return false;
+	auto it = playerIndex.find(p);
+	return it != playerIndex.end() ? 1u << it->second : 0;
+}
+
+const bool ActionSelection::isEnemyAtRegion(Dump::Player p, RegionID r) const
+{
+	return (regionPlayers[r] & ~playerBit(p)) != 0;
+}
+
+const bool ActionSelection::isFriendAtRegion(Dump::Player p, RegionID r) const
+{
+	return (regionPlayers[r] & playerBit(p)) != 0;
 }
 
 RegionID ActionSelection::getBestNeighbor(RegionID fromRegId, RegionID toRegId) const
 {
 	// get neighbors
-	std::set<BWTA::Region*> neighbors = getNeighbors(fromRegId);
+	const std::set<Dump::Region*>& neighbors = map.getNeighbors(fromRegId);
 
 	// find closest region
-	Position toPos = regionFromID.at(toRegId)->getCenter();
-	BWTA::Region* bestReg = nullptr;
+	Position toPos = map.regionFromID.at(toRegId)->getCenter();
+	Dump::Region* bestReg = nullptr;
 	int minDist = std::numeric_limits<int>::max();
 	for (const auto& r : neighbors) {
-// 		if (!regionID.count(r)) {
+// 		if (!map.regionID.count(r)) {
 // 			DEBUG("Not valid region, possible bug in BWTA");
 // 			continue;
 // 		}
-		if (toRegId == regionID.at(r)) {
+		if (toRegId == map.regionID.at(r)) {
 			return toRegId;
 		}
-		int dist = distanceBetweenRegions[toRegId][regionID.at(r)];
+		int dist = map.distanceBetweenRegions(toRegId, map.regionID.at(r));
 		if (dist < minDist) {
 			bestReg = r;
 			minDist = dist;
 		}
 	}
 	if (bestReg == nullptr) return toRegId; // the region has not neighbors
-	return regionID.at(bestReg);
-}
-
-std::set<BWTA::Region*> ActionSelection::getNeighbors(RegionID regId) const
-{
-	BWTA::Region* region = regionFromID.at(regId);
-	auto chokes = region->getChokepoints();
-	std::set<BWTA::Region*> neighbors;
-	for (const auto& c : chokes) {
-		BWTA::Region* r = nullptr;
-		if (c->getRegions().first != region) r = c->getRegions().first;
-		else r = c->getRegions().second;
-		if (!regionID.count(r)) {
-			DEBUG("Not valid region, possible bug in BWTA");
-			continue;
-		}
-		neighbors.insert(r);
-	}
-	return neighbors;
+	return map.regionID.at(bestReg);
 }
 
-std::string ActionSelection::getPossibleActions(RegionID regId, BWAPI::Player p) const
+std::string ActionSelection::getPossibleActions(RegionID regId, Dump::Player p) const
 {
 	// IDLE action is omitted since it's always possible
 	std::stringstream actions;
@@ -423,21 +357,21 @@ std::string ActionSelection::getPossibleActions(RegionID regId, BWAPI::Player p)
 		actions << "ATTACK,";
 	}
 
-	std::set<BWTA::Region*> neighbors = getNeighbors(regId);
+	const std::set<Dump::Region*>& neighbors = map.getNeighbors(regId);
 	if (!neighbors.empty()) {
 		auto last = neighbors.end();
 		--last;
 		for (auto it = neighbors.begin(); it != last; ++it) {
-			if (!regionID.count(*it)) DEBUG("Region not found");
-			actions << "MOVE:" << regionID.at(*it) << ",";
+			if (!map.regionID.count(*it)) DEBUG("Region not found");
+			actions << "MOVE:" << map.regionID.at(*it) << ",";
 		}
-		if (!regionID.count(*last)) DEBUG("Region not found");
-		actions << "MOVE:" << regionID.at(*last);
+		if (!map.regionID.count(*last)) DEBUG("Region not found");
+		actions << "MOVE:" << map.regionID.at(*last);
 	}
 	return actions.str();
 }
 
-std::string ActionSelection::getRegionProperties(RegionID regId, BWAPI::Player p, RegionID fromRegId) const
+std::string ActionSelection::getRegionProperties(RegionID regId, Dump::Player p, RegionID fromRegId) const
 {
 	std::stringstream ret;
 	ret << regId << ":";
@@ -455,14 +389,14 @@ std::string ActionSelection::getRegionProperties(RegionID regId, BWAPI::Player p
 		int minDistToFriendBaseActualReg = std::numeric_limits<int>::max();
 		int minDistToFriendBaseTargetReg = std::numeric_limits<int>::max();
 		for (const auto& b : bases) {
-			BWTA::Region* baseReg = BWTA::getRegion(b->getPosition());
-			if (!regionID.count(baseReg)) {
+			Dump::Region* baseReg = game->getRegion(b->getPosition());
+			if (!map.regionID.count(baseReg)) {
 // 				DEBUG("Region not found"); // usually because the building is lifted in a non walkable region 
 				continue;
 			}
-			RegionID regionBase = regionID.at(baseReg);
-			int distFromActualReg = distanceBetweenRegions[fromRegId][regionBase];
-			int distFromTargetReg = distanceBetweenRegions[regId][regionBase];
+			RegionID regionBase = map.regionID.at(baseReg);
+			int distFromActualReg = map.distanceBetweenRegions(fromRegId, regionBase);
+			int distFromTargetReg = map.distanceBetweenRegions(regId, regionBase);
 			if (b->getPlayer() == p) { // is a friendly base
 				minDistToFriendBaseActualReg = std::min(minDistToFriendBaseActualReg, distFromActualReg);
 				minDistToFriendBaseTargetReg = std::min(minDistToFriendBaseTargetReg, distFromTargetReg);
@@ -479,7 +413,7 @@ std::string ActionSelection::getRegionProperties(RegionID regId, BWAPI::Player p
 	return ret.str();
 }
 
-void ActionSelection::onUnitCreate(BWAPI::Unit unit)
+void ActionSelection::onUnitCreate(Dump::Unit unit)
 {
 	if (unit->getType().isResourceDepot()) {
 // 		if (activePlayers.find(unit->getPlayer()) != activePlayers.end()) {
@@ -488,7 +422,7 @@ void ActionSelection::onUnitCreate(BWAPI::Unit unit)
 	}
 }
 
-void ActionSelection::onUnitDestroy(BWAPI::Unit unit)
+void ActionSelection::onUnitDestroy(Dump::Unit unit)
 {
 	if (unit->getType().isResourceDepot()) {
 		bases.erase(unit);
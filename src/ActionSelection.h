@@ -1,36 +1,12 @@
 #pragma once
 
-#include "Utils.h"
+#include <cstdint>
+#include <unordered_map>
 
-using RegionID = size_t;
-
-struct SortByXY
-{
-	bool operator ()(const BWTA::Region* const &lReg, const BWTA::Region* const &rReg) const
-	{
-		BWAPI::Position lPos = lReg->getCenter();
-		BWAPI::Position rPos = rReg->getCenter();
-		if (lPos.x == rPos.x) {
-			return lPos.y < rPos.y;
-		} else {
-			return lPos.x < rPos.x;
-		}
-	}
-
-	bool operator ()(const BWTA::Chokepoint* const &lReg, const BWTA::Chokepoint* const &rReg) const
-	{
-		BWAPI::Position lPos = lReg->getCenter();
-		BWAPI::Position rPos = rReg->getCenter();
-		if (lPos.x == rPos.x) {
-			return lPos.y < rPos.y;
-		} else {
-			return lPos.x < rPos.x;
-		}
-	}
-};
+#include "MapModel.h"
 
 namespace AbstractOrder {
-	static enum Order {
+	enum Order {
 		Unknown, Nothing, Idle, Gas, Mineral, Move, Attack, Heal
 	};
 	static std::string getName[8] = {
@@ -64,42 +40,52 @@ struct AllOrders
 
 };
 
-using AbstractGroupVector = std::map < BWAPI::Player, std::map<BWAPI::UnitType, std::map<RegionID, AllOrders> > > ;
-using AbstractGroupOrderVector = std::map < BWAPI::Player, std::map<BWAPI::UnitType, std::map<RegionID, AbstractOrder::Order> > >;
+using AbstractGroupVector = std::map < Dump::Player, std::map<BWAPI::UnitType, std::map<RegionID, AllOrders> > > ;
+using AbstractGroupOrderVector = std::map < Dump::Player, std::map<BWAPI::UnitType, std::map<RegionID, AbstractOrder::Order> > >;
 
 class ActionSelection
 {
 public:
-	ActionSelection();
+	ActionSelection(const MapModel& map);
 	~ActionSelection();
 
 	void onFrame();
-	void onUnitCreate(BWAPI::Unit unit);
-	void onUnitDestroy(BWAPI::Unit unit);
+	void onUnitCreate(Dump::Unit unit);
+	void onUnitDestroy(Dump::Unit unit);
 
 private:
-	std::ofstream outFile;
-	std::map<BWTA::Region*, RegionID> regionID;
-	std::map<RegionID, BWTA::Region*> regionFromID;
-	BWTA::RectangleArray<RegionID> regionIdMap;
-	BWTA::RectangleArray<int> distanceBetweenRegions;
+	const MapModel& map;
+	AsyncOutputFile outFile;
 	AbstractGroupVector lastAbstractGroup;
 	AbstractGroupOrderVector lastAbstractGroupOrder;
-	std::map<RegionID, std::set<BWAPI::Player>> playerRegionOccupancyMap;
-	BWAPI::Unitset bases;
-
-	BWTA::Region* getNearestRegion(int x, int y);
-	const RegionID getRegionID(const BWAPI::Unit& u) const;
+	// units of the active players in each region, only the units that changed region or player since
+	// the last frame move the counts; bit i of regionPlayers[r] is set if player i has units in r
+	struct UnitRegion
+	{
+		RegionID region;
+		int player; // index in playerIndex
+		int update; // last updateRegionOccupancyMap which saw the unit
+	};
+	static const int MAX_PLAYERS = 32;
+	std::map<Dump::Player, int, Dump::ByID> playerIndex;
+	std::unordered_map<Dump::Unit, UnitRegion> unitRegions;
+	std::vector<int> regionUnits; // units of player i in region r at [r * MAX_PLAYERS + i]
+	std::vector<uint32_t> regionPlayers;
+	int occupancyUpdates;
+	Dump::Unitset bases;
+
+	const RegionID getRegionID(const Dump::Unit& u) const;
 	const RegionID getRegionID(const BWAPI::TilePosition& tilePos) const;
 	const RegionID getRegionID(const BWAPI::Position& pos) const { return getRegionID(BWAPI::TilePosition(pos)); };
-	const bool groupExist(BWAPI::Player p, BWAPI::UnitType ut, RegionID regId, AllOrders order) const;
-	const bool isEqualToLastPrintedOrder(BWAPI::Player p, BWAPI::UnitType ut, RegionID regId, AbstractOrder::Order order) const;
+	const bool groupExist(Dump::Player p, BWAPI::UnitType ut, RegionID regId, AllOrders order) const;
+	const bool isEqualToLastPrintedOrder(Dump::Player p, BWAPI::UnitType ut, RegionID regId, AbstractOrder::Order order) const;
 	const bool isMovingToSameRegion(AllOrders order, RegionID regId) const;
 	void updateRegionOccupancyMap();
-	const bool isEnemyAtRegion(BWAPI::Player p, RegionID r) const;
-	const bool isFriendAtRegion(BWAPI::Player p, RegionID r) const;
+	void countUnit(RegionID r, int player, int delta);
+	uint32_t playerBit(Dump::Player p) const;
+	const bool isEnemyAtRegion(Dump::Player p, RegionID r) const;
+	const bool isFriendAtRegion(Dump::Player p, RegionID r) const;
 	RegionID getBestNeighbor(RegionID fromRegId, RegionID toRegId) const;
-	std::set<BWTA::Region*> getNeighbors(RegionID regId) const;
-	std::string getPossibleActions(RegionID regId, BWAPI::Player p) const;
-	std::string getRegionProperties(RegionID regId, BWAPI::Player p, RegionID fromRegId) const;
+	std::string getPossibleActions(RegionID regId, Dump::Player p) const;
+	std::string getRegionProperties(RegionID regId, Dump::Player p, RegionID fromRegId) const;
 };
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "AsyncWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "CorpusArchive.h"
+
+// ====================================================================================
+// Writer thread, running while at least one file is open
+// ====================================================================================
+
+namespace
+{
+	std::mutex writerMutex; // open files and thread lifetime, held by the writer while draining
+	std::condition_variable wakeUp;
+	std::vector<AsyncFileBuffer*> openFiles;
+	std::thread writerThread;
+	bool stopping = false;
+
+	void writerLoop()
+	{
+		std::unique_lock<std::mutex> lock(writerMutex);
+		while (!stopping) {
+			bool wrote = false;
+			for (const auto& file : openFiles) wrote |= file->drain();
+			// the producers notify without the lock, a missed wake up only costs the timeout
+			if (!wrote) wakeUp.wait_for(lock, std::chrono::milliseconds(10));
+		}
+	}
+
+	void registerFile(AsyncFileBuffer* file)
+	{
+		std::lock_guard<std::mutex> lock(writerMutex);
+		openFiles.push_back(file);
+		if (!writerThread.joinable()) {
+			stopping = false;
+			writerThread = std::thread(writerLoop);
+		}
+	}
+
+	void unregisterFile(AsyncFileBuffer* file)
+	{
+		{
+			std::lock_guard<std::mutex> lock(writerMutex);
+			openFiles.erase(std::remove(openFiles.begin(), openFiles.end(), file), openFiles.end());
+			if (!openFiles.empty()) return;
+			stopping = true;
+		}
+		wakeUp.notify_one();
+		writerThread.join();
+	}
+}
+
+// ====================================================================================
+// AsyncFileBuffer
+// ====================================================================================
+
+AsyncFileBuffer::AsyncFileBuffer()
+	: file(nullptr), inMemory(false), published(0), written(0)
+{
+}
+
+AsyncFileBuffer::~AsyncFileBuffer()
+{
+	close();
+}
+
+bool AsyncFileBuffer::open(const std::string& path, bool binary)
+{
+	if (isOpen()) return false;
+	if (Corpus::capturing()) {
+		inMemory = true;
+		this->path = path;
+		memory.clear();
+		chunks.assign(1, std::vector<char>(CHUNK_SIZE));
+		setp(chunks[0].data(), chunks[0].data() + CHUNK_SIZE);
+		return true;
+	}
+	file = fopen(path.c_str(), binary ? "wb" : "w");
+	if (file == nullptr) return false;
+
+	chunks.assign(CHUNKS_PER_FILE, std::vector<char>(CHUNK_SIZE));
+	sizes.assign(CHUNKS_PER_FILE, 0);
+	published = 0;
+	written = 0;
+	setp(chunks[0].data(), chunks[0].data() + CHUNK_SIZE);
+	registerFile(this);
+	return true;
+}
+
+void AsyncFileBuffer::close()
+{
+	if (inMemory) {
+		publish();
+		Corpus::addStream(path, memory);
+		inMemory = false;
+		setp(nullptr, nullptr);
+		std::vector<std::vector<char> >().swap(chunks);
+		return;
+	}
+	if (file == nullptr) return;
+	publish();
+	while (written.load(std::memory_order_acquire) != published.load(std::memory_order_relaxed)) {
+		wakeUp.notify_one();
+		std::this_thread::yield();
+	}
+	unregisterFile(this);
+	fclose(file);
+	file = nullptr;
+	setp(nullptr, nullptr);
+	std::vector<std::vector<char> >().swap(chunks);
+}
+
+void AsyncFileBuffer::publish()
+{
+	size_t size = pptr() - pbase();
+	if (size == 0) return;
+	if (inMemory) {
+		memory.append(pbase(), size);
+		setp(pbase(), pbase() + CHUNK_SIZE);
+		return;
+	}
+	size_t head = published.load(std::memory_order_relaxed);
+	sizes[head % CHUNKS_PER_FILE] = size;
+	published.store(head + 1, std::memory_order_release);
+	wakeUp.notify_one();
+
+	// the next chunk is free once the writer is done with it
+	while (head + 1 - written.load(std::memory_order_acquire) >= CHUNKS_PER_FILE) std::this_thread::yield();
+	char* next = chunks[(head + 1) % CHUNKS_PER_FILE].data();
+	setp(next, next + CHUNK_SIZE);
+}
+
+bool AsyncFileBuffer::drain()
+{
+	size_t tail = written.load(std::memory_order_relaxed);
+	size_t head = published.load(std::memory_order_acquire);
+	if (tail == head) return false;
+	for (; tail != head; ++tail) {
+		fwrite(chunks[tail % CHUNKS_PER_FILE].data(), 1, sizes[tail % CHUNKS_PER_FILE], file);
+		written.store(tail + 1, std::memory_order_release);
+	}
+	return true;
+}
+
+AsyncFileBuffer::int_type AsyncFileBuffer::overflow(int_type c)
+{
+	if (!isOpen()) return traits_type::eof();
+	publish();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+int AsyncFileBuffer::sync()
+{
+	if (!isOpen()) return -1;
+	publish(); // does not wait for the disk
+	return 0;
+}
+
+// ====================================================================================
+// AsyncOutputFile
+// ====================================================================================
+
+void AsyncOutputFile::open(const std::string& path, std::ios_base::openmode mode)
+{
+	if (buffer.open(path, (mode & std::ios_base::binary) != 0)) clear();
+	else setstate(std::ios_base::failbit);
+}
+
+void AsyncOutputFile::close()
+{
+	if (buffer.isOpen()) buffer.close();
+	else setstate(std::ios_base::failbit);
+}
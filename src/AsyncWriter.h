@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Output files written by a background thread, so the frame loop never waits for the disk.
+// The stream formats the records into fixed size chunks, a full chunk (or flush()) is handed to
+// the writer thread through a single producer / single consumer ring (no locks). The game thread
+// only waits when the disk is CHUNKS_PER_FILE chunks behind, or on close().
+// Drop-in replacement of std::ofstream for the replay data files:
+//
+//   AsyncOutputFile replayDat;
+//   replayDat.open(filepath);
+//   replayDat << frame << "," << unit->getID() << '\n';
+//   replayDat.close(); // everything is on disk after this
+//
+// open() and close() are expected from a single thread (the game thread).
+// While a replay goes to the corpus archive (Corpus::capturing()), the file is kept in memory
+// instead and handed to the archive on close().
+
+class AsyncFileBuffer : public std::streambuf
+{
+public:
+	static const size_t CHUNK_SIZE = 1 << 16;
+	static const size_t CHUNKS_PER_FILE = 16;
+
+	AsyncFileBuffer();
+	~AsyncFileBuffer();
+	bool open(const std::string& path, bool binary);
+	bool isOpen() const { return file != nullptr || inMemory; }
+	void close();
+
+	// writer thread side, writes the published chunks (returns false if there were none)
+	bool drain();
+
+protected:
+	virtual int_type overflow(int_type c);
+	virtual int sync();
+
+private:
+	FILE* file;
+	bool inMemory;
+	std::string path;
+	std::string memory;
+	std::vector<std::vector<char> > chunks;
+	std::vector<size_t> sizes;
+	std::atomic<size_t> published; // chunks handed to the writer (game thread)
+	std::atomic<size_t> written;   // chunks on disk (writer thread)
+
+	void publish(); // current chunk, then waits for a free one
+	AsyncFileBuffer(const AsyncFileBuffer&);
+	AsyncFileBuffer& operator=(const AsyncFileBuffer&);
+};
+
+class AsyncOutputFile : public std::ostream
+{
+public:
+	AsyncOutputFile() : std::ostream(nullptr) { rdbuf(&buffer); }
+	~AsyncOutputFile() { close(); }
+
+	void open(const std::string& path, std::ios_base::openmode mode = std::ios_base::out);
+	bool is_open() const { return buffer.isOpen(); }
+	void close();
+
+private:
+	AsyncFileBuffer buffer;
+};
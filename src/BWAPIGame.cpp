@@ -0,0 +1,186 @@
+#include "BWAPIGame.h"
+
+using namespace BWAPI;
+
+// ====================================================================================
+// BWAPIUnit
+// ====================================================================================
+
+Dump::Player BWAPIUnit::getPlayer() const
+{
+	return game->getPlayer(unit->getPlayer());
+}
+
+Dump::Player BWAPIUnit::getLastAttackingPlayer() const
+{
+	return game->getPlayer(unit->getLastAttackingPlayer());
+}
+
+Dump::Unit BWAPIUnit::getOrderTarget() const
+{
+	return game->getUnit(unit->getOrderTarget());
+}
+
+Dump::Unit BWAPIUnit::getTarget() const
+{
+	return game->getUnit(unit->getTarget());
+}
+
+Dump::Unitset BWAPIUnit::getUnitsInRadius(int radius) const
+{
+	return game->getUnits(unit->getUnitsInRadius(radius));
+}
+
+// ====================================================================================
+// BWAPIGame
+// ====================================================================================
+
+BWAPIGame::BWAPIGame()
+	: lastUpdate(-1)
+{
+	for (const auto& p : Broodwar->getPlayers()) {
+		players.insert(getPlayer(p));
+	}
+	for (const auto& tp : Broodwar->getStartLocations()) {
+		startLocations.push_back(tp);
+	}
+
+	for (const auto& r : BWTA::getRegions()) {
+		BWTARegion* region = new BWTARegion(r);
+		regionMap[r] = region;
+		regions.insert(region);
+	}
+	for (const auto& c : BWTA::getChokepoints()) {
+		BWTAChokepoint* choke = new BWTAChokepoint(c);
+		choke->regions = std::make_pair(getRegion(c->getRegions().first), getRegion(c->getRegions().second));
+		chokeMap[c] = choke;
+		chokepoints.insert(choke);
+	}
+	for (const auto& r : regionMap) {
+		for (const auto& c : r.first->getChokepoints()) {
+			r.second->chokepoints.insert(chokeMap[c]);
+		}
+		for (const auto& rr : r.first->getReachableRegions()) {
+			r.second->reachableRegions.insert(getRegion(rr));
+		}
+	}
+
+	update();
+}
+
+BWAPIGame::~BWAPIGame()
+{
+	for (const auto& u : unitMap) delete u.second;
+	for (const auto& p : playerMap) delete p.second;
+	for (const auto& r : regionMap) delete r.second;
+	for (const auto& c : chokeMap) delete c.second;
+}
+
+void BWAPIGame::update()
+{
+	if (Broodwar->getFrameCount() == lastUpdate) return;
+	lastUpdate = Broodwar->getFrameCount();
+	allUnits = getUnits(Broodwar->getAllUnits());
+	for (const auto& p : playerMap) {
+		p.second->units = getUnits(p.first->getUnits());
+	}
+}
+
+Dump::Unit BWAPIGame::getUnit(BWAPI::Unit unit)
+{
+	if (unit == nullptr) return nullptr;
+	auto it = unitMap.find(unit);
+	if (it != unitMap.end()) return it->second;
+	BWAPIUnit* ret = new BWAPIUnit(this, unit);
+	unitMap.insert(std::make_pair(unit, ret));
+	return ret;
+}
+
+Dump::Player BWAPIGame::getPlayer(BWAPI::Player player)
+{
+	if (player == nullptr) return nullptr;
+	auto it = playerMap.find(player);
+	if (it != playerMap.end()) return it->second;
+	BWAPIPlayer* ret = new BWAPIPlayer(player);
+	playerMap.insert(std::make_pair(player, ret));
+	return ret;
+}
+
+Dump::Unitset BWAPIGame::getUnits(const BWAPI::Unitset& units)
+{
+	Dump::Unitset ret;
+	for (const auto& u : units) ret.insert(getUnit(u));
+	return ret;
+}
+
+Dump::Unitset BWAPIGame::getUnitsInRadius(BWAPI::Position center, int radius) const
+{
+	return const_cast<BWAPIGame*>(this)->getUnits(Broodwar->getUnitsInRadius(center, radius));
+}
+
+void BWAPIGame::setVision(Dump::Player player, bool enabled)
+{
+	Broodwar->setVision(static_cast<BWAPIPlayer*>(player)->player, enabled);
+}
+
+Dump::Region* BWAPIGame::getRegion(BWTA::Region* r) const
+{
+	auto it = regionMap.find(r);
+	if (it == regionMap.end()) return nullptr;
+	return it->second;
+}
+
+Dump::Region* BWAPIGame::getRegion(BWAPI::TilePosition tp) const
+{
+	return getRegion(BWTA::getRegion(tp));
+}
+
+Dump::Region* BWAPIGame::getRegion(BWAPI::Position p) const
+{
+	return getRegion(BWTA::getRegion(p));
+}
+
+double BWAPIGame::getGroundDistance(BWAPI::TilePosition start, BWAPI::TilePosition end) const
+{
+	return BWTA::getGroundDistance(start, end);
+}
+
+std::vector<BWAPI::TilePosition> BWAPIGame::getShortestPath(BWAPI::TilePosition start, BWAPI::TilePosition end) const
+{
+	return BWTA::getShortestPath(start, end);
+}
+
+void BWAPIGame::printText(const std::string& text)
+{
+	Broodwar->printf("%s", text.c_str());
+}
+
+void BWAPIGame::drawCircleMap(BWAPI::Position p, int radius, BWAPI::Color color, bool isSolid)
+{
+	Broodwar->drawCircleMap(p, radius, color, isSolid);
+}
+
+void BWAPIGame::drawLineMap(BWAPI::Position a, BWAPI::Position b, BWAPI::Color color)
+{
+	Broodwar->drawLineMap(a, b, color);
+}
+
+void BWAPIGame::drawBoxMap(BWAPI::Position topLeft, BWAPI::Position bottomRight, BWAPI::Color color, bool isSolid)
+{
+	Broodwar->drawBoxMap(topLeft, bottomRight, color, isSolid);
+}
+
+void BWAPIGame::drawTextMap(BWAPI::Position p, const std::string& text)
+{
+	Broodwar->drawTextMap(p, "%s", text.c_str());
+}
+
+void BWAPIGame::setLocalSpeed(int speed)
+{
+	Broodwar->setLocalSpeed(speed);
+}
+
+void BWAPIGame::setScreenPosition(BWAPI::Position p)
+{
+	Broodwar->setScreenPosition(p);
+}
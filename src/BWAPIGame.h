@@ -0,0 +1,186 @@
+#pragma once
+
+#include <map>
+
+#include <BWAPI.h>
+#include <BWTA.h>
+
+#include "GameInterface.h"
+
+// Dump::Game backend on top of BWAPI::Broodwar and BWTA (needs BWTA::analyze() to be done)
+
+class BWAPIGame;
+
+class BWAPIUnit : public Dump::UnitInterface
+{
+public:
+	BWAPIUnit(BWAPIGame* game, BWAPI::Unit unit) : game(game), unit(unit) {}
+
+	virtual int getID() const					{ return unit->getID(); }
+	virtual bool exists() const					{ return unit->exists(); }
+	virtual BWAPI::UnitType getType() const		{ return unit->getType(); }
+	virtual Dump::Player getPlayer() const;
+	virtual BWAPI::Position getPosition() const	{ return unit->getPosition(); }
+	virtual BWAPI::TilePosition getTilePosition() const { return unit->getTilePosition(); }
+	virtual BWAPI::Position getInitialPosition() const	{ return unit->getInitialPosition(); }
+	virtual int getHitPoints() const			{ return unit->getHitPoints(); }
+	virtual int getShields() const				{ return unit->getShields(); }
+	virtual int getEnergy() const				{ return unit->getEnergy(); }
+	virtual int getResourceGroup() const		{ return unit->getResourceGroup(); }
+	virtual int getSpaceRemaining() const		{ return unit->getSpaceRemaining(); }
+	virtual int getGroundWeaponCooldown() const	{ return unit->getGroundWeaponCooldown(); }
+	virtual int getAirWeaponCooldown() const	{ return unit->getAirWeaponCooldown(); }
+	virtual int getSpellCooldown() const		{ return unit->getSpellCooldown(); }
+	virtual Dump::Player getLastAttackingPlayer() const;
+
+	virtual BWAPI::Order getOrder() const		{ return unit->getOrder(); }
+	virtual Dump::Unit getOrderTarget() const;
+	virtual BWAPI::Position getOrderTargetPosition() const { return unit->getOrderTargetPosition(); }
+	virtual Dump::Unit getTarget() const;
+	virtual BWAPI::Position getTargetPosition() const { return unit->getTargetPosition(); }
+
+	virtual bool isAttacking() const			{ return unit->isAttacking(); }
+	virtual bool isUnderAttack() const			{ return unit->isUnderAttack(); }
+	virtual bool isCompleted() const			{ return unit->isCompleted(); }
+	virtual bool isLoaded() const				{ return unit->isLoaded(); }
+	virtual bool isFlying() const				{ return unit->isFlying(); }
+	virtual bool isCloaked() const				{ return unit->isCloaked(); }
+	virtual bool isGatheringMinerals() const	{ return unit->isGatheringMinerals(); }
+	virtual bool isGatheringGas() const			{ return unit->isGatheringGas(); }
+	virtual bool isRepairing() const			{ return unit->isRepairing(); }
+	virtual bool isConstructing() const			{ return unit->isConstructing(); }
+
+	virtual int getDistance(BWAPI::Position target) const { return unit->getDistance(target); }
+	virtual int getDistance(Dump::Unit target) const { return unit->getDistance(static_cast<BWAPIUnit*>(target)->unit); }
+	virtual Dump::Unitset getUnitsInRadius(int radius) const;
+
+private:
+	BWAPIGame* game;
+	BWAPI::Unit unit;
+};
+
+class BWAPIPlayer : public Dump::PlayerInterface
+{
+public:
+	BWAPIPlayer(BWAPI::Player player) : player(player) {}
+
+	virtual int getID() const						{ return player->getID(); }
+	virtual std::string getName() const				{ return player->getName(); }
+	virtual BWAPI::Race getRace() const				{ return player->getRace(); }
+	virtual bool isNeutral() const					{ return player->isNeutral(); }
+	virtual bool isObserver() const					{ return player->isObserver(); }
+	virtual const Dump::Unitset& getUnits() const	{ return units; }
+	virtual BWAPI::TilePosition getStartLocation() const { return player->getStartLocation(); }
+
+	virtual int minerals() const					{ return player->minerals(); }
+	virtual int gas() const							{ return player->gas(); }
+	virtual int gatheredMinerals() const			{ return player->gatheredMinerals(); }
+	virtual int gatheredGas() const					{ return player->gatheredGas(); }
+	virtual int supplyUsed() const					{ return player->supplyUsed(); }
+	virtual int supplyTotal() const					{ return player->supplyTotal(); }
+
+	virtual bool isResearching(BWAPI::TechType tech) const		{ return player->isResearching(tech); }
+	virtual bool hasResearched(BWAPI::TechType tech) const		{ return player->hasResearched(tech); }
+	virtual bool isUpgrading(BWAPI::UpgradeType upgrade) const	{ return player->isUpgrading(upgrade); }
+	virtual int getUpgradeLevel(BWAPI::UpgradeType upgrade) const { return player->getUpgradeLevel(upgrade); }
+
+private:
+	friend class BWAPIGame;
+	BWAPI::Player player;
+	Dump::Unitset units; // refreshed by BWAPIGame::update()
+};
+
+class BWTARegion : public Dump::Region
+{
+public:
+	BWTARegion(BWTA::Region* region) : region(region), polygon(region->getPolygon().begin(), region->getPolygon().end()) {}
+
+	virtual BWAPI::Position getCenter() const		 { return region->getCenter(); }
+	virtual const std::vector<BWAPI::Position>& getPolygon() const { return polygon; }
+	virtual BWAPI::Position getPolygonCenter() const { return region->getPolygon().getCenter(); }
+	virtual const std::set<Dump::Chokepoint*>& getChokepoints() const { return chokepoints; }
+	virtual const std::set<Dump::Region*>& getReachableRegions() const { return reachableRegions; }
+
+private:
+	friend class BWAPIGame;
+	BWTA::Region* region;
+	std::vector<BWAPI::Position> polygon;
+	std::set<Dump::Chokepoint*> chokepoints;
+	std::set<Dump::Region*> reachableRegions;
+};
+
+class BWTAChokepoint : public Dump::Chokepoint
+{
+public:
+	BWTAChokepoint(BWTA::Chokepoint* choke) : choke(choke), regions(nullptr, nullptr), sides(choke->getSides()) {}
+
+	virtual BWAPI::Position getCenter() const { return choke->getCenter(); }
+	virtual double getWidth() const { return choke->getWidth(); }
+	virtual const std::pair<Dump::Region*, Dump::Region*>& getRegions() const { return regions; }
+	virtual const std::pair<BWAPI::Position, BWAPI::Position>& getSides() const { return sides; }
+
+private:
+	friend class BWAPIGame;
+	BWTA::Chokepoint* choke;
+	std::pair<Dump::Region*, Dump::Region*> regions;
+	std::pair<BWAPI::Position, BWAPI::Position> sides;
+};
+
+class BWAPIGame : public Dump::Game
+{
+public:
+	BWAPIGame();
+	~BWAPIGame();
+
+	// refresh the unit sets, to call before forwarding any BWAPI callback. BWAPI only updates its
+	// own sets before the callbacks of a frame, so they are rebuilt once per frame.
+	void update();
+	Dump::Unit getUnit(BWAPI::Unit unit);
+	Dump::Player getPlayer(BWAPI::Player player);
+	Dump::Unitset getUnits(const BWAPI::Unitset& units);
+
+	virtual int getFrameCount() const { return BWAPI::Broodwar->getFrameCount(); }
+	virtual const Dump::Playerset& getPlayers() const { return players; }
+	virtual const Dump::Unitset& getAllUnits() const { return allUnits; }
+	virtual Dump::Unitset getUnitsInRadius(BWAPI::Position center, int radius) const;
+	virtual bool isVisible(BWAPI::TilePosition tp) const { return BWAPI::Broodwar->isVisible(tp); }
+	virtual void setVision(Dump::Player player, bool enabled);
+
+	virtual int mapWidth() const { return BWAPI::Broodwar->mapWidth(); }
+	virtual int mapHeight() const { return BWAPI::Broodwar->mapHeight(); }
+	virtual bool isWalkable(int walkX, int walkY) const { return BWAPI::Broodwar->isWalkable(walkX, walkY); }
+	virtual std::string mapPathName() const { return BWAPI::Broodwar->mapPathName(); }
+	virtual std::string mapName() const { return BWAPI::Broodwar->mapName(); }
+	virtual std::string mapHash() const { return BWAPI::Broodwar->mapHash(); }
+	virtual const std::vector<BWAPI::TilePosition>& getStartLocations() const { return startLocations; }
+
+	virtual const std::set<Dump::Region*>& getRegions() const { return regions; }
+	virtual const std::set<Dump::Chokepoint*>& getChokepoints() const { return chokepoints; }
+	virtual Dump::Region* getRegion(BWAPI::TilePosition tp) const;
+	virtual Dump::Region* getRegion(BWAPI::Position p) const;
+	virtual double getGroundDistance(BWAPI::TilePosition start, BWAPI::TilePosition end) const;
+	virtual std::vector<BWAPI::TilePosition> getShortestPath(BWAPI::TilePosition start, BWAPI::TilePosition end) const;
+
+	virtual void printText(const std::string& text);
+	virtual void drawCircleMap(BWAPI::Position p, int radius, BWAPI::Color color, bool isSolid = false);
+	virtual void drawLineMap(BWAPI::Position a, BWAPI::Position b, BWAPI::Color color);
+	virtual void drawBoxMap(BWAPI::Position topLeft, BWAPI::Position bottomRight, BWAPI::Color color, bool isSolid = false);
+	virtual void drawTextMap(BWAPI::Position p, const std::string& text);
+	virtual void setLocalSpeed(int speed);
+	virtual void setScreenPosition(BWAPI::Position p);
+
+private:
+	std::map<BWAPI::Unit, BWAPIUnit*> unitMap;
+	std::map<BWAPI::Player, BWAPIPlayer*> playerMap;
+	std::map<BWTA::Region*, BWTARegion*> regionMap;
+	std::map<BWTA::Chokepoint*, BWTAChokepoint*> chokeMap;
+
+	Dump::Unitset allUnits;
+	int lastUpdate; // frame of the unit sets
+	Dump::Playerset players;
+	std::vector<BWAPI::TilePosition> startLocations;
+	std::set<Dump::Region*> regions;
+	std::set<Dump::Chokepoint*> chokepoints;
+
+	Dump::Region* getRegion(BWTA::Region* r) const;
+};
@@ -19,24 +19,18 @@ void BWRepDump::onStart()
 	fileLog.open("bwapi-data\\logs\\BWRepDump.log", std::ios_base::app); //append the output
 	LOG("[NEW REPLAY] " << Broodwar->mapPathName() << "," << Broodwar->mapHash());
 
-	if (CREATE_RLD) terrain = new TerrainAnalyzer;
-	if (CREATE_RGD) gameData = new GameData;
-	if (CREATE_ROD) orderData = new OrderData;
-	if (CREATE_RCD) combatTracker = new CombatTracker;
-	if (CREATE_ASD) actionSelection = new ActionSelection;
+	bwapiGame = new BWAPIGame;
+	extractors = new Extractors(bwapiGame);
 
 	showBullets = false;
 	showVisibilityData = false;
-	unitDestroyedThisTurn = false;
 }
 
 void BWRepDump::onEnd(bool isWinner)
 {
-	if (CREATE_RGD) delete gameData;
-	if (CREATE_RLD) delete terrain;
-	if (CREATE_ROD) delete orderData;
-	if (CREATE_RCD) delete combatTracker;
-	if (CREATE_ASD) delete actionSelection;
+	bwapiGame->update();
+	delete extractors;
+	delete bwapiGame;
 
 	fileLog.close();
 }
@@ -49,13 +43,8 @@ void BWRepDump::onFrame()
 	if (REPLAY_TIME_LIMIT && Broodwar->getFrameCount() > REPLAY_TIME_LIMIT)
 		Broodwar->leaveGame();
 
-	if (CREATE_RGD) gameData->onFrame();
-	if (CREATE_RCD) combatTracker->onFrame();
-	if (CREATE_RLD) terrain->onFrame();
-	if (CREATE_ROD) orderData->onFrame();
-	if (CREATE_ASD) actionSelection->onFrame();
-
-	unitDestroyedThisTurn = false;
+	bwapiGame->update();
+	extractors->onFrame();
 }
 
 void BWRepDump::onSendText(std::string text)
@@ -73,17 +62,20 @@ void BWRepDump::onSendText(std::string text)
 
 void BWRepDump::onReceiveText(BWAPI::Player player, std::string text)
 {
-	if (CREATE_RGD) gameData->onReceiveText(player, text);
+	bwapiGame->update();
+	extractors->onReceiveText(bwapiGame->getPlayer(player), text);
 }
 
 void BWRepDump::onPlayerLeft(BWAPI::Player player)
 {
-	if (CREATE_RGD) gameData->onPlayerLeft(player);
+	bwapiGame->update();
+	extractors->onPlayerLeft(bwapiGame->getPlayer(player));
 }
 
 void BWRepDump::onNukeDetect(BWAPI::Position target)
 {
-	if (CREATE_RGD) gameData->onNukeDetect(target);
+	bwapiGame->update();
+	extractors->onNukeDetect(target);
 }
 
 void BWRepDump::onUnitDiscover(BWAPI::Unit unit){}
@@ -93,27 +85,26 @@ void BWRepDump::onUnitHide(BWAPI::Unit unit){}
 
 void BWRepDump::onUnitCreate(BWAPI::Unit unit)
 {
-	if (CREATE_RLD) terrain->onUnitCreate(unit);
-	if (CREATE_RGD) gameData->onUnitCreate(unit);
-	if (CREATE_ASD) actionSelection->onUnitCreate(unit);
+	bwapiGame->update();
+	extractors->onUnitCreate(bwapiGame->getUnit(unit));
 }
 
 void BWRepDump::onUnitDestroy(BWAPI::Unit unit)
 {
-	unitDestroyedThisTurn = true;
-	if (CREATE_RGD) gameData->onUnitDestroy(unit);
-	if (CREATE_RCD) combatTracker->onUnitDestroy(unit);
-	if (CREATE_ASD) actionSelection->onUnitDestroy(unit);
+	bwapiGame->update();
+	extractors->onUnitDestroy(bwapiGame->getUnit(unit));
 }
 
 void BWRepDump::onUnitMorph(BWAPI::Unit unit)
 {
-	if (CREATE_RGD) gameData->onUnitMorph(unit);
+	bwapiGame->update();
+	extractors->onUnitMorph(bwapiGame->getUnit(unit));
 }
 
 void BWRepDump::onUnitRenegade(BWAPI::Unit unit)
 {
-	if (CREATE_RGD) gameData->onUnitRenegade(unit);
+	bwapiGame->update();
+	extractors->onUnitRenegade(bwapiGame->getUnit(unit));
 }
 
 void BWRepDump::drawStats()
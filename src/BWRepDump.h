@@ -1,11 +1,8 @@
 #pragma once
 
 #include "Utils.h"
-#include "GameData.h"
-#include "TerrainAnalyzer.h"
-#include "OrderData.h"
-#include "CombatTracker.h"
-#include "ActionSelection.h"
+#include "BWAPIGame.h"
+#include "Extractors.h"
 
 class BWRepDump : public BWAPI::AIModule
 {
@@ -26,9 +23,8 @@ public:
 	virtual void onUnitMorph(BWAPI::Unit unit);
 	virtual void onUnitRenegade(BWAPI::Unit unit);
 
-	GameData* gameData;
-	OrderData* orderData;
-	ActionSelection* actionSelection;
+	BWAPIGame* bwapiGame;
+	Extractors* extractors;
 
 	void drawStats(); //not part of BWAPI::AIModule
 	void drawBullets();
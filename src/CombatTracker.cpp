@@ -1,8 +1,10 @@
 #include "CombatTracker.h"
 
+#include "UnitIndex.h"
+
 using namespace BWAPI;
 
-bool isUnitAttacking(BWAPI::Unit unit)
+bool isUnitAttacking(Dump::Unit unit)
 {
 	return unit->getOrder() == Orders::AttackUnit || 
 		unit->getOrder() == Orders::Repair ||
@@ -10,7 +12,7 @@ bool isUnitAttacking(BWAPI::Unit unit)
 		unit->isAttacking();
 }
 
-bool isAggressiveUnit(BWAPI::Unit unit)
+bool isAggressiveUnit(Dump::Unit unit)
 {
 	return isUnitAttacking(unit)
 		|| unit->getType().isSpellcaster()
@@ -25,9 +27,9 @@ bool isAggressiveUnit(BWAPI::Unit unit)
 
 // BWAPI Unit->isUnderAttack cannot handle instakills 
 // returns true if a unit is in the weapon range of an enemy
-bool isExposed(BWAPI::Unit unit)
+bool isExposed(Dump::Unit unit)
 {
-	Unitset unitsNear = unit->getUnitsInRadius(ATTACK_RANGE);
+	Dump::Unitset unitsNear = unitIndex.getUnitsInRadius(unit, ATTACK_RANGE, unit->getPlayer());
 	for (auto unitNear : unitsNear) {
 		if (unitNear->getPlayer() != unit->getPlayer() && isAggressiveUnit(unitNear)) {
 			return true;
@@ -36,10 +38,10 @@ bool isExposed(BWAPI::Unit unit)
 	return false;
 }
 
-bool isUnderAttack(BWAPI::Unit unit)
+bool isUnderAttack(Dump::Unit unit)
 {
 	if (unit->isUnderAttack()) return true;
-	Unitset unitsNear = unit->getUnitsInRadius(ATTACK_RANGE);
+	Dump::Unitset unitsNear = unitIndex.getUnitsInRadius(unit, ATTACK_RANGE, unit->getPlayer());
 	for (auto unitNear : unitsNear) {
 		if (unitNear->getPlayer() != unit->getPlayer() && 
 			(unitNear->getOrderTarget() == unit || unitNear->getTarget() == unit 
@@ -57,17 +59,17 @@ bool isUnderAttack(BWAPI::Unit unit)
 
 void pauseGameAtPosition(BWAPI::Position position)
 {
-	Broodwar->setLocalSpeed(500);
-	Broodwar->setScreenPosition(position - Position(320, 240));
+	game->setLocalSpeed(500);
+	game->setScreenPosition(position - Position(320, 240));
 }
 
 CombatTracker::CombatTracker()
 {
-	std::string combatsfilepath = Broodwar->mapPathName() + ".rcd";
+	std::string combatsfilepath = game->mapPathName() + ".rcd";
 	replayCombatData.open(combatsfilepath.c_str());
 
 	// save replay/map analyzed
-	replayCombatData << Broodwar->mapPathName() << "," << Broodwar->mapHash().c_str() << '\n';
+	replayCombatData << game->mapPathName() << "," << game->mapHash().c_str() << '\n';
 }
 
 CombatTracker::~CombatTracker()
@@ -82,17 +84,17 @@ CombatTracker::~CombatTracker()
 void CombatTracker::onFrame()
 {
 	// check if units not in combat start a combat
-	for (auto unit : Broodwar->getAllUnits()) {
+	for (auto unit : game->getAllUnits()) {
 		// if a military unit is attacking or under attack and not already in a combat, we need to add it
 		if (isMilitaryUnit(unit) && (isAggressiveUnit(unit) || isExposed(unit))
 			&& unitsInCombat.find(unit) == unitsInCombat.end()) {
-			Unitset unitsNear = unit->getUnitsInRadius(ATTACK_RANGE);
-// 			Broodwar->drawCircleMap(unit->getPosition(), 5, Colors::Yellow, true);
-// 			Broodwar->drawCircleMap(unit->getPosition(), ATTACK_RANGE, Colors::Yellow);
+			Dump::Unitset unitsNear = unitIndex.getUnitsInRadius(unit, ATTACK_RANGE);
+// 			game->drawCircleMap(unit->getPosition(), 5, Colors::Yellow, true);
+// 			game->drawCircleMap(unit->getPosition(), ATTACK_RANGE, Colors::Yellow);
 			bool isReinforcement = false;
 			for (auto unitNear : unitsNear) {
 				if (!isMilitaryUnit(unitNear)) continue; // no relevant near unit
-				Broodwar->drawLineMap(unit->getPosition(), unitNear->getPosition(), Colors::Yellow);
+				game->drawLineMap(unit->getPosition(), unitNear->getPosition(), Colors::Yellow);
 				// if a near unit is already in combat, we consider it a reinforcement
 				if (unitsInCombat.find(unitNear) != unitsInCombat.end()) {
 					isReinforcement = true;
@@ -100,7 +102,7 @@ void CombatTracker::onFrame()
 					if (isAggressiveUnit(unit) || isUnderAttack(unit)) {
 						Combat* combatInProgress = getCombat(unitNear);
 						// if reinforcement is near start combat, add to combat
-						if (Broodwar->getFrameCount() - combatInProgress->firstFrame <= FRAMES_UNTIL_REINFORCEMENT) {
+						if (game->getFrameCount() - combatInProgress->firstFrame <= FRAMES_UNTIL_REINFORCEMENT) {
 							addToCombat(unit, combatInProgress);
 						} else { // otherwise end combat (REINFORCEMENTS) and start a new one next frame
 // 							pauseGameAtPosition(unit->getPosition());
@@ -153,39 +155,40 @@ void CombatTracker::onFrame()
 		} else {
 			// if no attack in SECONDS_SINCE_LAST_ATTACK_2, finish combat (PEACE)
 			if (combat->isAnyUnitAttacking()) {
-				combat->lastFrameAttacking = Broodwar->getFrameCount();
-			} else if (Broodwar->getFrameCount() - combat->lastFrameAttacking >= SECONDS_SINCE_LAST_ATTACK_2) {
+				combat->lastFrameAttacking = game->getFrameCount();
+			} else if (game->getFrameCount() - combat->lastFrameAttacking >= SECONDS_SINCE_LAST_ATTACK_2) {
 				endCombat(combat, "PEACE");
-// 				Broodwar->setLocalSpeed(100);
+// 				game->setLocalSpeed(100);
 			}
 		}
 	}
 
 	// Print debug data
-// 	Broodwar->drawTextScreen(5, 16, "Units in combat: %d", unitsInCombat.size());
+// 	game->drawTextScreen(5, 16, "Units in combat: %d", unitsInCombat.size());
 	for (auto unit : unitsInCombat) {
 		BWAPI::Color color = Colors::Green;
 		if (isAggressiveUnit(unit)) color = Colors::Red;
 		else if (isExposed(unit)) color = Colors::Orange;
-		Broodwar->drawCircleMap(unit->getPosition(), 5, color, true);
-		Broodwar->drawTextMap(unit->getPosition(), "%s", unit->getOrder().c_str());
-		Broodwar->drawTextMap(unit->getPosition(), "%s", unit->getOrder().c_str());
+		game->drawCircleMap(unit->getPosition(), 5, color, true);
+		game->drawTextMap(unit->getPosition(), unit->getOrder().getName());
+		game->drawTextMap(unit->getPosition(), unit->getOrder().getName());
 		if (unit->getAirWeaponCooldown() > 0 || unit->getGroundWeaponCooldown() > 0) {
-			Broodwar->drawTextMap(unit->getPosition() + Position(0, 15), "Cooldown");
+			game->drawTextMap(unit->getPosition() + Position(0, 15), "Cooldown");
 		}
 	}
 }
 
-void CombatTracker::startCombat(BWAPI::Unit newUnit)
+void CombatTracker::startCombat(Dump::Unit newUnit)
 {
+	PROFILE_SPAN("CombatTracker::startCombat");
 	// get all combat units near newUnit
-	Unitset unitsNear = newUnit->getUnitsInRadius(ATTACK_RANGE);
-	Unitset allUnitsNear;
+	Dump::Unitset unitsNear = unitIndex.getUnitsInRadius(newUnit, ATTACK_RANGE);
+	Dump::Unitset allUnitsNear;
 	allUnitsNear.insert(newUnit);
 	for (auto unitNear : unitsNear) {
 		if (!isMilitaryUnit(unitNear)) continue;
 		allUnitsNear.insert(unitNear);
-		Unitset unitsNear2 = unitNear->getUnitsInRadius(ATTACK_RANGE);
+		Dump::Unitset unitsNear2 = unitIndex.getUnitsInRadius(unitNear, ATTACK_RANGE);
 		// add to the list if it isn't already in
 		for (auto newNearUnit : unitsNear2) {
 			if (!isMilitaryUnit(newNearUnit)) continue;
@@ -203,14 +206,14 @@ void CombatTracker::startCombat(BWAPI::Unit newUnit)
 // 	Broodwar << "New combat" << std::endl;
 }
 
-void CombatTracker::addToCombat(BWAPI::Unit newUnit, Combat* combatToAdd)
+void CombatTracker::addToCombat(Dump::Unit newUnit, Combat* combatToAdd)
 {
 	combatToAdd->addUnit(newUnit);
 	unitsInCombat.insert(newUnit);
 }
 
 // search in what combat the unit belongs
-Combat* CombatTracker::getCombat(BWAPI::Unit unitInCombat)
+Combat* CombatTracker::getCombat(Dump::Unit unitInCombat)
 {
 	Combat* combatFind = nullptr;
 	for (auto combat : combats) {
@@ -222,7 +225,7 @@ Combat* CombatTracker::getCombat(BWAPI::Unit unitInCombat)
 	return combatFind;
 }
 
-void CombatTracker::onUnitDestroy(BWAPI::Unit unit)
+void CombatTracker::onUnitDestroy(Dump::Unit unit)
 {
 // 	if (!unit->getLastAttackingPlayer()) return;
 	if (!unit->isCompleted()) return;		// Some units are destroyed because player canceled training
@@ -233,7 +236,7 @@ void CombatTracker::onUnitDestroy(BWAPI::Unit unit)
 	if (isMilitaryUnit(unit)) {
 		Combat* combat = getCombat(unit);
 		if (combat != nullptr) {
-			combat->unitsKilled.push_back(KilledInfo(unit, Broodwar->getFrameCount(), unit->isLoaded()));
+			combat->unitsKilled.push_back(KilledInfo(unit, game->getFrameCount(), unit->isLoaded()));
 		} else {
 			// sometimes players destroy their own mines
 			//if (unit->getType() == UnitTypes::Terran_Vulture_Spider_Mine) return;
@@ -247,7 +250,7 @@ void CombatTracker::onUnitDestroy(BWAPI::Unit unit)
 			std::ostringstream buffer;
 			buffer << "[ERROR] Destroyed military " << unit->getType().getName() << " Order: " << unit->getOrder().c_str() << " PlayerID: " << unit->getPlayer()->getID();
 			
-			Unitset unitsNear = Broodwar->getUnitsInRadius(unit->getPosition(), ATTACK_RANGE);
+			Dump::Unitset unitsNear = unitIndex.getUnitsInRadius(unit->getPosition(), ATTACK_RANGE);
 			for (auto unitNear : unitsNear) {
 				if (unitNear->getOrderTarget() == unit || unitNear->getTarget() == unit) {
 					if (unitNear->getPlayer() != unit->getPlayer()) {
@@ -264,7 +267,7 @@ void CombatTracker::onUnitDestroy(BWAPI::Unit unit)
 			}
 			if (isError) {
 // 				pauseGameAtPosition(unit->getPosition());
-				Broodwar << buffer.str(); Broodwar.flush();
+				game->printText(buffer.str());
 				DEBUG(buffer.str());
 			}
 		}
@@ -279,8 +282,10 @@ void CombatTracker::onUnitDestroy(BWAPI::Unit unit)
 		if (unit->getType() == UnitTypes::Protoss_Observer) return; // observers are "harmless" units
 
 // 		pauseGameAtPosition(unit->getPosition());
-		Broodwar << "[NOTICE] Destroyed not military " << unit->getType().getName() << " Order: " << unit->getOrder().c_str() << " PlayerID: " << unit->getPlayer()->getID() << std::endl;
-		LOG("[NOTICE] Destroyed not military " << unit->getType().getName() << " Order: " << unit->getOrder() << " PlayerID: " << unit->getPlayer()->getID());
+		std::ostringstream buffer;
+		buffer << "[NOTICE] Destroyed not military " << unit->getType().getName() << " Order: " << unit->getOrder().c_str() << " PlayerID: " << unit->getPlayer()->getID();
+		game->printText(buffer.str());
+		LOG(buffer.str());
 	}
 }
 
@@ -296,7 +301,7 @@ void CombatTracker::endCombat(Combat* combatToEnd, std::string condition)
 
 		// print combat
 		// General info [frame_start, frame_end, end_condition]
-		replayCombatData << "NEW_COMBAT," << combatToEnd->firstFrame << "," << Broodwar->getFrameCount() << "," << condition << '\n';
+		replayCombatData << "NEW_COMBAT," << combatToEnd->firstFrame << "," << game->getFrameCount() << "," << condition << '\n';
 		// upgrades
 		std::string upgradesReserached;
 		for (auto playerUnits : combatToEnd->battleUnits) {
@@ -392,7 +397,6 @@ void CombatTracker::endCombat(Combat* combatToEnd, std::string condition)
 			replayCombatData << bufferString << '\n';
 		}
 
-		replayCombatData.flush();
 		// delete combat
 		combats.erase(combatToEnd);
 		delete combatToEnd;
@@ -401,14 +405,14 @@ void CombatTracker::endCombat(Combat* combatToEnd, std::string condition)
 	}
 }
 
-Combat::Combat(BWAPI::Unitset unitsInCombat)
+Combat::Combat(Dump::Unitset unitsInCombat)
 {
 	for (auto unit : unitsInCombat) {
 		UnitInfo* unitInfo = new UnitInfo(unit);
 		battleUnits[unit->getPlayer()].insert(unitInfo);
 	}
-	firstFrame = Broodwar->getFrameCount();
-	lastFrameAttacking = Broodwar->getFrameCount();
+	firstFrame = game->getFrameCount();
+	lastFrameAttacking = game->getFrameCount();
 }
 
 Combat::~Combat()
@@ -421,13 +425,13 @@ Combat::~Combat()
 // 	}
 }
 
-void Combat::addUnit(BWAPI::Unit newUnit)
+void Combat::addUnit(Dump::Unit newUnit)
 {
 	UnitInfo* unitInfo = new UnitInfo(newUnit);
 	battleUnits[newUnit->getPlayer()].insert(unitInfo);
 }
 
-bool Combat::isUnitInCombat(BWAPI::Unit unit)
+bool Combat::isUnitInCombat(Dump::Unit unit)
 {
 	for (auto playerUnits : battleUnits) {
 		for (auto combatUnit : playerUnits.second) {
@@ -4,7 +4,7 @@
 
 struct UnitInfo
 {
-	BWAPI::Unit unit;
+	Dump::Unit unit;
 	int unitID;
 	BWAPI::UnitType unitType;
 	BWAPI::TilePosition initialTilePosition;
@@ -12,7 +12,7 @@ struct UnitInfo
 	int initialShields;
 	int initialEnergy;
 
-	UnitInfo(BWAPI::Unit bwapiUnit)
+	UnitInfo(Dump::Unit bwapiUnit)
 		:unit(bwapiUnit), unitID(bwapiUnit->getID()), unitType(bwapiUnit->getType()),
 		initialTilePosition(bwapiUnit->getTilePosition()),
 		initialHP(bwapiUnit->getHitPoints()), initialShields(bwapiUnit->getShields()),
@@ -20,26 +20,26 @@ struct UnitInfo
 };
 
 struct KilledInfo {
-	BWAPI::Unit unit;
+	Dump::Unit unit;
 	int frameKilled;
 	bool isLoaded;
 
-	KilledInfo(BWAPI::Unit unit, int frame, bool isLoaded) :unit(unit), frameKilled(frame), isLoaded(isLoaded){}
+	KilledInfo(Dump::Unit unit, int frame, bool isLoaded) :unit(unit), frameKilled(frame), isLoaded(isLoaded){}
 };
 
 class Combat
 {
 public:
-	std::map< BWAPI::Player, std::set<UnitInfo*> > battleUnits;
+	std::map<Dump::Player, std::set<UnitInfo*>, Dump::ByID> battleUnits;
 	int firstFrame;
 	int lastFrameAttacking;
 	std::vector<KilledInfo> unitsKilled;
 	std::map<UnitInfo*, bool> unitParticipatedInCombat;
 
-	Combat(BWAPI::Unitset unitsInCombat);
+	Combat(Dump::Unitset unitsInCombat);
 	~Combat();
-	void addUnit(BWAPI::Unit newUnit);
-	bool isUnitInCombat(BWAPI::Unit unit);
+	void addUnit(Dump::Unit newUnit);
+	bool isUnitInCombat(Dump::Unit unit);
 	bool isArmyDestroyed();
 	bool isAnyUnitAttacking();
 
@@ -51,20 +51,20 @@ class CombatTracker
 {
 public:
 	std::set<Combat*> combats;
-	std::set<BWAPI::Unit> unitsInCombat;
+	Dump::Unitset unitsInCombat;
 
 	CombatTracker();
 	~CombatTracker();
 	void onFrame();
-	void onUnitDestroy(BWAPI::Unit unit);
-	void startCombat(BWAPI::Unit newUnit);
+	void onUnitDestroy(Dump::Unit unit);
+	void startCombat(Dump::Unit newUnit);
 	void endCombat(Combat* combatToEnd, std::string condition);
 
 private:
-	std::ofstream replayCombatData;
+	AsyncOutputFile replayCombatData;
 
-	Combat* getCombat(BWAPI::Unit unitInCombat);
-	void addToCombat(BWAPI::Unit newUnit, Combat* combatToAdd);
+	Combat* getCombat(Dump::Unit unitInCombat);
+	void addToCombat(Dump::Unit newUnit, Combat* combatToAdd);
 };
 
 
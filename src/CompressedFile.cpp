@@ -0,0 +1,237 @@
+#include "CompressedFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "LZ4Block.h"
+
+// ====================================================================================
+// Dictionaries
+// ====================================================================================
+
+uint32_t Compressed::dictionaryId(const std::string& dictionary)
+{
+	if (dictionary.empty()) return 0;
+	uint32_t hash = 2166136261u;
+	for (const auto& c : dictionary) hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+	return hash == 0 ? 1 : hash;
+}
+
+std::string Compressed::loadDictionary(const std::string& path)
+{
+	std::ifstream in(path.c_str(), std::ios::binary);
+	if (!in) return std::string();
+	std::ostringstream content;
+	content << in.rdbuf();
+	std::string dictionary = content.str();
+	if (dictionary.size() > LZ4Block::MAX_DICTIONARY) dictionary.erase(0, dictionary.size() - LZ4Block::MAX_DICTIONARY);
+	return dictionary;
+}
+
+std::string Compressed::trainDictionary(const std::vector<std::string>& samples, size_t size)
+{
+	// Greedy cover of the frequent 8 bytes fragments: the lines whose fragments (not yet in the
+	// dictionary) are the most frequent in the samples are added first
+	const size_t K = 8;
+	std::unordered_map<std::string, size_t> fragments;
+	std::unordered_map<std::string, size_t> lines;
+	for (const auto& sample : samples) {
+		std::istringstream in(sample);
+		std::string line;
+		while (std::getline(in, line)) {
+			line += '\n';
+			if (line.size() < K) continue;
+			lines[line]++;
+			for (size_t i = 0; i + K <= line.size(); ++i) fragments[line.substr(i, K)]++;
+		}
+	}
+
+	auto score = [&](const std::string& line) {
+		std::unordered_set<std::string> seen;
+		size_t total = 0;
+		for (size_t i = 0; i + K <= line.size(); ++i) {
+			std::string fragment = line.substr(i, K);
+			if (seen.insert(fragment).second) total += fragments[fragment];
+		}
+		return total;
+	};
+
+	// lazy greedy: a score only decreases, so a line whose updated score is still the best is taken
+	std::priority_queue<std::pair<size_t, std::string> > candidates;
+	for (const auto& line : lines) candidates.push(std::make_pair(score(line.first), line.first));
+	std::vector<std::string> picked;
+	size_t dictionarySize = 0;
+	while (!candidates.empty() && dictionarySize < size) {
+		std::pair<size_t, std::string> best = candidates.top();
+		candidates.pop();
+		size_t updated = score(best.second);
+		if (updated == 0) break;
+		if (!candidates.empty() && updated < candidates.top().first) {
+			candidates.push(std::make_pair(updated, best.second));
+			continue;
+		}
+		picked.push_back(best.second);
+		dictionarySize += best.second.size();
+		for (size_t i = 0; i + K <= best.second.size(); ++i) fragments[best.second.substr(i, K)] = 0;
+	}
+
+	// the closest history is the cheapest to reference, the best lines go at the end
+	std::string dictionary;
+	for (auto it = picked.rbegin(); it != picked.rend(); ++it) dictionary += *it;
+	if (dictionary.size() > size) dictionary.erase(0, dictionary.size() - size);
+	return dictionary;
+}
+
+// ====================================================================================
+// CompressedOutputFile
+// ====================================================================================
+
+void CompressedOutputFile::BlockBuffer::reset()
+{
+	if (raw.size() < Compressed::BLOCK_SIZE * 2) raw.resize(Compressed::BLOCK_SIZE * 2);
+	setp(raw.data(), raw.data() + raw.size());
+}
+
+CompressedOutputFile::BlockBuffer::int_type CompressedOutputFile::BlockBuffer::overflow(int_type c)
+{
+	// a frame wrote more than a block, grow instead of cutting in the middle of the frame
+	size_t used = size();
+	raw.resize(raw.size() * 2);
+	setp(raw.data(), raw.data() + raw.size());
+	pbump(static_cast<int>(used));
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+CompressedOutputFile::CompressedOutputFile()
+	: std::ostream(nullptr), compressed(false), offset(0), firstFrame(-1), lastFrame(-1)
+{
+}
+
+void CompressedOutputFile::open(const std::string& path, bool compressed, const std::string& dictionary)
+{
+	this->compressed = compressed;
+	this->dictionary = dictionary;
+	file.open(path, compressed ? std::ios_base::out | std::ios_base::binary : std::ios_base::out);
+	if (!file.is_open()) {
+		setstate(std::ios_base::failbit);
+		return;
+	}
+	if (!compressed) {
+		rdbuf(file.rdbuf()); // straight to the file
+		return;
+	}
+
+	Compressed::FileHeader header = { Compressed::MAGIC, Compressed::VERSION, Compressed::dictionaryId(dictionary), 0 };
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	offset = sizeof(header);
+	index.clear();
+	firstFrame = lastFrame = -1;
+	buffer.reset();
+	rdbuf(&buffer);
+}
+
+void CompressedOutputFile::close()
+{
+	if (!file.is_open()) return;
+	if (compressed) {
+		writeBlock();
+		Compressed::Footer footer = { offset, static_cast<uint32_t>(index.size()), Compressed::MAGIC };
+		if (!index.empty()) file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Compressed::IndexEntry));
+		file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+		std::vector<char>().swap(buffer.raw);
+	}
+	rdbuf(nullptr);
+	file.close();
+}
+
+void CompressedOutputFile::beginFrame(int frame)
+{
+	if (!compressed) return;
+	if (buffer.size() >= Compressed::BLOCK_SIZE) writeBlock();
+	if (buffer.size() == 0) firstFrame = frame;
+	lastFrame = frame;
+}
+
+void CompressedOutputFile::writeBlock()
+{
+	size_t rawSize = buffer.size();
+	if (rawSize == 0) return;
+	compressedBlock.resize(LZ4Block::compressBound(rawSize));
+	size_t compressedSize = LZ4Block::compress(buffer.raw.data(), rawSize, compressedBlock.data(), dictionary.data(), dictionary.size());
+	const char* data = compressedBlock.data();
+	if (compressedSize >= rawSize) { // stored
+		compressedSize = rawSize;
+		data = buffer.raw.data();
+	}
+
+	Compressed::BlockHeader header = { static_cast<uint32_t>(rawSize), static_cast<uint32_t>(compressedSize) };
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(data, compressedSize);
+	Compressed::IndexEntry entry = { firstFrame, lastFrame, offset, header.rawSize, header.compressedSize };
+	index.push_back(entry);
+	offset += sizeof(header) + compressedSize;
+	buffer.reset();
+	firstFrame = lastFrame;
+}
+
+// ====================================================================================
+// CompressedFileReader
+// ====================================================================================
+
+CompressedFileReader::CompressedFileReader(const std::string& path, const std::string& dictionary)
+	: dictionary(dictionary)
+{
+	file.open(path);
+	if (!file.is_open()) throw std::runtime_error("cannot open " + path);
+	if (file.size() < sizeof(Compressed::FileHeader) + sizeof(Compressed::Footer)) throw std::runtime_error("not a compressed file (too small)");
+	const Compressed::FileHeader* header = reinterpret_cast<const Compressed::FileHeader*>(file.data());
+	if (header->magic != Compressed::MAGIC || header->version != Compressed::VERSION) throw std::runtime_error("not a compressed file (bad magic or version)");
+	if (header->dictionary != Compressed::dictionaryId(dictionary)) {
+		throw std::runtime_error(header->dictionary == 0 ? "compressed without dictionary" : "compressed with another dictionary");
+	}
+
+	// the index and footer follow the blocks, they are not aligned
+	Compressed::Footer footer;
+	memcpy(&footer, file.data() + file.size() - sizeof(footer), sizeof(footer));
+	if (footer.magic != Compressed::MAGIC
+		|| footer.indexOffset + footer.blocks * sizeof(Compressed::IndexEntry) + sizeof(footer) != file.size())
+	{
+		throw std::runtime_error("truncated compressed file (no index)");
+	}
+	index.resize(footer.blocks);
+	if (!index.empty()) memcpy(index.data(), file.data() + footer.indexOffset, index.size() * sizeof(Compressed::IndexEntry));
+	for (const auto& entry : index) {
+		if (entry.offset + sizeof(Compressed::BlockHeader) + entry.compressedSize > footer.indexOffset) {
+			throw std::runtime_error("compressed block out of bounds");
+		}
+	}
+}
+
+std::string CompressedFileReader::readBlock(size_t i) const
+{
+	const Compressed::IndexEntry& entry = index.at(i);
+	const char* data = file.data() + entry.offset + sizeof(Compressed::BlockHeader);
+	if (entry.compressedSize == entry.rawSize) return std::string(data, entry.rawSize);
+	std::string text(entry.rawSize, '\0');
+	LZ4Block::decompress(data, entry.compressedSize, &text[0], entry.rawSize, dictionary.data(), dictionary.size());
+	return text;
+}
+
+std::string CompressedFileReader::read(int firstFrame, int lastFrame) const
+{
+	std::string text;
+	for (size_t i = 0; i < index.size(); ++i) {
+		if (index[i].lastFrame >= firstFrame && index[i].firstFrame <= lastFrame) text += readBlock(i);
+	}
+	return text;
+}
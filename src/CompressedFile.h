@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "boost/iostreams/device/mapped_file.hpp"
+
+#include "AsyncWriter.h"
+
+// Compressed text output (see COMPRESS_ROD_RLD): the text is cut in blocks of about BLOCK_SIZE bytes,
+// only between two frames, each block is compressed on its own (LZ4Block, with an optional
+// dictionary trained on previous outputs) and a block index at the end gives the frame range of each
+// block, so a frame range is read back without decompressing the whole file (CompressedFileReader).
+// Little endian:
+//   Compressed::FileHeader
+//   { Compressed::BlockHeader, compressed bytes (or raw if compressedSize == rawSize) }
+//   Compressed::IndexEntry[blocks]
+//   Compressed::Footer
+namespace Compressed
+{
+	const uint32_t MAGIC = 0x5A4C5742; // "BWLZ"
+	const uint32_t VERSION = 1;
+	const size_t BLOCK_SIZE = 1 << 18;
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t dictionary; // dictionaryId() of the dictionary needed to decompress, 0 if none
+		uint32_t reserved;
+	};
+
+	struct BlockHeader
+	{
+		uint32_t rawSize;
+		uint32_t compressedSize;
+	};
+
+	struct IndexEntry
+	{
+		int32_t firstFrame; // -1 for what was written before the first frame (RLD distances)
+		int32_t lastFrame;
+		uint64_t offset;    // of the BlockHeader
+		uint32_t rawSize;
+		uint32_t compressedSize;
+	};
+
+	struct Footer
+	{
+		uint64_t indexOffset;
+		uint32_t blocks;
+		uint32_t magic;
+	};
+
+	uint32_t dictionaryId(const std::string& dictionary);
+	// reads COMPRESSION_DICTIONARY, empty if there is none
+	std::string loadDictionary(const std::string& path);
+	// picks the most frequent line fragments of the samples (previous ROD/RLD outputs)
+	std::string trainDictionary(const std::vector<std::string>& samples, size_t size);
+}
+
+class CompressedOutputFile : public std::ostream
+{
+public:
+	CompressedOutputFile();
+	~CompressedOutputFile() { close(); }
+
+	// plain text if !compressed
+	void open(const std::string& path, bool compressed, const std::string& dictionary = std::string());
+	bool is_open() const { return file.is_open(); }
+	void close();
+	// the lines written after this call belong to this frame
+	void beginFrame(int frame);
+
+private:
+	class BlockBuffer : public std::streambuf
+	{
+	public:
+		std::vector<char> raw;
+		void reset();
+		size_t size() const { return pptr() - pbase(); }
+	protected:
+		virtual int_type overflow(int_type c);
+	};
+
+	AsyncOutputFile file;
+	bool compressed;
+	BlockBuffer buffer;
+	std::string dictionary;
+	std::vector<char> compressedBlock;
+	std::vector<Compressed::IndexEntry> index;
+	uint64_t offset;
+	int firstFrame;
+	int lastFrame;
+
+	void writeBlock();
+};
+
+class CompressedFileReader
+{
+public:
+	// throws std::runtime_error if the file is not valid or the dictionary is not the right one
+	CompressedFileReader(const std::string& path, const std::string& dictionary = std::string());
+	const std::vector<Compressed::IndexEntry>& getIndex() const { return index; }
+	std::string readBlock(size_t i) const;
+	// text of the blocks overlapping [firstFrame, lastFrame], so it can start before and end after
+	std::string read(int firstFrame, int lastFrame) const;
+
+private:
+	boost::iostreams::mapped_file_source file;
+	std::string dictionary;
+	std::vector<Compressed::IndexEntry> index;
+};
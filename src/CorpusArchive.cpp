@@ -0,0 +1,306 @@
+#include "CorpusArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+#include "boost/filesystem.hpp"
+#include "boost/interprocess/sync/file_lock.hpp"
+
+#include "Utils.h"
+
+// ====================================================================================
+// Archive file
+// ====================================================================================
+
+namespace
+{
+	bool validTrailer(const Corpus::Trailer& trailer, uint64_t trailerOffset)
+	{
+		return trailer.magic == Corpus::MAGIC
+			&& (trailer.kind == Corpus::ReplayIndex || trailer.kind == Corpus::FullIndex)
+			&& trailer.previous < trailerOffset && trailer.index >= sizeof(Corpus::FileHeader)
+			&& trailer.index + uint64_t(trailer.entries) * sizeof(Corpus::ReplayEntry) <= trailerOffset;
+	}
+
+	// end of the last valid trailer, sizeof(FileHeader) if there is none
+	uint64_t validEnd(const char* data, uint64_t size)
+	{
+		Corpus::Trailer trailer;
+		for (uint64_t end = size; end >= sizeof(Corpus::FileHeader) + sizeof(trailer); --end) {
+			memcpy(&trailer, data + end - sizeof(trailer), sizeof(trailer));
+			if (validTrailer(trailer, end - sizeof(trailer))) return end;
+		}
+		return sizeof(Corpus::FileHeader);
+	}
+
+	// the archive opened for appending, with the lock of its writer
+	struct AppendFile
+	{
+		boost::interprocess::file_lock lock;
+		std::fstream archive;
+		uint64_t lastTrailer; // 0 if none
+		uint32_t unindexed;   // ReplayIndex trailers after the last FullIndex
+		uint32_t indexed;     // entries of the last FullIndex
+	};
+
+	// opens the archive for appending (created if needed) once the other writers are done with it,
+	// cuts a partial tail left by a crash
+	void openForAppend(const std::string& archivePath, AppendFile& out)
+	{
+		// $archivePath.lock and not the archive, the locks of Windows would also stop our own writes
+		std::string lockPath = archivePath + ".lock";
+		std::ofstream(lockPath.c_str(), std::ios::binary | std::ios::app);
+		try {
+			out.lock = boost::interprocess::file_lock(lockPath.c_str());
+			out.lock.lock();
+		} catch (const boost::interprocess::interprocess_exception& e) {
+			throw std::runtime_error("cannot lock " + lockPath + ": " + e.what());
+		}
+
+		if (!boost::filesystem::exists(archivePath)) {
+			std::ofstream create(archivePath.c_str(), std::ios::binary);
+			Corpus::FileHeader header = { Corpus::MAGIC, Corpus::VERSION };
+			create.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			if (!create) throw std::runtime_error("cannot create " + archivePath);
+		}
+		uint64_t size, end;
+		out.unindexed = out.indexed = 0;
+		{
+			boost::iostreams::mapped_file_source file(archivePath);
+			Corpus::FileHeader header;
+			if (file.size() < sizeof(header)) throw std::runtime_error(archivePath + " is not a corpus archive");
+			memcpy(&header, file.data(), sizeof(header));
+			if (header.magic != Corpus::MAGIC || header.version != Corpus::VERSION) {
+				throw std::runtime_error(archivePath + " is not a corpus archive");
+			}
+			size = file.size();
+			end = validEnd(file.data(), size);
+			out.lastTrailer = end == sizeof(Corpus::FileHeader) ? 0 : end - sizeof(Corpus::Trailer);
+			for (uint64_t offset = out.lastTrailer; offset != 0;) {
+				Corpus::Trailer trailer;
+				memcpy(&trailer, file.data() + offset, sizeof(trailer));
+				if (!validTrailer(trailer, offset)) throw std::runtime_error(archivePath + ": corrupted index");
+				if (trailer.kind == Corpus::FullIndex) {
+					out.indexed = trailer.entries;
+					break;
+				}
+				++out.unindexed;
+				offset = trailer.previous;
+			}
+		}
+		if (end != size) {
+			LOG("[CORPUS] cutting " << size - end << " bytes of partial data at the end of " << archivePath);
+			boost::filesystem::resize_file(archivePath, end);
+		}
+		out.archive.open(archivePath.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+		if (!out.archive) throw std::runtime_error("cannot open " + archivePath);
+		out.archive.seekp(end);
+	}
+
+	void appendEntry(std::string& out, const CorpusReader::Replay& replay)
+	{
+		Corpus::ReplayEntry entry = {};
+		entry.hash = replay.hash;
+		entry.frames = replay.frames;
+		strncpy(entry.matchup, replay.matchup.c_str(), sizeof(entry.matchup) - 1);
+		entry.streams = static_cast<uint32_t>(replay.streams.size());
+		entry.pathLength = static_cast<uint32_t>(replay.path.size());
+		out.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+		for (const auto& s : replay.streams) {
+			Corpus::StreamEntry stream = {};
+			strncpy(stream.name, s.name.c_str(), sizeof(stream.name) - 1);
+			stream.offset = s.offset;
+			stream.size = s.size;
+			out.append(reinterpret_cast<const char*>(&stream), sizeof(stream));
+		}
+		out.append(replay.path);
+	}
+
+	void appendIndex(std::fstream& archive, uint64_t previousTrailer, const std::vector<CorpusReader::Replay>& replays,
+		Corpus::TrailerKind kind, std::string& out)
+	{
+		uint64_t start = static_cast<uint64_t>(archive.tellp());
+		Corpus::Trailer trailer = { previousTrailer, start + out.size(), static_cast<uint32_t>(replays.size()), kind, Corpus::MAGIC, 0 };
+		for (const auto& replay : replays) appendEntry(out, replay);
+		out.append(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+		archive.write(out.data(), out.size()); // a single write, a crash can only leave a partial tail
+		archive.flush();
+		if (!archive) throw std::runtime_error("cannot write the corpus archive");
+	}
+}
+
+uint64_t Corpus::replayHash(const std::string& replayPath)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (const auto& c : replayPath) hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+	return hash;
+}
+
+void Corpus::appendReplay(const std::string& archivePath, const std::string& replayPath, const std::string& matchup,
+	int frames, const Streams& streams)
+{
+	AppendFile file;
+	openForAppend(archivePath, file);
+	uint64_t offset = static_cast<uint64_t>(file.archive.tellp());
+
+	CorpusReader::Replay replay = { replayHash(replayPath), replayPath, matchup, frames, {} };
+	std::string out;
+	for (const auto& s : streams) {
+		CorpusReader::Stream stream = { s.first, offset + out.size(), s.second.size() };
+		replay.streams.push_back(stream);
+		out += s.second;
+	}
+	// the index of the archive is refreshed once the chain of trailers to read is too long,
+	// after FULL_INDEX_EVERY replays or a quarter of the archive so that the indexes stay small
+	if (file.unindexed + 1 >= std::max(FULL_INDEX_EVERY, file.indexed / 4)) {
+		std::vector<CorpusReader::Replay> replays = CorpusReader(archivePath).getReplays();
+		replays.push_back(replay);
+		appendIndex(file.archive, file.lastTrailer, replays, FullIndex, out);
+	} else {
+		appendIndex(file.archive, file.lastTrailer, std::vector<CorpusReader::Replay>(1, replay), ReplayIndex, out);
+	}
+}
+
+void Corpus::appendFullIndex(const std::string& archivePath)
+{
+	AppendFile file;
+	openForAppend(archivePath, file);
+	if (file.unindexed == 0 && file.lastTrailer != 0) return; // the last trailer is already a full index
+	std::vector<CorpusReader::Replay> replays = CorpusReader(archivePath).getReplays();
+	std::string out;
+	appendIndex(file.archive, file.lastTrailer, replays, FullIndex, out);
+}
+
+// ====================================================================================
+// Capture of the current replay streams
+// ====================================================================================
+
+namespace
+{
+	std::mutex captureMutex;
+	bool replayStarted = false;
+	std::string currentReplay;
+	std::string currentMatchup;
+	Corpus::Streams currentStreams;
+}
+
+bool Corpus::capturing()
+{
+	std::lock_guard<std::mutex> lock(captureMutex);
+	return replayStarted;
+}
+
+void Corpus::beginReplay(const std::string& replayPath, const std::string& matchup)
+{
+	if (CORPUS_ARCHIVE.empty()) return;
+	std::lock_guard<std::mutex> lock(captureMutex);
+	replayStarted = true;
+	currentReplay = replayPath;
+	currentMatchup = matchup;
+	currentStreams.clear();
+}
+
+void Corpus::addStream(const std::string& path, std::string& data)
+{
+	std::lock_guard<std::mutex> lock(captureMutex);
+	std::string name = path.compare(0, currentReplay.size(), currentReplay) == 0 ? path.substr(currentReplay.size()) : path;
+	currentStreams.push_back(std::make_pair(name, std::string()));
+	currentStreams.back().second.swap(data);
+}
+
+void Corpus::commitReplay(int frames)
+{
+	Streams streams;
+	{
+		std::lock_guard<std::mutex> lock(captureMutex);
+		if (!replayStarted) return;
+		replayStarted = false;
+		streams.swap(currentStreams);
+	}
+	try {
+		appendReplay(CORPUS_ARCHIVE, currentReplay, currentMatchup, frames, streams);
+	} catch (const std::exception& e) {
+		LOG("[CORPUS] " << currentReplay << " not archived: " << e.what());
+	}
+}
+
+// ====================================================================================
+// CorpusReader
+// ====================================================================================
+
+CorpusReader::CorpusReader(const std::string& archivePath)
+{
+	file.open(archivePath);
+	if (!file.is_open()) throw std::runtime_error("cannot open " + archivePath);
+	Corpus::FileHeader header;
+	if (file.size() < sizeof(header)) throw std::runtime_error(archivePath + " is not a corpus archive");
+	memcpy(&header, file.data(), sizeof(header));
+	if (header.magic != Corpus::MAGIC || header.version != Corpus::VERSION) throw std::runtime_error(archivePath + " is not a corpus archive");
+
+	// last valid trailer, skipping a replay being appended (or a partial tail left by a crash)
+	uint64_t end = validEnd(file.data(), file.size());
+	if (end == sizeof(header)) return;
+
+	// from the last trailer back to a full index (or the first trailer)
+	std::vector<std::vector<Replay> > segments;
+	uint64_t trailerOffset = end - sizeof(Corpus::Trailer);
+	for (;;) {
+		Corpus::Trailer trailer;
+		memcpy(&trailer, file.data() + trailerOffset, sizeof(trailer));
+		if (!validTrailer(trailer, trailerOffset)) throw std::runtime_error(archivePath + ": corrupted index");
+
+		segments.push_back(std::vector<Replay>());
+		uint64_t offset = trailer.index;
+		for (uint32_t i = 0; i < trailer.entries; ++i) {
+			Corpus::ReplayEntry entry;
+			if (offset + sizeof(entry) > trailerOffset) throw std::runtime_error(archivePath + ": corrupted index");
+			memcpy(&entry, file.data() + offset, sizeof(entry));
+			offset += sizeof(entry);
+			if (offset + entry.streams * sizeof(Corpus::StreamEntry) + entry.pathLength > trailerOffset) {
+				throw std::runtime_error(archivePath + ": corrupted index");
+			}
+			Replay replay;
+			replay.hash = entry.hash;
+			replay.frames = entry.frames;
+			replay.matchup = std::string(entry.matchup, strnlen(entry.matchup, sizeof(entry.matchup)));
+			for (uint32_t s = 0; s < entry.streams; ++s) {
+				Corpus::StreamEntry streamEntry;
+				memcpy(&streamEntry, file.data() + offset, sizeof(streamEntry));
+				offset += sizeof(streamEntry);
+				Stream stream = { std::string(streamEntry.name, strnlen(streamEntry.name, sizeof(streamEntry.name))), streamEntry.offset, streamEntry.size };
+				if (stream.offset + stream.size > trailerOffset) throw std::runtime_error(archivePath + ": corrupted index");
+				replay.streams.push_back(stream);
+			}
+			replay.path.assign(file.data() + offset, entry.pathLength);
+			offset += entry.pathLength;
+			segments.back().push_back(replay);
+		}
+		if (trailer.kind == Corpus::FullIndex || trailer.previous == 0) break;
+		trailerOffset = trailer.previous;
+	}
+	for (auto it = segments.rbegin(); it != segments.rend(); ++it) replays.insert(replays.end(), it->begin(), it->end());
+}
+
+const CorpusReader::Replay* CorpusReader::find(const std::string& replayPath) const
+{
+	uint64_t hash = Corpus::replayHash(replayPath);
+	for (auto it = replays.rbegin(); it != replays.rend(); ++it) { // the last one if it was extracted again
+		if (it->hash == hash && it->path == replayPath) return &*it;
+	}
+	return nullptr;
+}
+
+const char* CorpusReader::stream(const Replay& replay, const std::string& name, size_t& size) const
+{
+	for (const auto& s : replay.streams) {
+		if (s.name == name) {
+			size = static_cast<size_t>(s.size);
+			return file.data() + s.offset;
+		}
+	}
+	size = 0;
+	return nullptr;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "boost/iostreams/device/mapped_file.hpp"
+
+// Append-only archive of the outputs of many replays (see CORPUS_ARCHIVE), instead of 5 loose
+// files per replay. While a replay is extracted its streams (.rgd, .rod, ...) are kept in memory
+// (AsyncOutputFile), then appended in one write with the index entry of the replay (hash, matchup,
+// length, offset and size of each stream). Little endian:
+//   Corpus::FileHeader
+//   { streams of a replay, its Corpus::ReplayEntry, Corpus::Trailer }
+// Each trailer points to the previous one. A FullIndex trailer has all the entries, so that opening
+// the archive reads a single index: it is written at the end of `bwrepdump_corpus add` and when the
+// trailers after the last FullIndex get too many (see appendReplay).
+// The writers take a lock ($archivePath.lock), a crash while appending leaves a partial tail, it is
+// cut at the next open.
+namespace Corpus
+{
+	const uint32_t MAGIC = 0x41435742; // "BWCA"
+	const uint32_t VERSION = 1;
+	const uint32_t FULL_INDEX_EVERY = 64; // ReplayIndex trailers at most between two FullIndex, in a small archive
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+	};
+
+	struct StreamEntry
+	{
+		char name[8];    // extension, ".rgd", ".rodz", ...
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// followed by StreamEntry[streams] and pathLength chars
+	struct ReplayEntry
+	{
+		uint64_t hash;   // replayHash(path)
+		int32_t frames;
+		char matchup[12]; // "PvT", "PvZvT", ...
+		uint32_t streams;
+		uint32_t pathLength;
+	};
+
+	enum TrailerKind : uint32_t {
+		ReplayIndex = 1, // entries of the replay just appended
+		FullIndex        // every entry of the archive, the older trailers do not need to be read
+	};
+
+	struct Trailer
+	{
+		uint64_t previous; // offset of the previous trailer, 0 if none
+		uint64_t index;    // offset of the first ReplayEntry
+		uint32_t entries;
+		uint32_t kind;
+		uint32_t magic;
+		uint32_t reserved;
+	};
+
+	typedef std::vector<std::pair<std::string, std::string> > Streams; // extension, data
+
+	uint64_t replayHash(const std::string& replayPath); // FNV-1a 64 of the replay path
+
+	// Extractors side (game thread): between beginReplay and commitReplay, the AsyncOutputFiles
+	// of the replay are kept in memory and given to addStream when closed
+	bool capturing();
+	void beginReplay(const std::string& replayPath, const std::string& matchup);
+	void addStream(const std::string& path, std::string& data); // path of the file it would have been
+	void commitReplay(int frames); // appends the streams and the entry to CORPUS_ARCHIVE
+
+	// wait for the other writers of the archive (file lock), throw std::runtime_error on I/O errors
+	void appendReplay(const std::string& archivePath, const std::string& replayPath, const std::string& matchup,
+		int frames, const Streams& streams);
+	void appendFullIndex(const std::string& archivePath); // if the last trailer is not a FullIndex
+}
+
+class CorpusReader
+{
+public:
+	struct Stream
+	{
+		std::string name;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct Replay
+	{
+		uint64_t hash;
+		std::string path;
+		std::string matchup;
+		int frames;
+		std::vector<Stream> streams;
+	};
+
+	CorpusReader(const std::string& archivePath); // throws std::runtime_error if it is not valid
+	const std::vector<Replay>& getReplays() const { return replays; }
+	const Replay* find(const std::string& replayPath) const;
+	// zero-copy view of a stream of a replay, nullptr if the replay does not have it
+	const char* stream(const Replay& replay, const std::string& name, size_t& size) const;
+
+private:
+	boost::iostreams::mapped_file_source file;
+	std::vector<Replay> replays; // in archive order
+};
@@ -0,0 +1,128 @@
+#include "Extractors.h"
+
+#include <algorithm>
+
+#include "CorpusArchive.h"
+#include "UnitIndex.h"
+
+using namespace BWAPI;
+
+namespace
+{
+	// "PvT", "TvZvZ", ... first letter of the races of the real players, sorted
+	std::string matchup()
+	{
+		std::string races;
+		for (const auto& player : game->getPlayers()) {
+			if (player->getUnits().empty() || player->isNeutral() || player->isObserver()) continue;
+			races += player->getRace().getName().substr(0, 1);
+		}
+		std::sort(races.begin(), races.end());
+		std::string matchup;
+		for (const auto& race : races) {
+			if (!matchup.empty()) matchup += 'v';
+			matchup += race;
+		}
+		return matchup;
+	}
+}
+
+Extractors::Extractors(Dump::Game* g)
+	: gameData(nullptr), orderData(nullptr), actionSelection(nullptr), visionData(nullptr), traceRecorder(nullptr)
+{
+	game = g;
+	unitIndex.invalidate();
+	activePlayers.clear();
+	unitDestroyedThisTurn = false;
+
+	if (!CORPUS_ARCHIVE.empty()) Corpus::beginReplay(game->mapPathName(), matchup());
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::TraceRecorder"); traceRecorder = new TraceRecorder; }
+	if (CREATE_RLD || CREATE_RGD || CREATE_ASD) { PROFILE_SPAN("MapModel::MapModel"); mapModel = new MapModel; }
+	if (CREATE_RLD) { PROFILE_SPAN("TerrainAnalyzer::TerrainAnalyzer"); terrain = new TerrainAnalyzer(*mapModel); }
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::GameData"); gameData = new GameData; }
+	if (CREATE_ROD) { PROFILE_SPAN("OrderData::OrderData"); orderData = new OrderData; }
+	if (CREATE_RCD) { PROFILE_SPAN("CombatTracker::CombatTracker"); combatTracker = new CombatTracker; }
+	if (CREATE_ASD) { PROFILE_SPAN("ActionSelection::ActionSelection"); actionSelection = new ActionSelection(*mapModel); }
+	if (CREATE_RVD) { PROFILE_SPAN("VisionData::VisionData"); visionData = new VisionData; }
+}
+
+Extractors::~Extractors()
+{
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::~GameData"); delete gameData; }
+	if (CREATE_RLD) { PROFILE_SPAN("TerrainAnalyzer::~TerrainAnalyzer"); delete terrain; }
+	if (CREATE_ROD) { PROFILE_SPAN("OrderData::~OrderData"); delete orderData; }
+	if (CREATE_RCD) { PROFILE_SPAN("CombatTracker::~CombatTracker"); delete combatTracker; }
+	if (CREATE_ASD) { PROFILE_SPAN("ActionSelection::~ActionSelection"); delete actionSelection; }
+	if (CREATE_RVD) { PROFILE_SPAN("VisionData::~VisionData"); delete visionData; }
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::~TraceRecorder"); delete traceRecorder; }
+	if (CREATE_RLD || CREATE_RGD || CREATE_ASD) { PROFILE_SPAN("MapModel::~MapModel"); delete mapModel; }
+	if (!CORPUS_ARCHIVE.empty()) { PROFILE_SPAN("Corpus::commitReplay"); Corpus::commitReplay(game->getFrameCount()); }
+
+	if (PROFILE_SPANS) Profiler::writeChromeTrace(game->mapPathName() + ".spans.json");
+}
+
+void Extractors::onFrame()
+{
+	PROFILE_SPAN("Extractors::onFrame");
+	unitIndex.invalidate();
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::onFrame"); traceRecorder->onFrame(); }
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::onFrame"); gameData->onFrame(); }
+	if (CREATE_RCD) { PROFILE_SPAN("CombatTracker::onFrame"); combatTracker->onFrame(); }
+	if (CREATE_RLD) { PROFILE_SPAN("TerrainAnalyzer::onFrame"); terrain->onFrame(); }
+	if (CREATE_ROD) { PROFILE_SPAN("OrderData::onFrame"); orderData->onFrame(); }
+	if (CREATE_ASD) { PROFILE_SPAN("ActionSelection::onFrame"); actionSelection->onFrame(); }
+	if (CREATE_RVD) { PROFILE_SPAN("VisionData::onFrame"); visionData->onFrame(); }
+
+	unitDestroyedThisTurn = false;
+}
+
+void Extractors::onReceiveText(Dump::Player player, std::string text)
+{
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::onReceiveText"); traceRecorder->onReceiveText(player, text); }
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::onReceiveText"); gameData->onReceiveText(player, text); }
+}
+
+void Extractors::onPlayerLeft(Dump::Player player)
+{
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::onPlayerLeft"); traceRecorder->onPlayerLeft(player); }
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::onPlayerLeft"); gameData->onPlayerLeft(player); }
+}
+
+void Extractors::onNukeDetect(BWAPI::Position target)
+{
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::onNukeDetect"); traceRecorder->onNukeDetect(target); }
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::onNukeDetect"); gameData->onNukeDetect(target); }
+}
+
+void Extractors::onUnitCreate(Dump::Unit unit)
+{
+	unitIndex.invalidate();
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::onUnitEvent"); traceRecorder->onUnitEvent(Trace::UnitCreate, unit); }
+	if (CREATE_RLD) { PROFILE_SPAN("TerrainAnalyzer::onUnitCreate"); terrain->onUnitCreate(unit); }
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::onUnitCreate"); gameData->onUnitCreate(unit); }
+	if (CREATE_ASD) { PROFILE_SPAN("ActionSelection::onUnitCreate"); actionSelection->onUnitCreate(unit); }
+}
+
+void Extractors::onUnitDestroy(Dump::Unit unit)
+{
+	unitIndex.invalidate();
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::onUnitEvent"); traceRecorder->onUnitEvent(Trace::UnitDestroy, unit); }
+	unitDestroyedThisTurn = true;
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::onUnitDestroy"); gameData->onUnitDestroy(unit); }
+	if (CREATE_RCD) { PROFILE_SPAN("CombatTracker::onUnitDestroy"); combatTracker->onUnitDestroy(unit); }
+	if (CREATE_ASD) { PROFILE_SPAN("ActionSelection::onUnitDestroy"); actionSelection->onUnitDestroy(unit); }
+}
+
+void Extractors::onUnitMorph(Dump::Unit unit)
+{
+	unitIndex.invalidate();
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::onUnitEvent"); traceRecorder->onUnitEvent(Trace::UnitMorph, unit); }
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::onUnitMorph"); gameData->onUnitMorph(unit); }
+}
+
+void Extractors::onUnitRenegade(Dump::Unit unit)
+{
+	unitIndex.invalidate();
+	if (CREATE_RTD) { PROFILE_SPAN("TraceRecorder::onUnitEvent"); traceRecorder->onUnitEvent(Trace::UnitRenegade, unit); }
+	if (CREATE_RGD) { PROFILE_SPAN("GameData::onUnitRenegade"); gameData->onUnitRenegade(unit); }
+}
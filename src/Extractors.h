@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Utils.h"
+#include "GameData.h"
+#include "TerrainAnalyzer.h"
+#include "OrderData.h"
+#include "CombatTracker.h"
+#include "ActionSelection.h"
+#include "VisionData.h"
+#include "TraceRecorder.h"
+
+// Runs the enabled extractors (CREATE_RGD, CREATE_RLD, ...) on a Dump::Game,
+// whatever the backend is (BWAPI inside StarCraft or MockGame headless)
+class Extractors
+{
+public:
+	Extractors(Dump::Game* g);
+	~Extractors();
+	void onFrame();
+	void onReceiveText(Dump::Player player, std::string text);
+	void onPlayerLeft(Dump::Player player);
+	void onNukeDetect(BWAPI::Position target);
+	void onUnitCreate(Dump::Unit unit);
+	void onUnitDestroy(Dump::Unit unit);
+	void onUnitMorph(Dump::Unit unit);
+	void onUnitRenegade(Dump::Unit unit);
+
+	GameData* gameData;
+	OrderData* orderData;
+	ActionSelection* actionSelection;
+	VisionData* visionData;
+	TraceRecorder* traceRecorder;
+};
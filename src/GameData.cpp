@@ -1,5 +1,7 @@
 #include "GameData.h"
 
+#include "UnitIndex.h"
+
 using namespace BWAPI;
 
 std::string attackTypeToStr(AttackType at)
@@ -17,11 +19,11 @@ std::string attackTypeToStr(AttackType at)
 // Attack struct
 // ====================================================================================
 
-Attack::Attack(const std::set<AttackType>& at, int f, BWAPI::Position p, double r, BWAPI::Player d,
-	const std::map<BWAPI::Player, BWAPI::Unitset>& units)
+Attack::Attack(const std::set<AttackType>& at, int f, BWAPI::Position p, double r, Dump::Player d,
+	const std::map<Dump::Player, Dump::Unitset, Dump::ByID>& units, std::map<Dump::Player, HeuristicsAnalyzer, Dump::ByID>& heuristics)
 	: types(at), 
 	frame(f), 
-	firstFrame(BWAPI::Broodwar->getFrameCount()), 
+	firstFrame(game->getFrameCount()), 
 	position(p), 
 	initPosition(p), 
 	radius(r), 
@@ -29,17 +31,17 @@ Attack::Attack(const std::set<AttackType>& at, int f, BWAPI::Position p, double
 {
 	for (const auto& pu : units) {
 		unitTypes.insert(std::make_pair(pu.first, std::map<BWAPI::UnitType, int>()));
-		battleUnits.insert(std::make_pair(pu.first, std::set<BWAPI::Unit>()));
-		workers.insert(std::make_pair(pu.first, std::set<BWAPI::Unit>()));
+		battleUnits.insert(std::make_pair(pu.first, Dump::Unitset()));
+		workers.insert(std::make_pair(pu.first, Dump::Unitset()));
 		for (const auto& u : pu.second) {
 			addUnit(u);
 		}
 	}
 
-	computeScores();
+	computeScores(heuristics);
 }
 
-void Attack::addUnit(BWAPI::Unit u)
+void Attack::addUnit(Dump::Unit u)
 {
 	if (!battleUnits[u->getPlayer()].count(u)) {
 		if (unitTypes[u->getPlayer()].count(u->getType())) {
@@ -51,9 +53,9 @@ void Attack::addUnit(BWAPI::Unit u)
 	}
 }
 
-void Attack::computeScores()
+void Attack::computeScores(std::map<Dump::Player, HeuristicsAnalyzer, Dump::ByID>& heuristics)
 {
-	if (defender == NULL || defender->isObserver() || defender->isNeutral() || !initPosition.isValid()) {
+	if (defender == NULL || defender->isObserver() || defender->isNeutral() || !game->isValid(initPosition)) {
 		scoreGroundCDR = -1.0;
 		scoreGroundRegion = -1.0;
 		scoreAirCDR = -1.0;
@@ -67,16 +69,19 @@ void Attack::computeScores()
 		return;
 	}
 
-	HeuristicsAnalyzer ha(defender);
+	auto it = heuristics.find(defender);
+	if (it == heuristics.end()) it = heuristics.insert(std::make_pair(defender, HeuristicsAnalyzer(defender))).first;
+	HeuristicsAnalyzer& ha = it->second;
+	ha.update();
 
 	TilePosition tp(initPosition);
-	if (!terrain->isWalkable(tp)) tp = terrain->findClosestWalkable(tp);
+	if (!mapModel->isWalkable(tp)) tp = mapModel->findClosestWalkable(tp);
 
-	BWTA::Region* r = BWTA::getRegion(tp);
-	if (r == NULL) r = terrain->findClosestRegion(tp);
+	Dump::Region* r = game->getRegion(tp);
+	if (r == NULL) r = mapModel->findClosestRegion(tp);
 
-	ChokeDepReg cdr = terrain->regionData.chokeDependantRegion[tp.x][tp.y];
-	if (cdr == -1) cdr = terrain->findClosestCDR(tp);
+	ChokeDepReg cdr = mapModel->regionData.tiles[tp].cdr;
+	if (cdr == -1) cdr = mapModel->findClosestCDR(tp);
 
 	scoreGroundCDR = ha.scoreGround(cdr);
 	scoreGroundRegion = ha.scoreGround(r);
@@ -94,256 +99,276 @@ void Attack::computeScores()
 // HeuristicsAnalyzer struct
 // ====================================================================================
 
-HeuristicsAnalyzer::HeuristicsAnalyzer(BWAPI::Player pl)
-	: p(pl)
+namespace
+{
+	double price(double minPrice, double gasPrice, double supply)
+	{
+		return minPrice + (4.0 / 3) * gasPrice + 25 * supply;
+	}
+
+	// the casters and the bunker are counted with the units that have a weapon
+	bool isSupportUnit(UnitType ut)
+	{
+		return ut == UnitTypes::Protoss_High_Templar
+			|| ut == UnitTypes::Protoss_Dark_Archon
+			|| ut == UnitTypes::Zerg_Defiler
+			|| ut == UnitTypes::Zerg_Queen
+			|| ut == UnitTypes::Terran_Medic
+			|| ut == UnitTypes::Terran_Science_Vessel
+			|| ut == UnitTypes::Terran_Bunker;
+	}
+}
+
+UnitAggregate::UnitAggregate()
+	: groundMinerals(0), groundGas(0), groundSupply(0), airMinerals(0), airGas(0), airSupply(0),
+	detectors(0), workingPeons(0), units(0)
+{
+}
+
+void UnitAggregate::add(UnitType ut, bool working, int sign)
+{
+	if (ut.groundWeapon() != WeaponTypes::None || isSupportUnit(ut)) {
+		groundMinerals += sign * ut.mineralPrice();
+		groundGas += sign * ut.gasPrice();
+		groundSupply += sign * ut.supplyRequired();
+		if (ut == UnitTypes::Terran_Siege_Tank_Siege_Mode) // a small boost for sieged tanks and lurkers
+			groundSupply += sign * ut.supplyRequired();
+	}
+	if (ut.airWeapon() != WeaponTypes::None || isSupportUnit(ut)) {
+		airMinerals += sign * ut.mineralPrice();
+		airGas += sign * ut.gasPrice();
+		airSupply += sign * ut.supplyRequired();
+	}
+	if (ut.isDetector()) detectors += sign;
+	if (working) workingPeons += sign;
+	units += sign;
+}
+
+HeuristicsAnalyzer::HeuristicsAnalyzer(Dump::Player pl)
+	: p(pl), workingPeons(0), armySize(0), armyX(0), armyY(0), updates(0)
 {
+}
+
+void HeuristicsAnalyzer::update()
+{
+	PROFILE_SPAN("HeuristicsAnalyzer::update");
+	++updates;
 	for (const auto& u : p->getUnits()) {
 		TilePosition tp(u->getTilePosition());
-		BWTA::Region* r = BWTA::getRegion(tp);
-		if (unitsByRegion.count(r)) {
-			unitsByRegion[r].insert(u);
+		UnitContribution c;
+		c.region = game->getRegion(tp);
+		c.cdr = mapModel->regionData.tiles[tp].cdr;
+		c.type = u->getType();
+		c.working = c.type.isWorker() &&
+			(u->isGatheringGas() || u->isGatheringMinerals() || u->isConstructing() || u->isRepairing());
+		c.army = !isInofensiveUnit(u);
+		c.townhall = u->exists() && c.type.isResourceDepot();
+		c.position = c.army ? u->getPosition() : Position(0, 0);
+		c.update = updates;
+
+		auto it = contributions.find(u);
+		if (it == contributions.end()) {
+			add(u, c, 1);
+			contributions.insert(std::make_pair(u, c));
+		} else if (it->second.region != c.region || it->second.cdr != c.cdr || it->second.type != c.type
+			|| it->second.working != c.working || it->second.army != c.army || it->second.townhall != c.townhall
+			|| it->second.position != c.position)
+		{
+			add(u, it->second, -1);
+			it->second = c;
+			add(u, c, 1);
 		} else {
-			// TODO auto insert []=...
-			std::set<Unit> tmpSet;
-			tmpSet.insert(u);
-			unitsByRegion.insert(make_pair(r, tmpSet));
-		}
-		ChokeDepReg cdr = terrain->regionData.chokeDependantRegion[tp.x][tp.y];
-		cdrSet.insert(cdr);
-		if (unitsByCDR.count(cdr)) {
-			unitsByCDR[cdr].insert(u);
+			it->second.update = updates;
+		}
+	}
+	// no longer units of p
+	for (auto it = contributions.begin(); it != contributions.end();) {
+		if (it->second.update != updates) {
+			add(it->first, it->second, -1);
+			it = contributions.erase(it);
 		} else {
-			// TODO auto insert []=...
-			std::set<Unit> tmpSet;
-			tmpSet.insert(u);
-			unitsByCDR.insert(make_pair(cdr, tmpSet));
+			++it;
 		}
 	}
 }
 
-const std::set<Unit>& HeuristicsAnalyzer::getUnitsCDRegion(ChokeDepReg cdr)
+void HeuristicsAnalyzer::add(Dump::Unit u, const UnitContribution& c, int sign)
 {
-	if (unitsByCDR.count(cdr)) return unitsByCDR[cdr];
-	return emptyUnitsSet;
+	unitsByRegion[c.region].add(c.type, c.working, sign);
+	unitsByCDR[c.cdr].add(c.type, c.working, sign);
+	if (c.working) workingPeons += sign;
+	if (c.army) {
+		armySize += sign;
+		armyX += sign * c.position.x;
+		armyY += sign * c.position.y;
+	}
+	if (c.townhall) {
+		if (sign > 0) townhalls.insert(u);
+		else townhalls.erase(u);
+	}
 }
 
-const std::set<Unit>& HeuristicsAnalyzer::getUnitsRegion(BWTA::Region* r)
+const UnitAggregate& HeuristicsAnalyzer::getUnitsCDRegion(ChokeDepReg cdr) const
 {
-	if (unitsByRegion.count(r)) return unitsByRegion[r];
-	return emptyUnitsSet;
+	static const UnitAggregate none;
+	auto it = unitsByCDR.find(cdr);
+	return it != unitsByCDR.end() ? it->second : none;
 }
 
-double scoreUnits(const std::list<Unit>& eUnits)
+const UnitAggregate& HeuristicsAnalyzer::getUnitsRegion(Dump::Region* r) const
 {
-	double minPrice = 0.0;
-	double gasPrice = 0.0;
-	double supply = 0.0;
-	for (const auto& u : eUnits) {
-		UnitType ut(u->getType());
-		minPrice += ut.mineralPrice();
-		gasPrice += ut.gasPrice();
-		supply += ut.supplyRequired();
-	}
-	return minPrice + (4.0 / 3) * gasPrice + 25 * supply;
+	static const UnitAggregate none;
+	auto it = unitsByRegion.find(r);
+	return it != unitsByRegion.end() ? it->second : none;
 }
 
-double HeuristicsAnalyzer::scoreUnitsGround(const std::set<Unit>& eUnits)
+double scoreUnits(const std::list<Dump::Unit>& eUnits)
 {
 	double minPrice = 0.0;
 	double gasPrice = 0.0;
 	double supply = 0.0;
 	for (const auto& u : eUnits) {
 		UnitType ut(u->getType());
-		if (ut.groundWeapon() == WeaponTypes::None
-			&& ut != UnitTypes::Protoss_High_Templar
-			&& ut != UnitTypes::Protoss_Dark_Archon
-			&& ut != UnitTypes::Zerg_Defiler
-			&& ut != UnitTypes::Zerg_Queen
-			&& ut != UnitTypes::Terran_Medic
-			&& ut != UnitTypes::Terran_Science_Vessel
-			&& ut != UnitTypes::Terran_Bunker)
-			continue;
 		minPrice += ut.mineralPrice();
 		gasPrice += ut.gasPrice();
 		supply += ut.supplyRequired();
-		if (ut == UnitTypes::Terran_Siege_Tank_Siege_Mode) // a small boost for sieged tanks and lurkers
-			supply += ut.supplyRequired();
 	}
 	return minPrice + (4.0 / 3) * gasPrice + 25 * supply;
 }
 
-double HeuristicsAnalyzer::scoreUnitsAir(const std::set<Unit>& eUnits)
+double HeuristicsAnalyzer::scoreGround(ChokeDepReg cdr) const
 {
-	double minPrice = 0.0;
-	double gasPrice = 0.0;
-	double supply = 0.0;
-	for (const auto& u : eUnits) {
-		UnitType ut(u->getType());
-		if (ut.airWeapon() == WeaponTypes::None
-			&& ut != UnitTypes::Protoss_High_Templar
-			&& ut != UnitTypes::Protoss_Dark_Archon
-			&& ut != UnitTypes::Zerg_Defiler
-			&& ut != UnitTypes::Zerg_Queen
-			&& ut != UnitTypes::Terran_Medic
-			&& ut != UnitTypes::Terran_Science_Vessel
-			&& ut != UnitTypes::Terran_Bunker)
-			continue;
-		minPrice += ut.mineralPrice();
-		gasPrice += ut.gasPrice();
-		supply += ut.supplyRequired();
-	}
-	return minPrice + (4.0 / 3) * gasPrice + 25 * supply;
+	const UnitAggregate& units = getUnitsCDRegion(cdr);
+	return price(units.groundMinerals, units.groundGas, units.groundSupply);
 }
 
-int HeuristicsAnalyzer::countDetectorUnits(const std::set<Unit>& units)
+double HeuristicsAnalyzer::scoreGround(Dump::Region* r) const
 {
-	int count = 0;
-	for (const auto& unit : units) {
-		if (unit->getType().isDetector()) ++count;
-	}
-	return count;
+	const UnitAggregate& units = getUnitsRegion(r);
+	return price(units.groundMinerals, units.groundGas, units.groundSupply);
 }
 
-int HeuristicsAnalyzer::countWorkingPeons(const std::set<Unit>& units)
+double HeuristicsAnalyzer::scoreAir(ChokeDepReg cdr) const
 {
-	int count = 0;
-	for (const auto& unit : units) {
-		if (unit->getType().isWorker() &&
-			(unit->isGatheringGas() || unit->isGatheringMinerals() || unit->isConstructing() || unit->isRepairing()))
-			++count;
-	}
-	return count;
+	const UnitAggregate& units = getUnitsCDRegion(cdr);
+	return price(units.airMinerals, units.airGas, units.airSupply);
 }
 
-double HeuristicsAnalyzer::economicImportance(BWTA::Region* r)
+double HeuristicsAnalyzer::scoreAir(Dump::Region* r) const
 {
-	if (ecoRegion.empty()) {
-		double s = 0.0;
-		for (const auto& rr : BWTA::getRegions()) {
-			int c = countWorkingPeons(getUnitsRegion(rr));
-			ecoRegion.insert(std::make_pair(rr, c));
-			s += c;
-		}
-		for (const auto& rr : BWTA::getRegions()) {
-			ecoRegion[rr] = ecoRegion[rr] / s;
-		}
-	}
-	return ecoRegion[r];
+	const UnitAggregate& units = getUnitsRegion(r);
+	return price(units.airMinerals, units.airGas, units.airSupply);
 }
 
-double HeuristicsAnalyzer::economicImportance(ChokeDepReg cdr)
+// share of the working peons of the player in the region (of the ones in a region)
+double HeuristicsAnalyzer::economicImportance(Dump::Region* r) const
 {
-	if (ecoCDR.empty()) {
-		double s = 0.0;
-		for (const auto& cdrr : cdrSet) {
-			int c = countWorkingPeons(getUnitsCDRegion(cdrr));
-			ecoCDR.insert(std::make_pair(cdrr, c));
-			s += c;
-		}
-		for (const auto& cdrr : cdrSet) {
-			ecoCDR[cdrr] = ecoCDR[cdrr] / s;
-		}
-	}
-	return ecoCDR[cdr];
+	if (!game->getRegions().count(r)) return 0.0;
+	double s = workingPeons - getUnitsRegion(nullptr).workingPeons;
+	return getUnitsRegion(r).workingPeons / s;
 }
 
-BWAPI::Unitset HeuristicsAnalyzer::getTownhalls(const BWAPI::Unitset& units)
+// share of the working peons of the player in the CDR, 0 if the player has no unit there
+double HeuristicsAnalyzer::economicImportance(ChokeDepReg cdr) const
 {
-	BWAPI::Unitset ret;
-	for (const auto& unit : units) {
-		if (unit->exists() && unit->getType().isResourceDepot()) {
-			ret.insert(unit);
-		}
-	}
-	return ret;
+	const UnitAggregate& units = getUnitsCDRegion(cdr);
+	if (units.units == 0) return 0.0;
+	double s = workingPeons;
+	return units.workingPeons / s;
 }
 
-double HeuristicsAnalyzer::tacticalImportance(BWTA::Region* r)
+BWAPI::Position HeuristicsAnalyzer::armyMean() const
 {
-	if (tacRegion.count(r)) return tacRegion[r];
-	BWAPI::Unitset ths = getTownhalls(p->getUnits());
-	BWAPI::Unitset army = getPlayerMilitaryUnits(p->getUnits())[p];
-	Position mean(0, 0);
-	for (const auto& u : army) mean += u->getPosition();
-	mean = Position(mean.x / army.size(), mean.y / army.size());
+	size_t size = armySize;
+	Position mean(armyX, armyY);
+	return Position(mean.x / size, mean.y / size);
+}
+
+double HeuristicsAnalyzer::tacticalImportance(Dump::Region* r) const
+{
+	Position mean = armyMean();
 	TilePosition meanWalkable(mean);
-	if (!terrain->isWalkable(meanWalkable)) {
-		meanWalkable = terrain->findClosestWalkable(meanWalkable);
+	if (!mapModel->isWalkable(meanWalkable)) {
+		meanWalkable = mapModel->findClosestWalkable(meanWalkable);
 	}
-	BWTA::Region* meanArmyReg = BWTA::getRegion(mean);
+	Dump::Region* meanArmyReg = game->getRegion(mean);
 	if (meanArmyReg == NULL) {
-		meanArmyReg = terrain->findClosestRegion(meanWalkable);
+		meanArmyReg = mapModel->findClosestRegion(meanWalkable);
 	}
 	double s = 0.0;
-	for (const auto& rr : BWTA::getRegions()) {
-		tacRegion.insert(std::make_pair(rr, 0.0));
-		for (const auto& th : ths) {
-			BWTA::Region* thr = BWTA::getRegion(th->getTilePosition());
+	double tacR = 0.0;
+	bool found = false;
+	for (const auto& rr : game->getRegions()) {
+		double tac = 0.0;
+		for (const auto& th : townhalls) {
+			Dump::Region* thr = game->getRegion(th->getTilePosition());
 			if (thr != NULL && thr->getReachableRegions().count(rr)) {
-				double tmp = terrain->_pfMaps.distRegions[terrain->hashRegionCenter(rr)][terrain->hashRegionCenter(thr)];
-				tacRegion[rr] += tmp*tmp;
+				double tmp = mapModel->regionDistance(rr, thr);
+				tac += tmp*tmp;
 			} else { // if rr is an island, it will be penalized a lot
-				tacRegion[rr] += Broodwar->mapWidth() * Broodwar->mapHeight();
+				tac += game->mapWidth() * game->mapHeight();
 			}
 		}
 		double tmp = 0.0;
 		if (rr->getReachableRegions().count(meanArmyReg)) {
-			tmp = terrain->_pfMaps.distRegions[terrain->hashRegionCenter(rr)][terrain->hashRegionCenter(meanArmyReg)];
+			tmp = mapModel->regionDistance(rr, meanArmyReg);
 		} else {
-			tmp = terrain->_pfMaps.distRegions[terrain->hashRegionCenter(rr)][terrain->hashRegionCenter(terrain->findClosestReachableRegion(meanArmyReg, rr))];
+			tmp = mapModel->regionDistance(rr, mapModel->findClosestReachableRegion(meanArmyReg, rr));
+		}
+		tac += tmp*tmp * ARMY_TACTICAL_IMPORTANCE;
+		s += tac;
+		if (rr == r) {
+			tacR = tac;
+			found = true;
 		}
-		tacRegion[rr] += tmp*tmp * ARMY_TACTICAL_IMPORTANCE;
-		s += tacRegion[rr];
-	}
-	for (const auto& it : tacRegion) {
-		tacRegion[it.first] = s - it.second;
 	}
-	return tacRegion[r];
+	return found ? s - tacR : 0.0;
 }
 
-double HeuristicsAnalyzer::tacticalImportance(ChokeDepReg cdr)
+double HeuristicsAnalyzer::tacticalImportance(ChokeDepReg cdr) const
 {
-	if (tacCDR.count(cdr)) return tacCDR[cdr];
-	BWAPI::Unitset ths = getTownhalls(p->getUnits());
-	BWAPI::Unitset army = getPlayerMilitaryUnits(p->getUnits())[p];
-	Position mean(0, 0);
-	for (const auto& u : army) {
-		mean += u->getPosition();
+	TilePosition m(armyMean());
+	if (!mapModel->isWalkable(m)) {
+		m = mapModel->findClosestWalkable(m);
 	}
-	mean = Position(mean.x / army.size(), mean.y / army.size());
-	TilePosition m(mean);
-	if (!terrain->isWalkable(m)) {
-		m = terrain->findClosestWalkable(m);
-	}
-	ChokeDepReg meanArmyCDR = terrain->regionData.chokeDependantRegion[m.x][m.y];
+	ChokeDepReg meanArmyCDR = mapModel->regionData.tiles[m].cdr;
 	if (meanArmyCDR == -1) {
-		meanArmyCDR = terrain->findClosestCDR(m);
+		meanArmyCDR = mapModel->findClosestCDR(m);
+	}
+	const DistanceMatrix& distCDR = mapModel->_pfMaps.distCDR;
+	std::vector<int> thIndices; // in distCDR, -1 if unknown
+	for (const auto& th : townhalls) {
+		ChokeDepReg thcdr = mapModel->regionData.tiles[th->getTilePosition()].cdr;
+		thIndices.push_back(thcdr != -1 ? distCDR.index(thcdr) : -1);
 	}
 	double s = 0.0;
-	for (const auto& cdrr : terrain->allChokeDepRegs) {
-		tacCDR.insert(std::make_pair(cdrr, 0.0));
-		for (const auto& th : ths) {
-			ChokeDepReg thcdr = terrain->regionData.chokeDependantRegion[th->getTilePosition().x][th->getTilePosition().y];
-			if (thcdr != -1 && terrain->_pfMaps.distCDR[thcdr][cdrr] >= 0.0) { // is reachable
-				double tmp = terrain->_pfMaps.distCDR[thcdr][cdrr];
-				tacCDR[cdrr] += tmp*tmp;
+	double tacCDR = 0.0;
+	bool found = false;
+	for (const auto& cdrr : mapModel->allChokeDepRegs) {
+		int i = distCDR.index(cdrr);
+		double tac = 0.0;
+		for (const auto& th : thIndices) {
+			if (th != -1 && i != -1 && distCDR.at(th, i) >= 0.0) { // is reachable
+				double tmp = distCDR.at(th, i);
+				tac += tmp*tmp;
 			} else { // if rr is an island, it will be penalized a lot
-				tacCDR[cdrr] += Broodwar->mapWidth() * Broodwar->mapHeight();
+				tac += game->mapWidth() * game->mapHeight();
 			}
 		}
 		double tmp = 0.0;
-		if (terrain->_pfMaps.distCDR[cdrr][meanArmyCDR] >= 0.0) { // is reachable
-			tmp = terrain->_pfMaps.distCDR[cdrr][meanArmyCDR];
+		if (distCDR(cdrr, meanArmyCDR) >= 0.0) { // is reachable
+			tmp = distCDR(cdrr, meanArmyCDR);
 		} else {
-			tmp = terrain->_pfMaps.distCDR[cdrr][terrain->findClosestReachableCDR(meanArmyCDR, cdrr)];
+			tmp = distCDR(cdrr, mapModel->findClosestReachableCDR(meanArmyCDR, cdrr));
+		}
+		tac += tmp*tmp * ARMY_TACTICAL_IMPORTANCE;
+		s += tac;
+		if (cdrr == cdr) {
+			tacCDR = tac;
+			found = true;
 		}
-		tacCDR[cdrr] += tmp*tmp * ARMY_TACTICAL_IMPORTANCE;
-		s += tacCDR[cdrr];
-	}
-	for (const auto& it : tacCDR) {
-		tacCDR[it.first] = s - it.second;
 	}
-	return tacCDR[cdr];
+	return found ? s - tacCDR : 0.0;
 }
 
 // ====================================================================================
@@ -351,26 +376,33 @@ double HeuristicsAnalyzer::tacticalImportance(ChokeDepReg cdr)
 // ====================================================================================
 
 GameData::GameData()
+	: binaryDat(nullptr)
 {
 	// Create files to save data
-	std::string filepath = Broodwar->mapPathName() + ".rgd";
+	std::string filepath = game->mapPathName() + ".rgd";
 	replayDat.open(filepath.c_str());
+	if (CREATE_RGD_BINARY) {
+		binaryDat = new RGDWriter(game->mapPathName() + ".rgdb");
+		binaryDat->text(RGDB::RepPath, 0, -1, game->mapPathName());
+		binaryDat->text(RGDB::MapName, 0, -1, game->mapName(), 0, static_cast<int>(game->getStartLocations().size()));
+	}
 
 	replayDat << "[Replay Start]\n" << std::fixed << std::setprecision(4);
-	replayDat << "RepPath: " << Broodwar->mapPathName() << '\n';
-	replayDat << "MapName: " << Broodwar->mapName() << '\n';
-	replayDat << "NumStartPositions: " << Broodwar->getStartLocations().size() << '\n';
+	replayDat << "RepPath: " << game->mapPathName() << '\n';
+	replayDat << "MapName: " << game->mapName() << '\n';
+	replayDat << "NumStartPositions: " << game->getStartLocations().size() << '\n';
 	replayDat << "The following players are in this replay:\n";
 
-	for (const auto& player : Broodwar->getPlayers()){
+	for (const auto& player : game->getPlayers()){
 		if (!player->getUnits().empty() && !player->isNeutral()) {
 			// TODO you cannot trust this startLocID
 			int startLocID = -1;
-			for (const auto& startLocation : Broodwar->getStartLocations()) {
+			for (const auto& startLocation : game->getStartLocations()) {
 				startLocID++;
 				if (player->getStartLocation() == startLocation) break;
 			}
 			replayDat << player->getID() << ", " << player->getName() << ", " << player->getRace().getName() << ", " << startLocID << '\n';
+			if (binaryDat) binaryDat->text(RGDB::PlayerInfo, 0, player->getID(), player->getName(), player->getRace().getID(), startLocID);
 			activePlayers.insert(player);
 		}
 	}
@@ -387,31 +419,35 @@ GameData::~GameData()
 	}
 	replayDat << "[EndGame]\n";
 	replayDat.close();
+	if (binaryDat) {
+		binaryDat->event(RGDB::EndGame, game->getFrameCount(), -1);
+		delete binaryDat;
+	}
 }
 
 void GameData::onUpdateAttacks()
 {
-	if (attacks.size() > 20) Broodwar->printf("Bug, attacks is bigger than 20");
+	PROFILE_SPAN("GameData::onUpdateAttacks");
+	if (attacks.size() > 20) game->printText("Bug, attacks is bigger than 20");
 	for (std::list<Attack>::iterator it = attacks.begin(); it != attacks.end(); ) {
 #ifdef __DEBUG_OUTPUT__
-		Broodwar->drawCircleMap(it->position.x, it->position.y, static_cast<int>(it->radius), Colors::Red);
-		Broodwar->drawBoxMap(it->position.x - 6, it->position.y - 6, it->position.x + 6, it->position.y + 6, Colors::Red, true);
+		game->drawCircleMap(it->position, static_cast<int>(it->radius), Colors::Red);
+		game->drawBoxMap(it->position - Position(6, 6), it->position + Position(6, 6), Colors::Red, true);
 		int i = 0;
 		for (const auto& at : it->types) {
-			Broodwar->drawTextMap(std::max(0, it->position.x - 2 * TILE_SIZE), std::max(0, it->position.y - TILE_SIZE + (i * 16)),
-				"%s on %s (race %s)",
-				attackTypeToStr(at).c_str(), it->defender->getName().c_str(), it->defender->getRace().c_str());
+			game->drawTextMap(Position(std::max(0, it->position.x - 2 * TILE_SIZE), std::max(0, it->position.y - TILE_SIZE + (i * 16))),
+				attackTypeToStr(at) + " on " + it->defender->getName() + " (race " + it->defender->getRace().getName() + ")");
 			++i;
 		}
 #endif
-		std::map<Player, Unitset> playerUnits = getPlayerMilitaryUnits(
-			Broodwar->getUnitsInRadius(it->position, static_cast<int>(it->radius))
+		std::map<Dump::Player, Dump::Unitset, Dump::ByID> playerUnits = getPlayerMilitaryUnits(
+			unitIndex.getUnitsInRadius(it->position, static_cast<int>(it->radius))
 			);
 		for (const auto& pp : playerUnits) {
 			if (!it->unitTypes.count(pp.first))
 				it->unitTypes.insert(std::make_pair(pp.first, std::map<BWAPI::UnitType, int>()));
 			if (!it->battleUnits.count(pp.first))
-				it->battleUnits.insert(std::make_pair(pp.first, std::set<BWAPI::Unit>()));
+				it->battleUnits.insert(std::make_pair(pp.first, Dump::Unitset()));
 			for (const auto& uu : pp.second) {
 				UnitType ut = uu->getType();
 				if ((ut.canAttack() && !ut.isWorker()) // non workers non casters (counts interceptors)
@@ -426,15 +462,15 @@ void GameData::onUpdateAttacks()
 			}
 		}
 		// TODO modify, currently 2 players (1v1) only
-		BWAPI::Player winner = NULL;
-		BWAPI::Player loser = NULL;
-		BWAPI::Player offender = NULL;
+		Dump::Player winner = NULL;
+		Dump::Player loser = NULL;
+		Dump::Player offender = NULL;
 		for (const auto& p : it->unitTypes) {
 			if (p.first != it->defender) offender = p.first;
 		}
 		BWAPI::Position pos(0, 0);
 		int attackers = 0;
-		Unitset tmp = playerUnits[offender];
+		Dump::Unitset tmp = playerUnits[offender];
 		tmp.insert(playerUnits[it->defender].begin(), playerUnits[it->defender].end());
 		for (const auto& u : tmp) {
 			if (u && u->exists() && (u->isAttacking() || u->isUnderAttack())) {
@@ -455,13 +491,13 @@ void GameData::onUpdateAttacks()
 				it->radius = MIN_ATTACK_RADIUS;
 			if (it->radius > MAX_ATTACK_RADIUS)
 				it->radius = MAX_ATTACK_RADIUS;
-			it->frame = Broodwar->getFrameCount();
+			it->frame = game->getFrameCount();
 			++it;
-		} else if (Broodwar->getFrameCount() - it->frame >= 24 * SECONDS_SINCE_LAST_ATTACK) {
+		} else if (game->getFrameCount() - it->frame >= 24 * SECONDS_SINCE_LAST_ATTACK) {
 			// Attack is finished, who won the battle ? (this is not essential, as we output enough data to recompute it)
-			std::map<BWAPI::Player, std::list<BWAPI::Unit> > aliveUnits;
+			std::map<Dump::Player, std::list<Dump::Unit>, Dump::ByID> aliveUnits;
 			for (const auto& p : it->battleUnits) {
-				aliveUnits.insert(std::make_pair(p.first, std::list<Unit>()));
+				aliveUnits.insert(std::make_pair(p.first, std::list<Dump::Unit>()));
 				for (const auto& u : p.second) {
 					if (u && u->exists()) aliveUnits[p.first].push_back(u);
 				}
@@ -483,15 +519,15 @@ void GameData::onUpdateAttacks()
 	}
 }
 
-void GameData::endAttack(std::list<Attack>::iterator it, BWAPI::Player loser, BWAPI::Player winner)
+void GameData::endAttack(std::list<Attack>::iterator it, Dump::Player loser, Dump::Player winner)
 {
 #ifdef __DEBUG_OUTPUT__
 	if (winner != NULL && loser != NULL)
 	{
-		Broodwar->printf("Player %s (race %s) won the battle against player %s (race %s) at Position (%d,%d)",
-			winner->getName().c_str(), winner->getRace().c_str(),
-			loser->getName().c_str(), loser->getRace().c_str(),
-			it->position.x, it->position.y);
+		std::ostringstream buffer;
+		buffer << "Player " << winner->getName() << " (race " << winner->getRace() << ") won the battle against player "
+			<< loser->getName() << " (race " << loser->getRace() << ") at Position " << it->position;
+		game->printText(buffer.str());
 	}
 #endif
 
@@ -505,59 +541,48 @@ void GameData::endAttack(std::list<Attack>::iterator it, BWAPI::Player loser, BW
 		tmpAttackType[tmpAttackType.size() - 1] = ')';
 	}
 
-	std::string tmpUnitTypes("{");
-	for (const auto& put : it->unitTypes) {
-		std::string tmpUnitTypesPlayer(":{");
-		for (const auto& pp : put.second) {
-			tmpUnitTypesPlayer += pp.first.getName() + ":" + std::to_string(pp.second) + ",";
-		}
-		if (tmpUnitTypesPlayer[tmpUnitTypesPlayer.size() - 1] == '{') {
-			tmpUnitTypesPlayer += "}";
-		} else {
-			tmpUnitTypesPlayer[tmpUnitTypesPlayer.size() - 1] = '}';
+	// the units of each type at the end and the workers dead, per player
+	std::map<Dump::Player, std::map<BWAPI::UnitType, int>, Dump::ByID> unitTypesEnd;
+	for (const auto& pu : it->battleUnits) {
+		std::map<BWAPI::UnitType, int>& tmp = unitTypesEnd[pu.first];
+		for (const auto& u : pu.second) {
+			if (u->exists()) ++tmp[u->getType()];
 		}
-		tmpUnitTypes += std::to_string(put.first->getID()) + tmpUnitTypesPlayer + ",";
 	}
-	if (tmpUnitTypes[tmpUnitTypes.size() - 1] == '{') {
-		tmpUnitTypes += "}";
-	} else {
-		tmpUnitTypes[tmpUnitTypes.size() - 1] = '}';
-	}
-	std::string tmpUnitTypesEnd("{");
-	for (const auto& pu : it->battleUnits) {
-		std::map<BWAPI::UnitType, int> tmp;
+	std::map<Dump::Player, int, Dump::ByID> workersDead;
+	for (const auto& pu : it->workers) {
+		int& c = workersDead[pu.first];
 		for (const auto& u : pu.second) {
-			if (!u->exists()) continue;
-			if (tmp.count(u->getType())) {
-				tmp[u->getType()] += 1;
+			if (u && !u->exists()) ++c;
+		}
+	}
+
+	auto unitTypesStr = [](const std::map<Dump::Player, std::map<BWAPI::UnitType, int>, Dump::ByID>& unitTypes) {
+		std::string tmpUnitTypes("{");
+		for (const auto& put : unitTypes) {
+			std::string tmpUnitTypesPlayer(":{");
+			for (const auto& pp : put.second) {
+				tmpUnitTypesPlayer += pp.first.getName() + ":" + std::to_string(pp.second) + ",";
+			}
+			if (tmpUnitTypesPlayer[tmpUnitTypesPlayer.size() - 1] == '{') {
+				tmpUnitTypesPlayer += "}";
 			} else {
-				tmp.insert(std::make_pair(u->getType(), 1));
+				tmpUnitTypesPlayer[tmpUnitTypesPlayer.size() - 1] = '}';
 			}
+			tmpUnitTypes += std::to_string(put.first->getID()) + tmpUnitTypesPlayer + ",";
 		}
-		std::string tmpUnitTypesPlayer(":{");
-		for (const auto& pp : tmp) {
-			tmpUnitTypesPlayer += pp.first.getName() + ":" + std::to_string(pp.second) + ",";
-		}
-		if (tmpUnitTypesPlayer[tmpUnitTypesPlayer.size() - 1] == '{') {
-			tmpUnitTypesPlayer += "}";
+		if (tmpUnitTypes[tmpUnitTypes.size() - 1] == '{') {
+			tmpUnitTypes += "}";
 		} else {
-			tmpUnitTypesPlayer[tmpUnitTypesPlayer.size() - 1] = '}';
+			tmpUnitTypes[tmpUnitTypes.size() - 1] = '}';
 		}
-		tmpUnitTypesEnd += std::to_string(pu.first->getID()) + tmpUnitTypesPlayer + ",";
-	}
-	if (tmpUnitTypesEnd[tmpUnitTypesEnd.size() - 1] == '{') {
-		tmpUnitTypesEnd += "}";
-	} else {
-		tmpUnitTypesEnd[tmpUnitTypesEnd.size() - 1] = '}';
-	}
+		return tmpUnitTypes;
+	};
+	std::string tmpUnitTypes = unitTypesStr(it->unitTypes);
+	std::string tmpUnitTypesEnd = unitTypesStr(unitTypesEnd);
 	std::string tmpWorkersDead("{");
-	for (const auto& pu : it->workers) {
-		int c = 0;
-		tmpWorkersDead += std::to_string(pu.first->getID()) + ":";
-		for (const auto& u : pu.second) {
-			if (u && !u->exists()) ++c;
-		}
-		tmpWorkersDead += std::to_string(c) + ",";
+	for (const auto& pc : workersDead) {
+		tmpWorkersDead += std::to_string(pc.first->getID()) + ":" + std::to_string(pc.second) + ",";
 	}
 	tmpWorkersDead[tmpWorkersDead.size() - 1] = '}';
 	/// $firstFrame, $defenderId, isAttacked, $attackType, 
@@ -568,10 +593,11 @@ void GameData::endAttack(std::list<Attack>::iterator it, BWAPI::Player loser, BW
 	/// {$playerId:$nbWorkersDead},$lastFrame, $winnerId
 
 	BWAPI::TilePosition tmptp(it->initPosition);
-	replayDat << it->firstFrame << "," << it->defender->getID() << ",IsAttacked," << tmpAttackType << ",("
+	std::ostringstream attackDat;
+	attackDat << std::fixed << std::setprecision(4) << tmpAttackType << ",("
 		<< it->initPosition.x << "," << it->initPosition.y << "),"
-		<< terrain->regionData.chokeDependantRegion[tmptp.x][tmptp.y] << ","
-		<< terrain->hashRegionCenter(BWTA::getRegion(tmptp)) << ","
+		<< mapModel->regionData.tiles[tmptp].cdr << ","
+		<< mapModel->hashRegionCenter(game->getRegion(tmptp)) << ","
 		<< tmpUnitTypes << ",("
 		<< it->scoreGroundCDR << "," << it->scoreGroundRegion << ","
 		<< it->scoreAirCDR << "," << it->scoreAirRegion << ","
@@ -579,34 +605,121 @@ void GameData::endAttack(std::list<Attack>::iterator it, BWAPI::Player loser, BW
 		<< it->economicImportanceCDR << "," << it->economicImportanceRegion << ","
 		<< it->tacticalImportanceCDR << "," << it->tacticalImportanceRegion
 		<< ")," << tmpUnitTypesEnd << ",(" << it->position.x << "," << it->position.y << "),"
-		<< tmpWorkersDead << "," << Broodwar->getFrameCount();
-	if (winner != NULL) {
-		replayDat << ",winner:" << winner->getID() << "\n";
-	} else {
-		replayDat << "\n";
+		<< tmpWorkersDead << "," << game->getFrameCount();
+	if (winner != NULL) attackDat << ",winner:" << winner->getID();
+	replayDat << it->firstFrame << "," << it->defender->getID() << ",IsAttacked," << attackDat.str() << "\n";
+	if (binaryDat) {
+		RGDB::Attack attack = {};
+		for (const auto& t : it->types) attack.types |= 1u << t;
+		attack.cdr = mapModel->regionData.tiles[tmptp].cdr;
+		attack.region = mapModel->hashRegionCenter(game->getRegion(tmptp));
+		attack.lastX = it->position.x;
+		attack.lastY = it->position.y;
+		attack.lastFrame = game->getFrameCount();
+		attack.winner = winner != NULL ? winner->getID() : -1;
+		attack.scoreGroundCDR = it->scoreGroundCDR;
+		attack.scoreGroundRegion = it->scoreGroundRegion;
+		attack.scoreAirCDR = it->scoreAirCDR;
+		attack.scoreAirRegion = it->scoreAirRegion;
+		attack.scoreDetectCDR = it->scoreDetectCDR;
+		attack.scoreDetectRegion = it->scoreDetectRegion;
+		attack.economicImportanceCDR = it->economicImportanceCDR;
+		attack.economicImportanceRegion = it->economicImportanceRegion;
+		attack.tacticalImportanceCDR = it->tacticalImportanceCDR;
+		attack.tacticalImportanceRegion = it->tacticalImportanceRegion;
+		auto unitCounts = [](const std::map<Dump::Player, std::map<BWAPI::UnitType, int>, Dump::ByID>& unitTypes) {
+			std::vector<RGDB::UnitCount> counts;
+			for (const auto& put : unitTypes) {
+				if (put.second.empty()) counts.push_back(RGDB::UnitCount{ put.first->getID(), -1, 0 });
+				for (const auto& pp : put.second) counts.push_back(RGDB::UnitCount{ put.first->getID(), pp.first.getID(), pp.second });
+			}
+			return counts;
+		};
+		std::vector<RGDB::PlayerCount> workers;
+		for (const auto& pc : workersDead) workers.push_back(RGDB::PlayerCount{ pc.first->getID(), pc.second });
+		binaryDat->attack(it->firstFrame, it->defender->getID(), it->initPosition.x, it->initPosition.y, attack,
+			unitCounts(it->unitTypes), unitCounts(unitTypesEnd), workers);
 	}
-	replayDat.flush();
 }
 
+// A unit of p1 discovers the units of unseenUnits[p1] in its sight range, the event is written for
+// the first other active player. The unseen units are bucketed by cells (sorted by cell, positions
+// in flat arrays) and each sight circle only scans the cells it overlaps. The events of a unit come
+// in the order of unseenUnits.
 void GameData::handleVisionEvents()
 {
-	std::map<BWAPI::Player, BWAPI::Unitset> seenThisTurn;
-
+	PROFILE_SPAN("GameData::handleVisionEvents");
+	std::map<Dump::Player, Dump::Unitset, Dump::ByID> seenThisTurn;
+
+	const int cellSize = 256;
+	int width = std::max(1, (game->mapWidth() * TILE_SIZE + cellSize - 1) / cellSize);
+	int height = std::max(1, (game->mapHeight() * TILE_SIZE + cellSize - 1) / cellSize);
+	auto cellX = [&](int x) { return std::max(0, std::min(width - 1, x / cellSize)); };
+	auto cellY = [&](int y) { return std::max(0, std::min(height - 1, y / cellSize)); };
+	std::vector<Dump::Unit> targets; // unseenUnits order
+	std::vector<Position> positions;
+	std::vector<int> cellStart;
+	std::vector<int> xs, ys, ranks; // sorted by cell
+	std::vector<char> inSight;
+	std::vector<int> hits;
 	for (const auto& p1 : activePlayers) {
+		Dump::Player p2 = nullptr;
+		for (const auto& p : activePlayers) {
+			if (p != p1) {
+				p2 = p;
+				break;
+			}
+		}
+		auto unseenIt = unseenUnits.find(p1);
+		if (p2 == nullptr || unseenIt == unseenUnits.end() || unseenIt->second.empty()) continue;
+		const std::set<std::pair<Dump::Unit, UnitType>, Dump::ByID>& unseen = unseenIt->second;
+
+		targets.clear();
+		positions.clear();
+		cellStart.assign(width * height + 1, 0);
+		for (const auto& visionPair : unseen) {
+			targets.push_back(visionPair.first);
+			positions.push_back(visionPair.first->getPosition());
+			cellStart[cellX(positions.back().x) + cellY(positions.back().y) * width + 1]++;
+		}
+		for (size_t c = 1; c < cellStart.size(); ++c) cellStart[c] += cellStart[c - 1];
+		xs.resize(targets.size());
+		ys.resize(targets.size());
+		ranks.resize(targets.size());
+		std::vector<int> next(cellStart.begin(), cellStart.end() - 1);
+		for (size_t rank = 0; rank < targets.size(); ++rank) {
+			int i = next[cellX(positions[rank].x) + cellY(positions[rank].y) * width]++;
+			xs[i] = positions[rank].x;
+			ys[i] = positions[rank].y;
+			ranks[i] = static_cast<int>(rank);
+		}
+		inSight.resize(targets.size());
+
+		Dump::Unitset& seen = seenThisTurn[p1];
 		for (const auto& u : p1->getUnits()) {
-			for (const auto& p2 : activePlayers) {
-				if (p1 == p2) continue;
-				for (const auto& visionPair : unseenUnits[p1]) {
-					Unit visionTarget = visionPair.first;
-					int sight = u->getType().sightRange();
-					sight = sight * sight;
-					BWAPI::Position diff = u->getPosition() - visionTarget->getPosition();
-					int dist = (diff.x * diff.x) + (diff.y * diff.y);
-					if (dist <= sight && seenThisTurn[p1].find(visionTarget) == seenThisTurn[p1].end()) {
-						replayDat << Broodwar->getFrameCount() << "," << p2->getID() << ",Discovered," << visionTarget->getID() << "," << visionTarget->getType().getName() << "\n";
-						//Event - Discovered
-						seenThisTurn[p1].insert(visionTarget);
-					}
+			int sightRange = u->getType().sightRange();
+			int sight = sightRange * sightRange;
+			Position center = u->getPosition();
+			hits.clear();
+			for (int cy = cellY(center.y - sightRange); cy <= cellY(center.y + sightRange); ++cy) {
+				int begin = cellStart[cellX(center.x - sightRange) + cy * width];
+				int end = cellStart[cellX(center.x + sightRange) + cy * width + 1];
+				for (int i = begin; i < end; ++i) { // the cells of a row are contiguous
+					int dx = center.x - xs[i];
+					int dy = center.y - ys[i];
+					inSight[i] = (dx * dx) + (dy * dy) <= sight;
+				}
+				for (int i = begin; i < end; ++i) {
+					if (inSight[i]) hits.push_back(ranks[i]);
+				}
+			}
+			std::sort(hits.begin(), hits.end());
+			for (const auto& rank : hits) {
+				Dump::Unit visionTarget = targets[rank];
+				if (seen.insert(visionTarget).second) {
+					replayDat << game->getFrameCount() << "," << p2->getID() << ",Discovered," << visionTarget->getID() << "," << visionTarget->getType().getName() << "\n";
+					if (binaryDat) binaryDat->event(RGDB::Discovered, game->getFrameCount(), p2->getID(), visionTarget->getID(), visionTarget->getType().getID());
+					//Event - Discovered
 				}
 			}
 		}
@@ -615,15 +728,16 @@ void GameData::handleVisionEvents()
 	// remove from unseen, units seen this turn
 	for (const auto& p : activePlayers) {
 		for (const auto& u : seenThisTurn[p]) {
-			unseenUnits[p].erase(std::pair<Unit, UnitType>(u, u->getType()));
+			unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(u, u->getType()));
 		}
 	}
 }
 
 void GameData::handleTechEvents()
 {
+	PROFILE_SPAN("GameData::handleTechEvents");
 	for (const auto& p : activePlayers) {
-		std::map<Player, std::list<TechType>>::iterator currentTechIt = listCurrentlyResearching.find(p);
+		std::map<Dump::Player, std::list<TechType>, Dump::ByID>::iterator currentTechIt = listCurrentlyResearching.find(p);
 		for (const auto& currentResearching : BWAPI::TechTypes::allTechTypes()) {
 			std::list<TechType>* techListPtr;
 			if (currentTechIt != listCurrentlyResearching.end()) {
@@ -644,20 +758,23 @@ void GameData::handleTechEvents()
 			if (p->isResearching(currentResearching)) {
 				if (!wasResearching) {
 					listCurrentlyResearching[p].push_back(currentResearching);
-					replayDat << Broodwar->getFrameCount() << "," << p->getID() << ",StartResearch," << currentResearching.getName() << "\n";
+					replayDat << game->getFrameCount() << "," << p->getID() << ",StartResearch," << currentResearching.getName() << "\n";
+					if (binaryDat) binaryDat->event(RGDB::StartResearch, game->getFrameCount(), p->getID(), 0, currentResearching.getID());
 					//Event - researching new tech
 				}
 			} else {
 				if (wasResearching) {
 					if (p->hasResearched(currentResearching)) {
-						replayDat << Broodwar->getFrameCount() << "," << p->getID() << ",FinishResearch," << currentResearching.getName() << "\n";
+						replayDat << game->getFrameCount() << "," << p->getID() << ",FinishResearch," << currentResearching.getName() << "\n";
+						if (binaryDat) binaryDat->event(RGDB::FinishResearch, game->getFrameCount(), p->getID(), 0, currentResearching.getID());
 						if (listResearched.count(p) > 0) {
 							listResearched[p].push_back(currentResearching);
 						}
 						listCurrentlyResearching[p].remove(currentResearching);
 						//Event - research complete
 					} else {
-						replayDat << Broodwar->getFrameCount() << "," << p->getID() << ",CancelResearch," << currentResearching.getName() << "\n";
+						replayDat << game->getFrameCount() << "," << p->getID() << ",CancelResearch," << currentResearching.getName() << "\n";
+						if (binaryDat) binaryDat->event(RGDB::CancelResearch, game->getFrameCount(), p->getID(), 0, currentResearching.getID());
 						listCurrentlyResearching[p].remove(currentResearching);
 						//Event - research canceled
 					}
@@ -666,7 +783,7 @@ void GameData::handleTechEvents()
 
 		}
 
-		std::map<Player, std::list<UpgradeType>>::iterator currentUpgradeIt = listCurrentlyUpgrading.find(p);
+		std::map<Dump::Player, std::list<UpgradeType>, Dump::ByID>::iterator currentUpgradeIt = listCurrentlyUpgrading.find(p);
 		for (const auto& checkedUpgrade : BWAPI::UpgradeTypes::allUpgradeTypes()) {
 			std::list<UpgradeType>* upgradeListPtr;
 			if (currentUpgradeIt != listCurrentlyUpgrading.end()) {
@@ -688,7 +805,8 @@ void GameData::handleTechEvents()
 			if (p->isUpgrading(checkedUpgrade)) {
 				if (!wasResearching) {
 					listCurrentlyUpgrading[p].push_back(checkedUpgrade);
-					replayDat << Broodwar->getFrameCount() << "," << p->getID() << ",StartUpgrade," << checkedUpgrade.getName() << "," << (p->getUpgradeLevel(checkedUpgrade) + 1) << "\n";
+					replayDat << game->getFrameCount() << "," << p->getID() << ",StartUpgrade," << checkedUpgrade.getName() << "," << (p->getUpgradeLevel(checkedUpgrade) + 1) << "\n";
+					if (binaryDat) binaryDat->event(RGDB::StartUpgrade, game->getFrameCount(), p->getID(), 0, checkedUpgrade.getID(), 0, 0, p->getUpgradeLevel(checkedUpgrade) + 1);
 					//Event - researching new upgrade
 				}
 			} else {
@@ -700,14 +818,16 @@ void GameData::handleTechEvents()
 						}
 					}
 					if (p->getUpgradeLevel(checkedUpgrade) > lastlevel) {
-						replayDat << Broodwar->getFrameCount() << "," << p->getID() << ",FinishUpgrade," << checkedUpgrade.getName() << "," << p->getUpgradeLevel(checkedUpgrade) << "\n";
+						replayDat << game->getFrameCount() << "," << p->getID() << ",FinishUpgrade," << checkedUpgrade.getName() << "," << p->getUpgradeLevel(checkedUpgrade) << "\n";
+						if (binaryDat) binaryDat->event(RGDB::FinishUpgrade, game->getFrameCount(), p->getID(), 0, checkedUpgrade.getID(), 0, 0, p->getUpgradeLevel(checkedUpgrade));
 						if (listUpgraded.count(p) > 0) {
 							listUpgraded[p].push_back(std::pair<UpgradeType, int>(checkedUpgrade, p->getUpgradeLevel(checkedUpgrade)));
 						}
 						listCurrentlyUpgrading[p].remove(checkedUpgrade);
 						//Event - upgrade complete
 					} else {
-						replayDat << Broodwar->getFrameCount() << "," << p->getID() << ",CancelUpgrade," << checkedUpgrade.getName() << "," << (p->getUpgradeLevel(checkedUpgrade) + 1) << "\n";
+						replayDat << game->getFrameCount() << "," << p->getID() << ",CancelUpgrade," << checkedUpgrade.getName() << "," << (p->getUpgradeLevel(checkedUpgrade) + 1) << "\n";
+						if (binaryDat) binaryDat->event(RGDB::CancelUpgrade, game->getFrameCount(), p->getID(), 0, checkedUpgrade.getID(), 0, 0, p->getUpgradeLevel(checkedUpgrade) + 1);
 						listCurrentlyUpgrading[p].remove(checkedUpgrade);
 						//Event - upgrade canceled
 					}
@@ -722,88 +842,97 @@ void GameData::onFrame()
 	if (CREATE_RLD) onUpdateAttacks();
 
 	// Update resources
-	if (Broodwar->getFrameCount() % RESOURCES_REFRESH == 0) {
+	if (game->getFrameCount() % RESOURCES_REFRESH == 0) {
 		for (const auto& p : activePlayers) {
-			replayDat << Broodwar->getFrameCount() << "," << p->getID() << ",R," << p->minerals() << "," << p->gas() << "," << p->gatheredMinerals() << "," << p->gatheredGas() << "," << p->supplyUsed() << "," << p->supplyTotal() << "\n";
+			replayDat << game->getFrameCount() << "," << p->getID() << ",R," << p->minerals() << "," << p->gas() << "," << p->gatheredMinerals() << "," << p->gatheredGas() << "," << p->supplyUsed() << "," << p->supplyTotal() << "\n";
+			if (binaryDat) {
+				RGDB::Resources resources = { p->minerals(), p->gas(), p->gatheredMinerals(), p->gatheredGas(), p->supplyUsed(), p->supplyTotal() };
+				binaryDat->resources(game->getFrameCount(), p->getID(), resources);
+			}
 		}
 	}
 
 	handleTechEvents();
-	if (Broodwar->getFrameCount() % 12 == 0) {
+	if (game->getFrameCount() % 12 == 0) {
 		handleVisionEvents();
 	}
 
 	// check last drop order (for attack type)
-	for (const auto& u : Broodwar->getAllUnits()) {
+	for (const auto& u : game->getAllUnits()) {
 		if (!u->getType().isBuilding() && u->getType().spaceProvided()
 			&& (u->getOrder() == Orders::Unload || u->getOrder() == Orders::MoveUnload))
-			lastDropOrderByPlayer[u->getPlayer()] = Broodwar->getFrameCount();
+			lastDropOrderByPlayer[u->getPlayer()] = game->getFrameCount();
 	}
 
 }
 
-void GameData::onReceiveText(BWAPI::Player player, std::string text)
+void GameData::onReceiveText(Dump::Player player, std::string text)
 {
-	replayDat << Broodwar->getFrameCount() << "," << player->getID() << ",SendMessage," << text << "\n";
+	replayDat << game->getFrameCount() << "," << player->getID() << ",SendMessage," << text << "\n";
+	if (binaryDat) binaryDat->text(RGDB::SendMessage, game->getFrameCount(), player->getID(), text);
 }
 
-void GameData::onPlayerLeft(BWAPI::Player player)
+void GameData::onPlayerLeft(Dump::Player player)
 {
-	replayDat << Broodwar->getFrameCount() << "," << player->getID() << ",PlayerLeftGame\n";
+	replayDat << game->getFrameCount() << "," << player->getID() << ",PlayerLeftGame\n";
+	if (binaryDat) binaryDat->event(RGDB::PlayerLeftGame, game->getFrameCount(), player->getID());
 }
 
 void GameData::onNukeDetect(BWAPI::Position target)
 {
-	replayDat << Broodwar->getFrameCount() << "," << "-1" << ",NuclearLaunch,(" << target.x << "," << target.y << ")\n";
+	replayDat << game->getFrameCount() << "," << "-1" << ",NuclearLaunch,(" << target.x << "," << target.y << ")\n";
+	if (binaryDat) binaryDat->event(RGDB::NuclearLaunch, game->getFrameCount(), -1, 0, 0, target.x, target.y);
 }
 
-std::list<int> visibility(BWAPI::PositionOrUnit target) {
+std::list<int> visibility(BWAPI::Position target) {
 	std::list<int> visible;
-	for (auto p : Broodwar->getPlayers()) Broodwar->setVision(p, false);
-	for (auto p : Broodwar->getPlayers()) {
+	for (auto p : game->getPlayers()) game->setVision(p, false);
+	for (auto p : game->getPlayers()) {
 		if (p->isObserver() || p->isNeutral()) continue;
-		Broodwar->setVision(p, true);
-		visible.push_back(Broodwar->isVisible((TilePosition)target.getPosition()));
-		Broodwar->setVision(p, false);
+		game->setVision(p, true);
+		visible.push_back(game->isVisible(TilePosition(target)));
+		game->setVision(p, false);
 	}
-	for (auto p : Broodwar->getPlayers()) Broodwar->setVision(p, true);
+	for (auto p : game->getPlayers()) game->setVision(p, true);
 	return visible;
 }
 
-void GameData::onUnitCreate(BWAPI::Unit unit)
+void GameData::onUnitCreate(Dump::Unit unit)
 {
-	replayDat << Broodwar->getFrameCount() << ","
+	replayDat << game->getFrameCount() << ","
 		<< unit->getPlayer()->getID() << ",Created," << unit->getID() << "," << unit->getType().getName()
 		<< ",(" << unit->getPosition().x << "," << unit->getPosition().y << ")";
-	//for (auto playerVis : visibility(unit)) replayDat << "," << int(playerVis);
+	//for (auto playerVis : visibility(unit->getPosition())) replayDat << "," << int(playerVis);
 	replayDat << "\n";
+	if (binaryDat) binaryDat->event(RGDB::Created, game->getFrameCount(), unit->getPlayer()->getID(), unit->getID(), unit->getType().getID(), unit->getPosition().x, unit->getPosition().y);
 
 	if (unit->getType() != BWAPI::UnitTypes::Zerg_Larva) {
 		if (activePlayers.find(unit->getPlayer()) != activePlayers.end()) { // is from an active Player
 			for (const auto& p : activePlayers) {
 				if (p == unit->getPlayer()) continue;
-				unseenUnits[p].insert(std::pair<Unit, UnitType>(unit, unit->getType()));
+				unseenUnits[p].insert(std::pair<Dump::Unit, UnitType>(unit, unit->getType()));
 			}
 		}
 	}
 }
 
-void GameData::onUnitDestroy(BWAPI::Unit unit)
+void GameData::onUnitDestroy(Dump::Unit unit)
 {
 	if (CREATE_RLD) onNewAttack(unit);
 
-	replayDat << Broodwar->getFrameCount() << "," << unit->getPlayer()->getID() << ",Destroyed," << unit->getID() << "," << unit->getType().getName() << ",(" << unit->getPosition().x << "," << unit->getPosition().y << ")";
-	//for (auto playerVis : visibility(unit)) replayDat << "," << int(playerVis);
+	replayDat << game->getFrameCount() << "," << unit->getPlayer()->getID() << ",Destroyed," << unit->getID() << "," << unit->getType().getName() << ",(" << unit->getPosition().x << "," << unit->getPosition().y << ")";
+	//for (auto playerVis : visibility(unit->getPosition())) replayDat << "," << int(playerVis);
 	replayDat << "\n";
+	if (binaryDat) binaryDat->event(RGDB::Destroyed, game->getFrameCount(), unit->getPlayer()->getID(), unit->getID(), unit->getType().getID(), unit->getPosition().x, unit->getPosition().y);
 
 	for (const auto& p : activePlayers) {
 		if (p != unit->getPlayer()) {
-			unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, unit->getType()));
+			unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, unit->getType()));
 		}
 	}
 }
 
-void GameData::onNewAttack(BWAPI::Unit unitKilled)
+void GameData::onNewAttack(Dump::Unit unitKilled)
 {
 	// A somewhat biased (because it waits for a unit to die to declare there 
 	// was an attack) heuristic to detect who attacks who
@@ -815,21 +944,21 @@ void GameData::onNewAttack(BWAPI::Unit unitKilled)
 	}
 
 	// Initialization
-	std::map<Player, Unitset> playerUnits = getPlayerMilitaryUnitsNotInAttack(
-		Broodwar->getUnitsInRadius(unitKilled->getPosition(), (int)MAX_ATTACK_RADIUS));
+	std::map<Dump::Player, Dump::Unitset, Dump::ByID> playerUnits = getPlayerMilitaryUnitsNotInAttack(
+		unitIndex.getUnitsInRadius(unitKilled->getPosition(), (int)MAX_ATTACK_RADIUS));
 
 	// Removes lonely scout (Probes, Zerglings, Obs) dying or attacks with one unit which did NO kill (epic fails)
 	if (playerUnits[unitKilled->getPlayer()].empty() || playerUnits[unitKilled->getLastAttackingPlayer()].empty())
 		return;
 
 	// It's a new attack, seek for attacking players
-	Playerset attackingPlayers = activePlayers;
-	std::map<BWAPI::Player, int> scorePlayersPosition;
+	Dump::Playerset attackingPlayers = activePlayers;
+	std::map<Dump::Player, int, Dump::ByID> scorePlayersPosition;
 	for (const auto& p : activePlayers) {
 		scorePlayersPosition.insert(std::make_pair(p, 0)); // could put a prior on the start location distance
 	}
 	for (const auto& p : activePlayers) {
-		for (Unit u : playerUnits[p]) {
+		for (Dump::Unit u : playerUnits[p]) {
 			if (u->getType().isResourceContainer()) {
 				scorePlayersPosition[p] += 12;
 			} else if (u->getType().isWorker()) {
@@ -839,7 +968,7 @@ void GameData::onNewAttack(BWAPI::Unit unitKilled)
 			}
 		}
 	}
-	Player defender = unitKilled->getPlayer();
+	Dump::Player defender = unitKilled->getPlayer();
 	int maxScore = 0;
 	for (const auto& ps : scorePlayersPosition) {
 		if (ps.second > maxScore) {
@@ -879,13 +1008,13 @@ void GameData::onNewAttack(BWAPI::Unit unitKilled)
 			radius = MIN_ATTACK_RADIUS;
 	}
 #ifdef __DEBUG_OUTPUT__
-	Broodwar->setScreenPosition(max(0, attackPos.x - 320), max(0, attackPos.y - 240));
+	game->setScreenPosition(Position(std::max(0, attackPos.x - 320), std::max(0, attackPos.y - 240)));
 #endif
 
 	/// Determine the attack type
 	std::set<AttackType> currentAttackType;
 	for (const auto& p : attackingPlayers) {
-		for (Unit tmp : playerUnits[p]) {
+		for (Dump::Unit tmp : playerUnits[p]) {
 			UnitType ut = tmp->getType();
 			std::string nameStr = ut.getName();
 			if (ut.canAttack()
@@ -894,7 +1023,7 @@ void GameData::onNewAttack(BWAPI::Unit unitKilled)
 			{
 				if (ut.isFlyer()) {
 					if (ut.spaceProvided() > 0
-						&& (Broodwar->getFrameCount() - lastDropOrderByPlayer[p]) < 24 * SECONDS_SINCE_LAST_ATTACK * 2)
+						&& (game->getFrameCount() - lastDropOrderByPlayer[p]) < 24 * SECONDS_SINCE_LAST_ATTACK * 2)
 						currentAttackType.insert(DROP);
 					else if (ut.canAttack()
 						|| ut == UnitTypes::Terran_Science_Vessel
@@ -913,23 +1042,24 @@ void GameData::onNewAttack(BWAPI::Unit unitKilled)
 	}
 
 	// Create the attack to the corresponding players
-	attacks.push_back(Attack(currentAttackType, Broodwar->getFrameCount(), attackPos, radius, defender, playerUnits));
+	attacks.push_back(Attack(currentAttackType, game->getFrameCount(), attackPos, radius, defender, playerUnits, heuristics));
 
 #ifdef __DEBUG_OUTPUT__
 	// and record it
-	for each (AttackType at in currentAttackType)
+	for (const auto& at : currentAttackType)
 	{
-		Broodwar->printf("Player %s is attacked at Position (%d,%d) type %d, %s",
-			defender->getName().c_str(), attackPos.x, attackPos.y, at, attackTypeToStr(at).c_str());
-		//replayDat << Broodwar->getFrameCount() << "," << attackTypeToStr(at).c_str() << "," << defender << "," << ",(" << attackPos.x << "," << attackPos.y <<")\n";
+		std::ostringstream buffer;
+		buffer << "Player " << defender->getName() << " is attacked at Position " << attackPos << " type " << at << ", " << attackTypeToStr(at);
+		game->printText(buffer.str());
+		//replayDat << game->getFrameCount() << "," << attackTypeToStr(at).c_str() << "," << defender << "," << ",(" << attackPos.x << "," << attackPos.y <<")\n";
 	}
 #endif
 }
 
-std::map<BWAPI::Player, BWAPI::Unitset> GameData::getPlayerMilitaryUnitsNotInAttack(const Unitset& unitsAround)
+std::map<Dump::Player, Dump::Unitset, Dump::ByID> GameData::getPlayerMilitaryUnitsNotInAttack(const Dump::Unitset& unitsAround)
 {
-	std::map<Player, Unitset> playerUnits;
-	for (const auto& p : activePlayers) playerUnits.insert(make_pair(p, Unitset()));
+	std::map<Dump::Player, Dump::Unitset, Dump::ByID> playerUnits;
+	for (const auto& p : activePlayers) playerUnits.insert(make_pair(p, Dump::Unitset()));
 	for (const auto& u : unitsAround) {
 		if (isInofensiveUnit(u)) continue;
 		bool found = false;
@@ -944,65 +1074,67 @@ std::map<BWAPI::Player, BWAPI::Unitset> GameData::getPlayerMilitaryUnitsNotInAtt
 	return playerUnits;
 }
 
-void GameData::onUnitMorph(BWAPI::Unit unit)
+void GameData::onUnitMorph(Dump::Unit unit)
 {
-	replayDat << Broodwar->getFrameCount() << "," << unit->getPlayer()->getID() << ",Morph," << unit->getID() << "," << unit->getType().getName() << ",(" << unit->getPosition().x << "," << unit->getPosition().y << ")";
-	//for (auto playerVis : visibility(unit)) replayDat << "," << int(playerVis);
+	replayDat << game->getFrameCount() << "," << unit->getPlayer()->getID() << ",Morph," << unit->getID() << "," << unit->getType().getName() << ",(" << unit->getPosition().x << "," << unit->getPosition().y << ")";
+	//for (auto playerVis : visibility(unit->getPosition())) replayDat << "," << int(playerVis);
 	replayDat << "\n";
+	if (binaryDat) binaryDat->event(RGDB::Morph, game->getFrameCount(), unit->getPlayer()->getID(), unit->getID(), unit->getType().getID(), unit->getPosition().x, unit->getPosition().y);
 
 	for (const auto& p : activePlayers) {
 		if (unit->getType() != BWAPI::UnitTypes::Zerg_Egg) {
 			if (p != unit->getPlayer()) {
 				if (unit->getType().getRace() == BWAPI::Races::Zerg) {
 					if (unit->getType() == BWAPI::UnitTypes::Zerg_Lurker) {
-						unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Hydralisk));
-						unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Lurker_Egg));
+						unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Hydralisk));
+						unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Lurker_Egg));
 					} else if (unit->getType() == BWAPI::UnitTypes::Zerg_Devourer || unit->getType() == BWAPI::UnitTypes::Zerg_Guardian) {
-						unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Mutalisk));
-						unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Cocoon));
+						unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Mutalisk));
+						unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Cocoon));
 					} else if (unit->getType().getRace() == BWAPI::Races::Zerg && unit->getType().isBuilding()) {
 						if (unit->getType() == BWAPI::UnitTypes::Zerg_Lair) {
-							unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Hatchery));
+							unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Hatchery));
 						} else if (unit->getType() == BWAPI::UnitTypes::Zerg_Hive) {
-							unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Lair));
+							unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Lair));
 						} else if (unit->getType() == BWAPI::UnitTypes::Zerg_Greater_Spire) {
-							unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Spire));
+							unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Spire));
 						} else if (unit->getType() == BWAPI::UnitTypes::Zerg_Sunken_Colony) {
-							unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Creep_Colony));
+							unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Creep_Colony));
 						} else if (unit->getType() == BWAPI::UnitTypes::Zerg_Spore_Colony) {
-							unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Creep_Colony));
+							unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Creep_Colony));
 						} else {
-							unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Drone));
+							unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Zerg_Drone));
 						}
 					}
 				} else if (unit->getType().getRace() == BWAPI::Races::Terran) {
 					if (unit->getType() == BWAPI::UnitTypes::Terran_Siege_Tank_Siege_Mode) {
-						unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Terran_Siege_Tank_Tank_Mode));
+						unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Terran_Siege_Tank_Tank_Mode));
 					} else if (unit->getType() == BWAPI::UnitTypes::Terran_Siege_Tank_Tank_Mode) {
-						unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, BWAPI::UnitTypes::Terran_Siege_Tank_Siege_Mode));
+						unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, BWAPI::UnitTypes::Terran_Siege_Tank_Siege_Mode));
 					}
 				}
 				if (activePlayers.find(unit->getPlayer()) != activePlayers.end()) {
-					unseenUnits[p].insert(std::pair<Unit, UnitType>(unit, unit->getType()));
+					unseenUnits[p].insert(std::pair<Dump::Unit, UnitType>(unit, unit->getType()));
 				}
 			}
 		}
 	}
 }
 
-void GameData::onUnitRenegade(BWAPI::Unit unit)
+void GameData::onUnitRenegade(Dump::Unit unit)
 {
-	replayDat << Broodwar->getFrameCount() << "," << unit->getPlayer()->getID() << ",ChangedOwnership," << unit->getID() << ")";
-	//for (auto playerVis : visibility(unit)) replayDat << "," << int(playerVis);
+	replayDat << game->getFrameCount() << "," << unit->getPlayer()->getID() << ",ChangedOwnership," << unit->getID() << ")";
+	//for (auto playerVis : visibility(unit->getPosition())) replayDat << "," << int(playerVis);
 	replayDat << "\n";
+	if (binaryDat) binaryDat->event(RGDB::ChangedOwnership, game->getFrameCount(), unit->getPlayer()->getID(), unit->getID());
 
 	for (const auto& p : activePlayers) {
 		if (p != unit->getPlayer()) {
 			if (activePlayers.find(unit->getPlayer()) != activePlayers.end()) {
-				unseenUnits[p].insert(std::pair<Unit, UnitType>(unit, unit->getType()));
+				unseenUnits[p].insert(std::pair<Dump::Unit, UnitType>(unit, unit->getType()));
 			}
 		} else {
-			unseenUnits[p].erase(std::pair<Unit, UnitType>(unit, unit->getType()));
+			unseenUnits[p].erase(std::pair<Dump::Unit, UnitType>(unit, unit->getType()));
 		}
 	}
 }
\ No newline at end of file
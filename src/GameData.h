@@ -1,7 +1,10 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "Utils.h"
-#include "TerrainAnalyzer.h"
+#include "MapModel.h"
+#include "RGDWriter.h"
 
 enum AttackType {
 	DROP,
@@ -10,6 +13,8 @@ enum AttackType {
 	INVIS
 };
 
+struct HeuristicsAnalyzer;
+
 struct Attack
 {
 	std::set<AttackType> types;
@@ -19,10 +24,10 @@ struct Attack
 	BWAPI::Position initPosition;
 	double radius;
 	// maximum number of units of each type "engaged" in the attack
-	std::map<BWAPI::Player, std::map<BWAPI::UnitType, int> > unitTypes;
-	std::map<BWAPI::Player, std::set<BWAPI::Unit> > battleUnits;
-	std::map<BWAPI::Player, std::set<BWAPI::Unit> > workers;
-	BWAPI::Player defender;
+	std::map<Dump::Player, std::map<BWAPI::UnitType, int>, Dump::ByID> unitTypes;
+	std::map<Dump::Player, Dump::Unitset, Dump::ByID> battleUnits;
+	std::map<Dump::Player, Dump::Unitset, Dump::ByID> workers;
+	Dump::Player defender;
 	double scoreGroundCDR;
 	double scoreGroundRegion;
 	double scoreAirCDR;
@@ -34,48 +39,80 @@ struct Attack
 	double tacticalImportanceCDR;
 	double tacticalImportanceRegion;
 	
-	Attack(const std::set<AttackType>& at, int f, BWAPI::Position p, double r, BWAPI::Player d,
-		const std::map<BWAPI::Player, BWAPI::Unitset>& units);
-	void addUnit(BWAPI::Unit u);
-	void computeScores();
+	Attack(const std::set<AttackType>& at, int f, BWAPI::Position p, double r, Dump::Player d,
+		const std::map<Dump::Player, Dump::Unitset, Dump::ByID>& units, std::map<Dump::Player, HeuristicsAnalyzer, Dump::ByID>& heuristics);
+	void addUnit(Dump::Unit u);
+	void computeScores(std::map<Dump::Player, HeuristicsAnalyzer, Dump::ByID>& heuristics);
+};
+
+// sums over the units of a player in a region or a CDR
+struct UnitAggregate
+{
+	int groundMinerals; // units fighting ground units
+	int groundGas;
+	int groundSupply;   // twice for sieged tanks
+	int airMinerals;    // units fighting air units
+	int airGas;
+	int airSupply;
+	int detectors;
+	int workingPeons;
+	int units;
+
+	UnitAggregate();
+	void add(BWAPI::UnitType ut, bool working, int sign);
 };
 
+// The attack scores of a player, kept for the whole game: what each unit adds (region, CDR, type,
+// working peon, army position) is remembered and update() only moves the units that changed
+// between two attacks, the scores are then lookups in the per region and per CDR sums.
 struct HeuristicsAnalyzer
 {
-	BWAPI::Player p;
-	std::map<BWTA::Region*, std::set<BWAPI::Unit> > unitsByRegion;
-	std::map<ChokeDepReg, std::set<BWAPI::Unit> > unitsByCDR;
-	std::map<BWTA::Region*, double> ecoRegion;
-	std::map<ChokeDepReg, double> ecoCDR;
-	std::map<BWTA::Region*, double> tacRegion;
-	std::map<ChokeDepReg, double> tacCDR;
-	std::set<ChokeDepReg> cdrSet;
-	std::set<BWAPI::Unit> emptyUnitsSet;
-
-	HeuristicsAnalyzer::HeuristicsAnalyzer(BWAPI::Player pl);
-	const std::set<BWAPI::Unit>& getUnitsCDRegion(ChokeDepReg cdr);
-	const std::set<BWAPI::Unit>& getUnitsRegion(BWTA::Region* r);
+	struct UnitContribution
+	{
+		Dump::Region* region;
+		ChokeDepReg cdr;
+		BWAPI::UnitType type;
+		bool working;
+		bool army;     // not isInofensiveUnit, in the army mean position
+		bool townhall;
+		BWAPI::Position position;
+		int update;    // last update() which saw the unit
+	};
+
+	Dump::Player p;
+	std::unordered_map<Dump::Unit, UnitContribution> contributions;
+	std::map<Dump::Region*, UnitAggregate> unitsByRegion;
+	std::map<ChokeDepReg, UnitAggregate> unitsByCDR;
+	int workingPeons;
+	int armySize;
+	int armyX; // sum of the army positions
+	int armyY;
+	Dump::Unitset townhalls;
+	int updates;
+
+	HeuristicsAnalyzer(Dump::Player pl);
+	// follows the units of p since the last call
+	void update();
+	void add(Dump::Unit u, const UnitContribution& c, int sign);
+	const UnitAggregate& getUnitsCDRegion(ChokeDepReg cdr) const;
+	const UnitAggregate& getUnitsRegion(Dump::Region* r) const;
 	// ground forces
-	double scoreUnitsGround(const std::set<BWAPI::Unit>& eUnits);
-	double scoreGround(ChokeDepReg cdr) { return scoreUnitsGround(getUnitsCDRegion(cdr)); }
-	double scoreGround(BWTA::Region* r) { return scoreUnitsGround(getUnitsRegion(r)); }
+	double scoreGround(ChokeDepReg cdr) const;
+	double scoreGround(Dump::Region* r) const;
 	// air forces
-	double scoreUnitsAir(const std::set<BWAPI::Unit>& eUnits);
-	double scoreAir(ChokeDepReg cdr) { return scoreUnitsAir(getUnitsCDRegion(cdr)); }
-	double scoreAir(BWTA::Region* r) { return scoreUnitsAir(getUnitsRegion(r)); }
+	double scoreAir(ChokeDepReg cdr) const;
+	double scoreAir(Dump::Region* r) const;
 	// detection
-	int countDetectorUnits(const std::set<BWAPI::Unit>& units);
-	double scoreDetect(ChokeDepReg cdr) { return countDetectorUnits(getUnitsCDRegion(cdr)); }
-	double scoreDetect(BWTA::Region* r) { return countDetectorUnits(getUnitsRegion(r)); }
+	double scoreDetect(ChokeDepReg cdr) const { return getUnitsCDRegion(cdr).detectors; }
+	double scoreDetect(Dump::Region* r) const { return getUnitsRegion(r).detectors; }
 	// economy
-	int countWorkingPeons(const std::set<BWAPI::Unit>& units);
-	double economicImportance(BWTA::Region* r);
-	double economicImportance(ChokeDepReg cdr);
+	double economicImportance(Dump::Region* r) const;
+	double economicImportance(ChokeDepReg cdr) const;
 	/// tactical importance = normalized relative importance of sum of the square distances
 	/// from this region to the baseS of the player + from this region to the mean position of his army
-	BWAPI::Unitset getTownhalls(const BWAPI::Unitset& units);
-	double tacticalImportance(BWTA::Region* r);
-	double tacticalImportance(ChokeDepReg cdr);
+	BWAPI::Position armyMean() const;
+	double tacticalImportance(Dump::Region* r) const;
+	double tacticalImportance(ChokeDepReg cdr) const;
 };
 
 class GameData
@@ -84,31 +121,33 @@ public:
 	GameData(); // Generates RLD file
 	~GameData();
 	void onFrame();
-	void onReceiveText(BWAPI::Player player, std::string text);
-	void onPlayerLeft(BWAPI::Player player);
+	void onReceiveText(Dump::Player player, std::string text);
+	void onPlayerLeft(Dump::Player player);
 	void onNukeDetect(BWAPI::Position target);
-	void onUnitCreate(BWAPI::Unit unit);
-	void onUnitDestroy(BWAPI::Unit unit);
-	void onUnitMorph(BWAPI::Unit unit);
-	void onUnitRenegade(BWAPI::Unit unit);
+	void onUnitCreate(Dump::Unit unit);
+	void onUnitDestroy(Dump::Unit unit);
+	void onUnitMorph(Dump::Unit unit);
+	void onUnitRenegade(Dump::Unit unit);
 
 private:
-	std::ofstream replayDat;
+	AsyncOutputFile replayDat;
+	RGDWriter* binaryDat; // same events in columns, nullptr unless CREATE_RGD_BINARY
 	std::list<Attack> attacks;
-	std::map<BWAPI::Player, int> lastDropOrderByPlayer;
+	std::map<Dump::Player, HeuristicsAnalyzer, Dump::ByID> heuristics; // scores of the attacks, by defender
+	std::map<Dump::Player, int, Dump::ByID> lastDropOrderByPlayer;
 	
-	std::map<BWAPI::Player, std::set<std::pair<BWAPI::Unit, BWAPI::UnitType> > > unseenUnits;
+	std::map<Dump::Player, std::set<std::pair<Dump::Unit, BWAPI::UnitType>, Dump::ByID>, Dump::ByID> unseenUnits;
 
-	std::map<BWAPI::Player, std::list<BWAPI::TechType> > listCurrentlyResearching;
-	std::map<BWAPI::Player, std::list<BWAPI::TechType> > listResearched;
-	std::map<BWAPI::Player, std::list<BWAPI::UpgradeType> > listCurrentlyUpgrading;
-	std::map<BWAPI::Player, std::list<std::pair<BWAPI::UpgradeType, int> > > listUpgraded;
+	std::map<Dump::Player, std::list<BWAPI::TechType>, Dump::ByID> listCurrentlyResearching;
+	std::map<Dump::Player, std::list<BWAPI::TechType>, Dump::ByID> listResearched;
+	std::map<Dump::Player, std::list<BWAPI::UpgradeType>, Dump::ByID> listCurrentlyUpgrading;
+	std::map<Dump::Player, std::list<std::pair<BWAPI::UpgradeType, int> >, Dump::ByID> listUpgraded;
 
 
 	void onUpdateAttacks();
-	void onNewAttack(BWAPI::Unit unitKilled);
-	std::map<BWAPI::Player, BWAPI::Unitset> getPlayerMilitaryUnitsNotInAttack(const BWAPI::Unitset& unitsAround);
-	void endAttack(std::list<Attack>::iterator it, BWAPI::Player loser, BWAPI::Player winner);
+	void onNewAttack(Dump::Unit unitKilled);
+	std::map<Dump::Player, Dump::Unitset, Dump::ByID> getPlayerMilitaryUnitsNotInAttack(const Dump::Unitset& unitsAround);
+	void endAttack(std::list<Attack>::iterator it, Dump::Player loser, Dump::Player winner);
 
 	void handleVisionEvents();
 	void handleTechEvents();
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <BWAPI/Position.h>
+#include <BWAPI/Color.h>
+#include <BWAPI/UnitType.h>
+#include <BWAPI/Order.h>
+#include <BWAPI/Race.h>
+#include <BWAPI/TechType.h>
+#include <BWAPI/UpgradeType.h>
+
+// Thin game/unit/player/map interface used by all the extractors (GameData, OrderData,
+// TerrainAnalyzer, CombatTracker, ActionSelection). Only the live objects are abstracted,
+// BWAPI value types (Position, UnitType, Order, ...) are used as they are since BWAPILIB
+// builds on every platform.
+// Backends:
+//   - BWAPIGame (BWAPIGame.h): adapter over BWAPI::Broodwar and BWTA, used by the DLL
+//   - MockGame (MockGame.h): in-memory game to run the extractors headless
+
+namespace Dump
+{
+	class UnitInterface;
+	class PlayerInterface;
+	class Region;
+	class Chokepoint;
+
+	typedef UnitInterface* Unit;
+	typedef PlayerInterface* Player;
+
+	// Comparator of the std containers of units and players (Unitset, std::map<Unit, T, ByID>, ...):
+	// by ID, so that iterating over them, and thus the output files, doesn't depend on memory
+	// addresses. The pairs (unit, type) are ordered by unit ID then type.
+	struct ByID
+	{
+		template <class T>
+		bool operator()(const T* a, const T* b) const
+		{
+			return (a ? a->getID() : -1) < (b ? b->getID() : -1);
+		}
+		template <class T, class U>
+		bool operator()(const std::pair<T*, U>& a, const std::pair<T*, U>& b) const
+		{
+			if ((*this)(a.first, b.first)) return true;
+			if ((*this)(b.first, a.first)) return false;
+			return a.second < b.second;
+		}
+	};
+
+	typedef std::set<Unit, ByID> Unitset;
+	typedef std::set<Player, ByID> Playerset;
+
+	class UnitInterface
+	{
+	public:
+		virtual ~UnitInterface() {}
+
+		virtual int getID() const = 0;
+		virtual bool exists() const = 0;
+		virtual BWAPI::UnitType getType() const = 0;
+		virtual Player getPlayer() const = 0;
+		virtual BWAPI::Position getPosition() const = 0;
+		virtual BWAPI::TilePosition getTilePosition() const = 0;
+		virtual BWAPI::Position getInitialPosition() const = 0;
+		virtual int getHitPoints() const = 0;
+		virtual int getShields() const = 0;
+		virtual int getEnergy() const = 0;
+		virtual int getResourceGroup() const = 0;
+		virtual int getSpaceRemaining() const = 0;
+		virtual int getGroundWeaponCooldown() const = 0;
+		virtual int getAirWeaponCooldown() const = 0;
+		virtual int getSpellCooldown() const = 0;
+		virtual Player getLastAttackingPlayer() const = 0;
+
+		virtual BWAPI::Order getOrder() const = 0;
+		virtual Unit getOrderTarget() const = 0;
+		virtual BWAPI::Position getOrderTargetPosition() const = 0;
+		virtual Unit getTarget() const = 0;
+		virtual BWAPI::Position getTargetPosition() const = 0;
+
+		virtual bool isAttacking() const = 0;
+		virtual bool isUnderAttack() const = 0;
+		virtual bool isCompleted() const = 0;
+		virtual bool isLoaded() const = 0;
+		virtual bool isFlying() const = 0;
+		virtual bool isCloaked() const = 0;
+		virtual bool isGatheringMinerals() const = 0;
+		virtual bool isGatheringGas() const = 0;
+		virtual bool isRepairing() const = 0;
+		virtual bool isConstructing() const = 0;
+
+		virtual int getDistance(BWAPI::Position target) const = 0;
+		virtual int getDistance(Unit target) const = 0; // the one of getUnitsInRadius
+		virtual Unitset getUnitsInRadius(int radius) const = 0;
+	};
+
+	class PlayerInterface
+	{
+	public:
+		virtual ~PlayerInterface() {}
+
+		virtual int getID() const = 0;
+		virtual std::string getName() const = 0;
+		virtual BWAPI::Race getRace() const = 0;
+		virtual bool isNeutral() const = 0;
+		virtual bool isObserver() const = 0;
+		virtual const Unitset& getUnits() const = 0;
+		virtual BWAPI::TilePosition getStartLocation() const = 0;
+
+		virtual int minerals() const = 0;
+		virtual int gas() const = 0;
+		virtual int gatheredMinerals() const = 0;
+		virtual int gatheredGas() const = 0;
+		virtual int supplyUsed() const = 0;
+		virtual int supplyTotal() const = 0;
+
+		virtual bool isResearching(BWAPI::TechType tech) const = 0;
+		virtual bool hasResearched(BWAPI::TechType tech) const = 0;
+		virtual bool isUpgrading(BWAPI::UpgradeType upgrade) const = 0;
+		virtual int getUpgradeLevel(BWAPI::UpgradeType upgrade) const = 0;
+	};
+
+	// Static terrain analysis (what BWTA gives us)
+	class Region
+	{
+	public:
+		virtual ~Region() {}
+
+		virtual BWAPI::Position getCenter() const = 0;
+		virtual const std::vector<BWAPI::Position>& getPolygon() const = 0;
+		virtual BWAPI::Position getPolygonCenter() const = 0; // centroid of the region polygon
+		virtual const std::set<Chokepoint*>& getChokepoints() const = 0;
+		virtual const std::set<Region*>& getReachableRegions() const = 0;
+	};
+
+	class Chokepoint
+	{
+	public:
+		virtual ~Chokepoint() {}
+
+		virtual BWAPI::Position getCenter() const = 0;
+		virtual double getWidth() const = 0;
+		virtual const std::pair<Region*, Region*>& getRegions() const = 0;
+		virtual const std::pair<BWAPI::Position, BWAPI::Position>& getSides() const = 0;
+	};
+
+	class Game
+	{
+	public:
+		virtual ~Game() {}
+
+		// game state
+		virtual int getFrameCount() const = 0;
+		virtual const Playerset& getPlayers() const = 0;
+		virtual const Unitset& getAllUnits() const = 0;
+		virtual Unitset getUnitsInRadius(BWAPI::Position center, int radius) const = 0;
+		virtual bool isVisible(BWAPI::TilePosition tp) const = 0;
+		virtual void setVision(Player player, bool enabled) = 0;
+
+		// map
+		virtual int mapWidth() const = 0;  // in build tiles
+		virtual int mapHeight() const = 0; // in build tiles
+		virtual bool isWalkable(int walkX, int walkY) const = 0; // in walk tiles (8x8 pixels)
+		bool isWalkable(BWAPI::WalkPosition wp) const { return isWalkable(wp.x, wp.y); }
+		// BWAPI::Position::isValid() needs BWAPI::Broodwar
+		bool isValid(BWAPI::Position p) const { return p.x >= 0 && p.y >= 0 && p.x < mapWidth() * BWAPI::TILE_SIZE && p.y < mapHeight() * BWAPI::TILE_SIZE; }
+		virtual std::string mapPathName() const = 0;
+		virtual std::string mapName() const = 0;
+		virtual std::string mapHash() const = 0;
+		virtual const std::vector<BWAPI::TilePosition>& getStartLocations() const = 0;
+
+		// terrain analysis
+		virtual const std::set<Region*>& getRegions() const = 0;
+		virtual const std::set<Chokepoint*>& getChokepoints() const = 0;
+		virtual Region* getRegion(BWAPI::TilePosition tp) const = 0;
+		virtual Region* getRegion(BWAPI::Position p) const = 0;
+		Region* getRegion(int x, int y) const { return getRegion(BWAPI::TilePosition(x, y)); }
+		virtual double getGroundDistance(BWAPI::TilePosition start, BWAPI::TilePosition end) const = 0;
+		virtual std::vector<BWAPI::TilePosition> getShortestPath(BWAPI::TilePosition start, BWAPI::TilePosition end) const = 0;
+
+		// debug output (no-ops when running headless)
+		virtual void printText(const std::string& text) = 0;
+		virtual void drawCircleMap(BWAPI::Position p, int radius, BWAPI::Color color, bool isSolid = false) = 0;
+		virtual void drawLineMap(BWAPI::Position a, BWAPI::Position b, BWAPI::Color color) = 0;
+		virtual void drawBoxMap(BWAPI::Position topLeft, BWAPI::Position bottomRight, BWAPI::Color color, bool isSolid = false) = 0;
+		virtual void drawTextMap(BWAPI::Position p, const std::string& text) = 0;
+		virtual void setLocalSpeed(int speed) = 0;
+		virtual void setScreenPosition(BWAPI::Position p) = 0;
+	};
+}
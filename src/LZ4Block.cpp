@@ -0,0 +1,156 @@
+#include "LZ4Block.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	const size_t MIN_MATCH = 4;
+	const size_t LAST_LITERALS = 5; // the last 5 bytes are always literals
+	const size_t MF_LIMIT = 12;     // no match starts in the last 12 bytes
+	const size_t MAX_OFFSET = 65535;
+	const int HASH_LOG = 14;
+
+	uint32_t read32(const char* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	uint32_t hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HASH_LOG);
+	}
+
+	char* writeLength(char* op, size_t length)
+	{
+		for (; length >= 255; length -= 255) *op++ = static_cast<char>(255);
+		*op++ = static_cast<char>(length);
+		return op;
+	}
+
+	char* writeSequence(char* op, const char* literals, size_t literalsLength, size_t offset, size_t matchLength)
+	{
+		char* token = op++;
+		*token = static_cast<char>((literalsLength >= 15 ? 15 : literalsLength) << 4);
+		if (literalsLength >= 15) op = writeLength(op, literalsLength - 15);
+		memcpy(op, literals, literalsLength);
+		op += literalsLength;
+		if (matchLength == 0) return op; // last literals
+		*op++ = static_cast<char>(offset & 0xFF);
+		*op++ = static_cast<char>(offset >> 8);
+		matchLength -= MIN_MATCH;
+		*token |= static_cast<char>(matchLength >= 15 ? 15 : matchLength);
+		if (matchLength >= 15) op = writeLength(op, matchLength - 15);
+		return op;
+	}
+}
+
+size_t LZ4Block::compress(const char* src, size_t srcSize, char* dst, const char* dictionary, size_t dictionarySize)
+{
+	if (dictionarySize > MAX_DICTIONARY) {
+		dictionary += dictionarySize - MAX_DICTIONARY;
+		dictionarySize = MAX_DICTIONARY;
+	}
+	// matches can reach back into the dictionary, simpler with both in the same buffer
+	std::vector<char> buffer(dictionarySize + srcSize);
+	if (dictionarySize > 0) memcpy(buffer.data(), dictionary, dictionarySize);
+	if (srcSize > 0) memcpy(buffer.data() + dictionarySize, src, srcSize);
+	const char* base = buffer.data();
+	const char* start = base + dictionarySize;
+	const char* end = start + srcSize;
+
+	char* op = dst;
+	const char* anchor = start;
+	if (srcSize > MF_LIMIT) {
+		std::vector<int32_t> table(1 << HASH_LOG, -1);
+		for (size_t p = 0; p + MIN_MATCH <= dictionarySize; ++p) table[hash(read32(base + p))] = static_cast<int32_t>(p);
+
+		const char* mfLimit = end - MF_LIMIT;
+		const char* matchLimit = end - LAST_LITERALS;
+		const char* ip = start;
+		while (ip < mfLimit) {
+			uint32_t h = hash(read32(ip));
+			int32_t ref = table[h];
+			table[h] = static_cast<int32_t>(ip - base);
+			const char* match = base + ref;
+			if (ref < 0 || static_cast<size_t>(ip - match) > MAX_OFFSET || read32(match) != read32(ip)) {
+				++ip;
+				continue;
+			}
+			while (ip > anchor && match > base && ip[-1] == match[-1]) {
+				--ip;
+				--match;
+			}
+			size_t matchLength = MIN_MATCH;
+			while (ip + matchLength < matchLimit && ip[matchLength] == match[matchLength]) ++matchLength;
+
+			op = writeSequence(op, anchor, ip - anchor, ip - match, matchLength);
+			ip += matchLength;
+			anchor = ip;
+			if (ip - 2 >= start && ip < mfLimit) table[hash(read32(ip - 2))] = static_cast<int32_t>(ip - 2 - base);
+		}
+	}
+	op = writeSequence(op, anchor, end - anchor, 0, 0);
+	return op - dst;
+}
+
+void LZ4Block::decompress(const char* src, size_t srcSize, char* dst, size_t dstSize, const char* dictionary, size_t dictionarySize)
+{
+	if (dictionarySize > MAX_DICTIONARY) {
+		dictionary += dictionarySize - MAX_DICTIONARY;
+		dictionarySize = MAX_DICTIONARY;
+	}
+	std::vector<char> buffer(dictionarySize + dstSize);
+	if (dictionarySize > 0) memcpy(buffer.data(), dictionary, dictionarySize);
+	char* base = buffer.data();
+	char* op = base + dictionarySize;
+	char* end = op + dstSize;
+	const uint8_t* ip = reinterpret_cast<const uint8_t*>(src);
+	const uint8_t* ipEnd = ip + srcSize;
+
+	for (;;) {
+		if (ip >= ipEnd) throw std::runtime_error("LZ4 block truncated");
+		uint8_t token = *ip++;
+		size_t literalsLength = token >> 4;
+		if (literalsLength == 15) {
+			uint8_t b;
+			do {
+				if (ip >= ipEnd) throw std::runtime_error("LZ4 block truncated");
+				b = *ip++;
+				literalsLength += b;
+			} while (b == 255);
+		}
+		if (literalsLength > static_cast<size_t>(ipEnd - ip) || literalsLength > static_cast<size_t>(end - op)) {
+			throw std::runtime_error("LZ4 literals out of bounds");
+		}
+		memcpy(op, ip, literalsLength);
+		op += literalsLength;
+		ip += literalsLength;
+		if (ip == ipEnd) break; // last sequence has no match
+
+		if (ipEnd - ip < 2) throw std::runtime_error("LZ4 block truncated");
+		size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<size_t>(op - base)) throw std::runtime_error("LZ4 offset out of bounds");
+		size_t matchLength = token & 15;
+		if (matchLength == 15) {
+			uint8_t b;
+			do {
+				if (ip >= ipEnd) throw std::runtime_error("LZ4 block truncated");
+				b = *ip++;
+				matchLength += b;
+			} while (b == 255);
+		}
+		matchLength += MIN_MATCH;
+		if (matchLength > static_cast<size_t>(end - op)) throw std::runtime_error("LZ4 match out of bounds");
+		const char* match = op - offset;
+		for (size_t i = 0; i < matchLength; ++i) op[i] = match[i]; // may overlap
+		op += matchLength;
+	}
+	if (op != end) throw std::runtime_error("LZ4 block size mismatch");
+	memcpy(dst, base + dictionarySize, dstSize);
+}
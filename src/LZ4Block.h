@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+// LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), so the compressed
+// blocks can also be read with the reference lz4 library (LZ4_decompress_safe_usingDict).
+// The dictionary is the history preceding the block (up to 64KB are used), each block is
+// compressed independently of the others.
+namespace LZ4Block
+{
+	const size_t MAX_DICTIONARY = 1 << 16;
+
+	inline size_t compressBound(size_t size) { return size + size / 255 + 16; }
+
+	// returns the compressed size, dst must hold compressBound(srcSize) bytes
+	size_t compress(const char* src, size_t srcSize, char* dst, const char* dictionary = nullptr, size_t dictionarySize = 0);
+	// throws std::runtime_error if src is not a valid block of exactly dstSize bytes
+	void decompress(const char* src, size_t srcSize, char* dst, size_t dstSize, const char* dictionary = nullptr, size_t dictionarySize = 0);
+}
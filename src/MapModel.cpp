@@ -0,0 +1,689 @@
+#include "MapModel.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <queue>
+
+#define MIN_CDREGION_RADIUS 9
+
+using namespace BWAPI;
+
+int hash(const BWAPI::TilePosition& p)
+{
+	return (((p.x + 1) << 16) | p.y);
+}
+
+int MapModel::hashRegionCenter(Dump::Region* r) const
+{
+	auto it = regionTable.find(r);
+	if (it != regionTable.end()) return it->second.hash;
+	/// Max size for a map is 512x512 build tiles => 512*32 = 16384 = 2^14 pixels
+	/// Unwalkable regions will map to 0
+	TilePosition p(r->getPolygonCenter());
+	return hash(p);
+}
+
+float MapModel::regionDistance(Dump::Region* from, Dump::Region* to) const
+{
+	auto i = regionTable.find(from);
+	auto j = regionTable.find(to);
+	if (i == regionTable.end() || j == regionTable.end() || i->second.index < 0 || j->second.index < 0) return -1.0f;
+	return _pfMaps.distRegions.at(i->second.index, j->second.index);
+}
+
+BWAPI::TilePosition MapModel::cdrCenter(ChokeDepReg c) const
+{
+	/// /!\ This is will give centers out of the ChokeDepRegions for some coming from Dump::Region
+	return TilePosition(((0xFFFF0000 & c) >> 16) - 1, 0x0000FFFF & c);
+}
+
+Dump::Region* MapModel::findClosestRegion(const TilePosition& tp) const
+{
+	if (tp.x >= 0 && tp.y >= 0 && tp.x < game->mapWidth() && tp.y < game->mapHeight()) {
+		int i = regionData.closestRegion[tp];
+		return i < 0 ? game->getRegion(tp) : indexedRegions[i];
+	}
+	double m = DBL_MAX;
+	Position tmp(tp);
+	Dump::Region* ret = game->getRegion(tp);
+	for (const auto& r : game->getRegions()) {
+		if (r->getCenter().getDistance(tmp) < m) {
+			m = r->getCenter().getDistance(tmp);
+			ret = r;
+		}
+	}
+	return ret;
+}
+
+ChokeDepReg MapModel::findClosestCDR(const TilePosition& tp) const
+{
+	if (tp.x >= 0 && tp.y >= 0 && tp.x < game->mapWidth() && tp.y < game->mapHeight()) {
+		int i = regionData.closestCDR[tp];
+		return i < 0 ? regionData.tiles[tp].cdr : _pfMaps.distCDR.ids[i];
+	}
+	ChokeDepReg ret = -1;
+	double m = DBL_MAX;
+	for (const auto& cdr : allChokeDepRegs) {
+		if (cdrCenter(cdr).getDistance(tp) < m) {
+			m = cdrCenter(cdr).getDistance(tp);
+			ret = cdr;
+		}
+	}
+	return ret;
+}
+
+Dump::Region* MapModel::findClosestReachableRegion(Dump::Region* q, Dump::Region* r) const
+{
+	double m = DBL_MAX;
+	Dump::Region* ret = q;
+	for (const auto& rr : game->getRegions()) {
+		if (!r->getReachableRegions().count(rr)) continue;
+		float d = regionDistance(rr, q);
+		if (d < m) {
+			m = d;
+			ret = rr;
+		}
+	}
+	return ret;
+}
+
+ChokeDepReg MapModel::findClosestReachableCDR(ChokeDepReg q, ChokeDepReg cdr) const
+{
+	double m = DBL_MAX;
+	ChokeDepReg ret = q;
+	int cdrIndex = _pfMaps.distCDR.index(cdr);
+	int qIndex = _pfMaps.distCDR.index(q);
+	if (cdrIndex < 0 || qIndex < 0) return ret;
+	for (int i = 0; i < _pfMaps.distCDR.size; ++i) {
+		if (_pfMaps.distCDR.at(cdrIndex, i) != 0.0f && _pfMaps.distCDR.at(qIndex, i) < m) {
+			m = _pfMaps.distCDR.at(i, qIndex);
+			ret = _pfMaps.distCDR.ids[i];
+		}
+	}
+	return ret;
+}
+
+void MapModel::computeLowResWalkability()
+{
+	// Build Tiles resolution
+	_lowResWalkability.assign(game->mapWidth() * game->mapHeight(), true);
+	for (int x = 0; x < game->mapWidth(); ++x) {
+		for (int y = 0; y < game->mapHeight(); ++y) {
+			for (int i = 0; i < 4; ++i) {
+				for (int j = 0; j < 4; ++j) {
+					if (!game->isWalkable(x * 4 + i, y * 4 + j)) _lowResWalkability[x + y*game->mapWidth()] = false;
+				}
+			}
+		}
+	}
+}
+
+MapModel::MapModel()
+	: centerDistances(nullptr)
+{
+	// the polygon centers are computed once per region
+	for (const auto& r : game->getRegions()) {
+		RegionEntry entry = { hash(TilePosition(r->getPolygonCenter())), -1 };
+		regionTable.insert(std::make_pair(r, entry));
+	}
+	// ActionSelection numbering
+	const std::set<Dump::Region*>& unsortedRegions = game->getRegions();
+	std::set<Dump::Region*, SortByXY> sortedRegions(unsortedRegions.begin(), unsortedRegions.end());
+	for (const auto& r : sortedRegions) {
+		regionID[r] = regionFromID.size();
+		regionFromID.push_back(r);
+	}
+	neighbors.resize(regionFromID.size());
+	for (size_t id = 0; id < regionFromID.size(); ++id) {
+		Dump::Region* region = regionFromID[id];
+		for (const auto& c : region->getChokepoints()) {
+			Dump::Region* r = c->getRegions().first != region ? c->getRegions().first : c->getRegions().second;
+			if (!regionID.count(r)) {
+				DEBUG("Not valid region, possible bug in BWTA");
+				continue;
+			}
+			neighbors[id].insert(r);
+		}
+	}
+
+	// check if the cache folder exist
+	boost::filesystem::path cachePath(TERRAIN_CACHE_FOLDER);
+	if (!boost::filesystem::exists(cachePath)) {
+		boost::filesystem::create_directories(cachePath);
+	}
+
+	boost::filesystem::path filePath(cachePath);
+	filePath /= game->mapHash() + ".terrain";
+	if (!cache.open(filePath.string(), game->mapWidth(), game->mapHeight())) {
+		computeTerrainCache(filePath.string());
+	} else if (cache.header().sortedRegions != regionFromID.size()) {
+		LOG("[TERRAIN] " << filePath.string() << " rejected (other regions), computing it again");
+		computeTerrainCache(filePath.string());
+	}
+
+	// regions data and distances in place in the cache
+	const TerrainCache::Header& header = cache.header();
+	regionData.tiles = TileGrid<TerrainCache::Tile>(cache.array<TerrainCache::Tile>(header.tiles), header.width, header.height);
+	regionData.closestRegion = TileGrid<int32_t>(cache.array<int32_t>(header.closestRegions), header.width, header.height);
+	regionData.closestCDR = TileGrid<int32_t>(cache.array<int32_t>(header.closestCDRs), header.width, header.height);
+	regionData.closestWalkable = TileGrid<int32_t>(cache.array<int32_t>(header.closestWalkable), header.width, header.height);
+	_pfMaps.regionsPFCenters = cache.array<int32_t>(header.regionCenters);
+	_pfMaps.distRegions.ids = cache.array<int32_t>(header.regionIds);
+	_pfMaps.distRegions.size = header.regions;
+	_pfMaps.distRegions.distances = cache.array<uint16_t>(header.regionDistances);
+	_pfMaps.distCDR.ids = cache.array<int32_t>(header.cdrIds);
+	_pfMaps.distCDR.size = header.cdrs;
+	_pfMaps.distCDR.distances = cache.array<uint16_t>(header.cdrDistances);
+	regionIdMap = TileGrid<int32_t>(cache.array<int32_t>(header.sortedRegionMap), header.width, header.height);
+	centerDistances = cache.array<int32_t>(header.sortedRegionDistances);
+	// initialize allChokeDepRegs
+	allChokeDepRegs.insert(_pfMaps.distCDR.ids, _pfMaps.distCDR.ids + _pfMaps.distCDR.size);
+	indexedRegions.assign(_pfMaps.distRegions.size, nullptr);
+	for (const auto& r : game->getRegions()) {
+		RegionEntry& entry = regionTable[r];
+		entry.index = _pfMaps.distRegions.index(entry.hash);
+		if (entry.index >= 0 && indexedRegions[entry.index] == nullptr) indexedRegions[entry.index] = r;
+	}
+}
+
+// CDR of each build tile (labels[x + y * width]), -1 if it is in no region
+void MapModel::computeChokeDependantRegions(std::vector<ChokeDepReg>& labels)
+{
+	PROFILE_SPAN("MapModel::computeChokeDependantRegions");
+	int width = game->mapWidth();
+	int height = game->mapHeight();
+	labels.assign(width * height, -1);
+	std::vector<Dump::Chokepoint*> chokes(game->getChokepoints().begin(), game->getChokepoints().end());
+	/// 1. for each region, max radius = max(MIN_CDREGION_RADIUS, choke size)
+	std::vector<int> maxTiles; // max tiles for each CDRegion
+	for (const auto& c : chokes) {
+		maxTiles.push_back(std::max(MIN_CDREGION_RADIUS, static_cast<int>(c->getWidth()) / TILE_SIZE));
+	}
+	/// 2. Voronoi on both choke regions: the getGroundDistance from every tile to each choke center
+	/// comes from one Dijkstra over the whole map per choke (a path to a tile of the disk can leave
+	/// it), only the tiles of the disk in the choke regions are candidates
+	struct Candidate { int tile; double tileDist; double pathFindDist; };
+	std::vector<std::vector<Candidate> > candidates(chokes.size());
+	parallelFor(chokes.size(), [&](size_t c) {
+		TilePosition chokeCenter(chokes[c]->getCenter().x / TILE_SIZE, chokes[c]->getCenter().y / TILE_SIZE);
+		if (chokeCenter.x < 0 || chokeCenter.y < 0 || chokeCenter.x >= width || chokeCenter.y >= height) return;
+		std::vector<double> dist;
+		groundDistances(chokeCenter, dist, nullptr, true);
+		int radius = maxTiles[c];
+		for (int x = std::max(0, chokeCenter.x - radius); x <= std::min(width - 1, chokeCenter.x + radius); ++x) {
+			for (int y = std::max(0, chokeCenter.y - radius); y <= std::min(height - 1, chokeCenter.y + radius); ++y) {
+				TilePosition tmp(x, y);
+				double tmpDist = tmp.getDistance(chokeCenter);
+				Dump::Region* r = game->getRegion(tmp);
+				if (tmpDist <= 1.0 * radius && dist[x + y*width] >= 0.0 // -1 means no way to go there
+					&& (chokes[c]->getRegions().first == r || chokes[c]->getRegions().second == r))
+				{
+					Candidate candidate = { x + y*width, tmpDist, dist[x + y*width] };
+					candidates[c].push_back(candidate);
+				}
+			}
+		}
+	});
+	/// each tile goes to the closest choke, the first one on ties, with the tests of the loop over
+	/// the tiles and the chokes it replaces (the tile distance is compared to the ground distance)
+	std::vector<double> minDist(width * height, DBL_MAX - 100.0);
+	for (size_t c = 0; c < chokes.size(); ++c) {
+		TilePosition chokeCenter(chokes[c]->getCenter().x / TILE_SIZE, chokes[c]->getCenter().y / TILE_SIZE);
+		for (const auto& candidate : candidates[c]) {
+			if (candidate.tileDist < minDist[candidate.tile] && candidate.pathFindDist < minDist[candidate.tile]) {
+				minDist[candidate.tile] = candidate.pathFindDist;
+				labels[candidate.tile] = hash(chokeCenter);
+			}
+		}
+	}
+	/// 3. Complete with (amputated) BWTA regions
+	for (int x = 0; x < width; ++x) {
+		for (int y = 0; y < height; ++y) {
+			TilePosition tmp(x, y);
+			if (labels[x + y*width] == -1 && game->getRegion(tmp) != NULL) {
+				labels[x + y*width] = hashRegionCenter(game->getRegion(tmp));
+			}
+		}
+	}
+}
+
+void MapModel::computeTerrainCache(const std::string& path)
+{
+	PROFILE_SPAN("MapModel::computeTerrainCache");
+	int width = game->mapWidth();
+	int height = game->mapHeight();
+	computeLowResWalkability();
+	std::vector<ChokeDepReg> labels;
+	computeChokeDependantRegions(labels);
+	TerrainCache::Data data;
+	computeClosestWalkable(data.closestWalkable);
+	regionData.closestWalkable = TileGrid<int32_t>(data.closestWalkable.data(), width, height); // for findClosestWalkable
+
+	/// All the distances come from one Dijkstra per source (groundDistances) instead of a
+	/// getGroundDistance/getShortestPath per pair, the sources are spread on TERRAIN_THREADS
+	std::vector<Dump::Region*> regions(game->getRegions().begin(), game->getRegions().end());
+	auto distanceTo = [&](const std::vector<double>& dist, const TilePosition& tp) {
+		if (tp.x < 0 || tp.y < 0 || tp.x >= width || tp.y >= height) return -1.0;
+		return dist[tp.x + tp.y*width];
+	};
+
+	/// Fill regionsPFCenters (regions pathfinding aware centers, 
+	/// min of the sum of the distance to chokes on paths between/to chokes)
+	std::vector<Position> pfCenters(regions.size());
+	{
+		PROFILE_SPAN("MapModel::regionsPFCenters");
+		parallelFor(regions.size(), [&](size_t i) {
+			Dump::Region* r = regions[i];
+			std::vector<Position> chokesCenters;
+			for (const auto& c : r->getChokepoints()) {
+				chokesCenters.push_back(c->getCenter());
+			}
+			if (chokesCenters.empty()) {
+				pfCenters[i] = r->getCenter();
+				return;
+			}
+			std::vector<std::vector<double> > chokesDist(chokesCenters.size());
+			std::vector<std::vector<int> > chokesParents(chokesCenters.size());
+			for (size_t c = 0; c < chokesCenters.size(); ++c) {
+				groundDistances(TilePosition(chokesCenters[c]), chokesDist[c], &chokesParents[c]);
+			}
+			std::vector<TilePosition> validTilePositions;
+			for (size_t c1 = 0; c1 < chokesCenters.size(); ++c1) {
+				for (size_t c2 = 0; c2 < chokesCenters.size(); ++c2) {
+					TilePosition end(chokesCenters[c2]);
+					if (chokesCenters[c1] == chokesCenters[c2] || distanceTo(chokesDist[c1], end) < 0.0) continue;
+					size_t first = validTilePositions.size();
+					for (int idx = end.x + end.y*width; idx != -1; idx = chokesParents[c1][idx]) {
+						validTilePositions.push_back(TilePosition(idx % width, idx / width));
+					}
+					std::reverse(validTilePositions.begin() + first, validTilePositions.end());
+				}
+			}
+			double minDist = DBL_MAX;
+			TilePosition centerCandidate = TilePosition(r->getCenter());
+			for (const auto& vp : validTilePositions) {
+				double tmp = 0.0;
+				for (const auto& dist : chokesDist) {
+					tmp += dist[vp.x + vp.y*width];
+				}
+				if (tmp < minDist) {
+					minDist = tmp;
+					centerCandidate = vp;
+				}
+			}
+			pfCenters[i] = Position(centerCandidate);
+		});
+	}
+
+	/// Fill distRegions with the mean distance between each Regions
+	/// -1 if the 2 Regions are not mutually/inter accessible by ground
+	std::vector<TilePosition> regionSources;
+	for (const auto& c : pfCenters) {
+		regionSources.push_back(TilePosition(c));
+	}
+	std::vector<std::vector<double> > regionDist(regions.size());
+	{
+		PROFILE_SPAN("MapModel::distRegions");
+		parallelFor(regions.size(), [&](size_t i) {
+			std::vector<double> dist;
+			groundDistances(regionSources[i], dist, nullptr);
+			for (const auto& tp : regionSources) {
+				regionDist[i].push_back(distanceTo(dist, tp));
+			}
+		});
+	}
+	/// the distance of a pair is the one from the first of the two regions,
+	/// the center of a hash is the one of the first region
+	std::vector<int32_t> regionIds;
+	for (const auto& r : regions) {
+		regionIds.push_back(hashRegionCenter(r));
+	}
+	std::vector<int32_t> sortedIds(regionIds);
+	std::sort(sortedIds.begin(), sortedIds.end());
+	sortedIds.erase(std::unique(sortedIds.begin(), sortedIds.end()), sortedIds.end());
+	std::vector<size_t> rank;
+	for (const auto& id : regionIds) {
+		rank.push_back(std::lower_bound(sortedIds.begin(), sortedIds.end(), id) - sortedIds.begin());
+	}
+	std::vector<int32_t> regionCenters(sortedIds.size() * 2);
+	for (size_t i = regions.size(); i-- > 0;) {
+		regionCenters[rank[i] * 2] = pfCenters[i].x;
+		regionCenters[rank[i] * 2 + 1] = pfCenters[i].y;
+	}
+	std::vector<double> regionMatrix(sortedIds.size() * sortedIds.size(), -1.0);
+	for (size_t i = 0; i < regions.size(); ++i) {
+		for (size_t j = 0; j < regions.size(); ++j) {
+			regionMatrix[rank[i] * sortedIds.size() + rank[j]] = i == j ? 0.0 : regionDist[std::min(i, j)][std::max(i, j)];
+		}
+	}
+
+	/// Fill distCDR
+	/// -1 if the 2 Regions are not mutually/inter accessible by ground
+	std::vector<ChokeDepReg> cdrs;
+	for (const auto& label : labels) {
+		if (label != -1) cdrs.push_back(label);
+	}
+	std::sort(cdrs.begin(), cdrs.end());
+	cdrs.erase(std::unique(cdrs.begin(), cdrs.end()), cdrs.end());
+	/// from the closest walkable tile of the CDR to its center (the first in x then y order on ties),
+	/// or the closest walkable tile if the CDR has none
+	std::vector<TilePosition> cdrSources;
+	std::vector<int> cdrSourceDist(cdrs.size(), INT_MAX);
+	for (const auto& cdr : cdrs) {
+		cdrSources.push_back(findClosestWalkable(cdrCenter(cdr)));
+	}
+	for (int x = 0; x < width; ++x) {
+		for (int y = 0; y < height; ++y) {
+			if (labels[x + y*width] == -1 || !_lowResWalkability[x + y*width]) continue;
+			size_t i = std::lower_bound(cdrs.begin(), cdrs.end(), labels[x + y*width]) - cdrs.begin();
+			TilePosition center = cdrCenter(cdrs[i]);
+			int d = (x - center.x) * (x - center.x) + (y - center.y) * (y - center.y);
+			if (d < cdrSourceDist[i]) {
+				cdrSourceDist[i] = d;
+				cdrSources[i] = TilePosition(x, y);
+			}
+		}
+	}
+	std::vector<std::vector<double> > cdrDist(cdrs.size());
+	{
+		PROFILE_SPAN("MapModel::distCDR");
+		parallelFor(cdrs.size(), [&](size_t i) {
+			std::vector<double> dist;
+			groundDistances(cdrSources[i], dist, nullptr);
+			for (const auto& tp : cdrSources) {
+				cdrDist[i].push_back(distanceTo(dist, tp));
+			}
+		});
+	}
+	std::vector<double> cdrMatrix(cdrs.size() * cdrs.size());
+	for (size_t i = 0; i < cdrs.size(); ++i) {
+		for (size_t j = 0; j < cdrs.size(); ++j) {
+			cdrMatrix[i * cdrs.size() + j] = i == j ? 0.0 : cdrDist[std::min(i, j)][std::max(i, j)];
+		}
+	}
+
+	/// Closest region center and closest CDR center of each tile (findClosestRegion, findClosestCDR),
+	/// the first region (game order) or CDR (id order) on ties
+	std::vector<Position> centers;
+	for (const auto& r : regions) {
+		centers.push_back(r->getCenter());
+	}
+	std::vector<TilePosition> cdrCenters;
+	for (const auto& cdr : cdrs) {
+		cdrCenters.push_back(cdrCenter(cdr));
+	}
+	data.closestRegions.assign(width * height, -1);
+	data.closestCDRs.assign(width * height, -1);
+	{
+		PROFILE_SPAN("MapModel::closestCenters");
+		parallelFor(height, [&](size_t row) {
+			int y = static_cast<int>(row);
+			for (int x = 0; x < width; ++x) {
+				int m = INT_MAX;
+				for (size_t i = 0; i < centers.size(); ++i) {
+					int dx = centers[i].x - x * TILE_SIZE;
+					int dy = centers[i].y - y * TILE_SIZE;
+					if (dx * dx + dy * dy < m) {
+						m = dx * dx + dy * dy;
+						data.closestRegions[x + y * width] = static_cast<int32_t>(rank[i]);
+					}
+				}
+				m = INT_MAX;
+				for (size_t i = 0; i < cdrCenters.size(); ++i) {
+					int dx = cdrCenters[i].x - x;
+					int dy = cdrCenters[i].y - y;
+					if (dx * dx + dy * dy < m) {
+						m = dx * dx + dy * dy;
+						data.closestCDRs[x + y * width] = static_cast<int32_t>(i);
+					}
+				}
+			}
+		});
+	}
+
+	/// CDR, region and walkability of each tile
+	std::map<Dump::Region*, int16_t> regionIndex;
+	for (size_t i = 0; i < regions.size(); ++i) {
+		regionIndex.insert(std::make_pair(regions[i], static_cast<int16_t>(rank[i])));
+	}
+	data.tiles.resize(width * height);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			TerrainCache::Tile& tile = data.tiles[x + y * width];
+			tile.cdr = labels[x + y * width];
+			auto r = regionIndex.find(game->getRegion(TilePosition(x, y)));
+			tile.region = r == regionIndex.end() ? -1 : r->second;
+			tile.walkable = _lowResWalkability[x + y * width];
+			tile.padding = 0;
+		}
+	}
+
+	/// ActionSelection: RegionID of each tile, and ground distances between the region centers as
+	/// getGroundDistance gives them (BWTA in StarCraft, recorded in the traces for MockGame)
+	std::vector<Dump::Region*> nearest = nearestRegions();
+	data.sortedRegionMap.resize(width * height);
+	for (int i = 0; i < width * height; ++i) {
+		auto it = regionID.find(nearest[i]);
+		data.sortedRegionMap[i] = it == regionID.end() ? 0 : static_cast<int32_t>(it->second);
+	}
+	size_t n = regionFromID.size();
+	data.sortedRegions = n;
+	data.sortedRegionDistances.resize(n * n);
+	{
+		PROFILE_SPAN("MapModel::sortedRegionDistances");
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t j = 0; j < n; ++j) {
+				Position pos1 = regionFromID[i]->getCenter();
+				Position pos2 = regionFromID[j]->getCenter();
+				// sometimes the center of the region is in an unwalkable area
+				if (game->isWalkable(BWAPI::WalkPosition(pos1)) &&
+					game->isWalkable(BWAPI::WalkPosition(pos2))) {
+					data.sortedRegionDistances[i * n + j] = (int)game->getGroundDistance(BWAPI::TilePosition(pos1), BWAPI::TilePosition(pos2));
+				} else { // TODO improve this to get a proper position and compute groundDistance
+					data.sortedRegionDistances[i * n + j] = (int)pos1.getDistance(pos2);
+				}
+			}
+		}
+	}
+
+	data.regionIds.swap(sortedIds);
+	data.regionCenters.swap(regionCenters);
+	data.regionDistances.swap(regionMatrix);
+	data.cdrIds.swap(cdrs);
+	data.cdrDistances.swap(cdrMatrix);
+	cache.create(path, width, height, data);
+	std::vector<bool>().swap(_lowResWalkability);
+}
+
+// distances as getGroundDistance from source to every build tile, -1 where there is no way. The cost
+// model of BWTA's AstarSearchDistance: 8 neighbors on the low resolution walkability, 10 straight and
+// 14 diagonal (g * 32 / 10 pixels), no diagonal between two unwalkable tiles, the start does not need
+// to be walkable. toSource: getGroundDistance from every build tile to source instead, the tiles may
+// then be unwalkable and source may not. parents: previous tile on the shortest paths.
+void MapModel::groundDistances(const TilePosition& source, std::vector<double>& dist, std::vector<int>* parents, bool toSource) const
+{
+	int width = game->mapWidth();
+	int height = game->mapHeight();
+	dist.assign(width * height, -1.0);
+	if (parents) parents->assign(width * height, -1);
+	if (source.x < 0 || source.y < 0 || source.x >= width || source.y >= height) return;
+
+	typedef std::pair<int, int> Node; // g, tile
+	std::vector<int> g(width * height, INT_MAX);
+	std::priority_queue<Node, std::vector<Node>, std::greater<Node> > open;
+	g[source.x + source.y*width] = 0;
+	open.push(Node(0, source.x + source.y*width));
+	while (!open.empty()) {
+		Node n = open.top();
+		open.pop();
+		if (n.first > g[n.second]) continue;
+		dist[n.second] = n.first * 32.0 / 10.0;
+		if (toSource && !_lowResWalkability[n.second]) continue; // only the first tile of a path
+		int x = n.second % width;
+		int y = n.second / width;
+		for (int dx = -1; dx <= 1; ++dx) {
+			for (int dy = -1; dy <= 1; ++dy) {
+				int nx = x + dx;
+				int ny = y + dy;
+				if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= width || ny >= height
+					|| (!toSource && !_lowResWalkability[nx + ny*width])
+					|| (dx != 0 && dy != 0 && !_lowResWalkability[x + ny*width] && !_lowResWalkability[nx + y*width])) continue;
+				int d = n.first + ((dx != 0 && dy != 0) ? 14 : 10);
+				int idx = nx + ny*width;
+				if (d < g[idx]) {
+					g[idx] = d;
+					if (parents) (*parents)[idx] = n.second;
+					open.push(Node(d, idx));
+				}
+			}
+		}
+	}
+}
+
+bool MapModel::isWalkable(const TilePosition& tp) const
+{
+	return regionData.tiles[tp].walkable != 0;
+}
+
+// closest walkable build tile (the first in x then y order on ties), tp if there is none
+BWAPI::TilePosition MapModel::findClosestWalkable(const BWAPI::TilePosition& tp) const
+{
+	int width = game->mapWidth();
+	int x = std::max(0, std::min(width - 1, tp.x));
+	int y = std::max(0, std::min(game->mapHeight() - 1, tp.y));
+	int closest = regionData.closestWalkable(x, y);
+	return closest < 0 ? tp : TilePosition(closest % width, closest / width);
+}
+
+// Exact closest walkable build tile of each tile (x + y * width), -1 if the map has none: the two
+// passes of the squared euclidean distance transform of Felzenszwalb & Huttenlocher, closest tile in
+// the column then lower envelope of the parabolas (x - x')^2 + dy(x')^2 along the rows.
+// Ties go to the smallest x then y, as a scan of the map.
+void MapModel::computeClosestWalkable(std::vector<int32_t>& closest) const
+{
+	PROFILE_SPAN("MapModel::computeClosestWalkable");
+	int width = game->mapWidth();
+	int height = game->mapHeight();
+	std::vector<int> column(width * height, -1); // y of the closest walkable tile of the column
+	parallelFor(width, [&](size_t x) {
+		int* c = &column[x * height];
+		int last = -1;
+		for (int y = 0; y < height; ++y) {
+			if (_lowResWalkability[x + y*width]) last = y;
+			c[y] = last;
+		}
+		last = -1;
+		for (int y = height - 1; y >= 0; --y) {
+			if (_lowResWalkability[x + y*width]) last = y;
+			if (last >= 0 && (c[y] < 0 || last - y < y - c[y])) c[y] = last;
+		}
+	});
+
+	closest.assign(width * height, -1);
+	parallelFor(height, [&](size_t row) {
+		int y = static_cast<int>(row);
+		std::vector<int> v(width); // columns of the parabolas of the envelope
+		std::vector<double> z(width + 1); // v[k] is the lowest from z[k] to z[k + 1]
+		auto f = [&](int x) { double dy = column[x * height + y] - y; return dy * dy + static_cast<double>(x) * x; };
+		int k = -1;
+		for (int q = 0; q < width; ++q) {
+			if (column[q * height + y] < 0) continue;
+			double s = 0.0;
+			while (k >= 0) {
+				s = (f(q) - f(v[k])) / (2.0 * (q - v[k]));
+				if (s > z[k]) break;
+				--k;
+			}
+			if (k < 0) {
+				z[0] = -DBL_MAX;
+			} else {
+				z[k + 1] = s;
+			}
+			v[++k] = q;
+			z[k + 1] = DBL_MAX;
+		}
+		if (k < 0) return;
+		for (int x = 0, j = 0; x < width; ++x) {
+			while (z[j + 1] < x) ++j;
+			closest[x + y * width] = v[j] + column[v[j] * height + y] * width;
+		}
+	});
+}
+
+// Region of each build tile (x + y * width). A tile without region gets the region of the first tile
+// with one on a spiral around it, the spiral walks the squares around the tile one after the other
+// (ring r: tiles at Chebyshev distance r, spiral indices (2r-1)^2 to (2r+1)^2) so a BFS from the tiles
+// with a region gives the only ring to search.
+std::vector<Dump::Region*> MapModel::nearestRegions() const
+{
+	int width = game->mapWidth();
+	int height = game->mapHeight();
+	std::vector<Dump::Region*> nearest(width * height, nullptr);
+	std::vector<int> ring(width * height, -1);
+	std::vector<int> open;
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			nearest[x + y * width] = game->getRegion(x, y);
+			if (nearest[x + y * width] != nullptr) {
+				ring[x + y * width] = 0;
+				open.push_back(x + y * width);
+			}
+		}
+	}
+	for (size_t i = 0; i < open.size(); ++i) {
+		int x = open[i] % width;
+		int y = open[i] / width;
+		for (int dx = -1; dx <= 1; ++dx) {
+			for (int dy = -1; dy <= 1; ++dy) {
+				int nx = x + dx;
+				int ny = y + dy;
+				if (nx < 0 || ny < 0 || nx >= width || ny >= height || ring[nx + ny * width] != -1) continue;
+				ring[nx + ny * width] = ring[open[i]] + 1;
+				open.push_back(nx + ny * width);
+			}
+		}
+	}
+
+	// offsets of the spiral, turning counter clockwise, until its side reaches the map width
+	std::vector<std::pair<int, int> > spiral;
+	int length = 1;
+	int j = 0;
+	bool first = true;
+	int dx = 0;
+	int dy = 1;
+	for (int x = 0, y = 0; length < width;) {
+		spiral.push_back(std::make_pair(x, y));
+		x += dx;
+		y += dy;
+		if (++j == length) {
+			j = 0;
+			if (!first) length++;
+			first = !first;
+			if (dx == 0) {
+				dx = dy;
+				dy = 0;
+			} else {
+				dy = -dx;
+				dx = 0;
+			}
+		}
+	}
+
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			int r = ring[x + y * width];
+			if (r <= 0) continue; // has a region, or there is no region at all
+			size_t end = std::min(spiral.size(), static_cast<size_t>((2 * r + 1) * (2 * r + 1)));
+			for (size_t i = (2 * r - 1) * (2 * r - 1); i < end; ++i) {
+				int tx = x + spiral[i].first;
+				int ty = y + spiral[i].second;
+				if (tx >= 0 && ty >= 0 && tx < width && ty < height && ring[tx + ty * width] == 0) {
+					nearest[x + y * width] = nearest[tx + ty * width];
+					break;
+				}
+			}
+		}
+	}
+	return nearest;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+#include "boost/filesystem.hpp"
+
+#include "Utils.h"
+#include "TerrainCache.h"
+#include "TileGrid.h"
+
+typedef int ChokeDepReg;
+using RegionID = size_t; // ActionSelection numbering of the regions, see MapModel
+
+// Distances between regions (or CDRs), in a row-major matrix indexed by the rank of their ids,
+// a view of the TerrainCache
+struct DistanceMatrix
+{
+	const int32_t* ids; // hashRegionCenter or ChokeDepReg of each index, sorted
+	int size;
+	const uint16_t* distances; // size x size, pixels rounded down, TerrainCache::NO_PATH if not accessible by ground
+
+	DistanceMatrix() : ids(nullptr), size(0), distances(nullptr) {}
+	int index(int id) const // -1 if unknown
+	{
+		const int32_t* it = std::lower_bound(ids, ids + size, id);
+		return it != ids + size && *it == id ? static_cast<int>(it - ids) : -1;
+	}
+	float at(int i, int j) const // -1 if not accessible by ground
+	{
+		uint16_t d = distances[i * size + j];
+		return d == TerrainCache::NO_PATH ? -1.0f : d;
+	}
+	float operator()(int from, int to) const // by ids, -1 if one is unknown
+	{
+		int i = index(from);
+		int j = index(to);
+		return i < 0 || j < 0 ? -1.0f : at(i, j);
+	}
+};
+
+struct PathAwareMaps
+{
+	const int32_t* regionsPFCenters; // Pathfinding wise region centers, x and y pixels of each distRegions index
+	DistanceMatrix distRegions; // distRegions(R1, R2) w.r.t regionsPFCenters
+	DistanceMatrix distCDR;
+
+	PathAwareMaps() : regionsPFCenters(nullptr) {}
+};
+
+struct RegionsData
+{
+	TileGrid<TerrainCache::Tile> tiles; // CDR (-1 -> unwalkable regions), region index and walkability
+	TileGrid<int32_t> closestRegion; // index in _pfMaps.distRegions of the closest region center, -1 if no region
+	TileGrid<int32_t> closestCDR; // index in _pfMaps.distCDR of the closest CDR center, -1 if no CDR
+	TileGrid<int32_t> closestWalkable; // x + y * width of the closest walkable tile, -1 if none
+};
+
+// Neither Region* (of course) nor the ordering in the Regions set is
+// deterministic, so we have a map which maps Region* to a unique int
+// which is region's center (0)<x Position + 1><y Position>
+// on                               16 bits      16 bits
+
+struct SortByXY
+{
+	bool operator ()(const Dump::Region* const &lReg, const Dump::Region* const &rReg) const
+	{
+		BWAPI::Position lPos = lReg->getCenter();
+		BWAPI::Position rPos = rReg->getCenter();
+		if (lPos.x == rPos.x) {
+			return lPos.y < rPos.y;
+		} else {
+			return lPos.x < rPos.x;
+		}
+	}
+
+	bool operator ()(const Dump::Chokepoint* const &lReg, const Dump::Chokepoint* const &rReg) const
+	{
+		BWAPI::Position lPos = lReg->getCenter();
+		BWAPI::Position rPos = rReg->getCenter();
+		if (lPos.x == rPos.x) {
+			return lPos.y < rPos.y;
+		} else {
+			return lPos.x < rPos.x;
+		}
+	}
+};
+
+// The static analysis of the map, done once per replay and shared by the extractors (TerrainAnalyzer,
+// GameData, ActionSelection): the regions and CDRs, their indices, distances and neighbors, and the
+// per tile grids. Everything that costs more than a pass on the regions is computed once per map and
+// kept in TERRAIN_CACHE_FOLDER/$mapHash.terrain (TerrainCache.h).
+class MapModel
+{
+public:
+	RegionsData regionData;
+	PathAwareMaps _pfMaps;
+	std::set<ChokeDepReg> allChokeDepRegs;
+
+	// ActionSelection numbering: the RegionID of a region is its rank in SortByXY order
+	std::map<Dump::Region*, RegionID> regionID;
+	std::vector<Dump::Region*> regionFromID;
+	TileGrid<int32_t> regionIdMap; // RegionID of each tile, of the first region on a spiral around it if it has none
+
+	MapModel(); // maps the cache of the map, computes and writes it first if needed
+
+	bool isWalkable(const BWAPI::TilePosition& tp) const;
+	BWAPI::TilePosition findClosestWalkable(const BWAPI::TilePosition& tp) const;
+	Dump::Region* findClosestRegion(const BWAPI::TilePosition& tp) const;
+	ChokeDepReg findClosestCDR(const BWAPI::TilePosition& tp) const;
+	Dump::Region* findClosestReachableRegion(Dump::Region* q, Dump::Region* r) const;
+	ChokeDepReg findClosestReachableCDR(ChokeDepReg q, ChokeDepReg cdr) const;
+	int hashRegionCenter(Dump::Region* r) const;
+	float regionDistance(Dump::Region* from, Dump::Region* to) const; // _pfMaps.distRegions of two regions, -1 if unknown
+	BWAPI::TilePosition cdrCenter(ChokeDepReg c) const;
+	// ground distance between the centers of two regions (RegionID), as BWTA gives it
+	int distanceBetweenRegions(RegionID from, RegionID to) const
+	{
+		assert(from < regionFromID.size() && to < regionFromID.size());
+		return centerDistances[from * regionFromID.size() + to];
+	}
+	const std::set<Dump::Region*>& getNeighbors(RegionID regId) const { return neighbors.at(regId); }
+
+private:
+	std::vector<bool> _lowResWalkability; // while computing the cache
+	TerrainCacheFile cache; // regionData, _pfMaps, regionIdMap and centerDistances point into it
+	std::vector<Dump::Region*> indexedRegions; // region of each _pfMaps.distRegions index
+	struct RegionEntry { int hash; int index; }; // hashRegionCenter and _pfMaps.distRegions index (-1 if none)
+	std::unordered_map<Dump::Region*, RegionEntry> regionTable; // every region of the map, built once
+	const int32_t* centerDistances; // regionFromID.size() x regionFromID.size()
+	std::vector<std::set<Dump::Region*> > neighbors; // regions across the chokepoints of each RegionID
+
+	void computeLowResWalkability();
+	void computeChokeDependantRegions(std::vector<ChokeDepReg>& labels);
+	void computeTerrainCache(const std::string& path);
+	void computeClosestWalkable(std::vector<int32_t>& closest) const;
+	std::vector<Dump::Region*> nearestRegions() const;
+	void groundDistances(const BWAPI::TilePosition& source, std::vector<double>& dist, std::vector<int>* parents, bool toSource = false) const;
+};
@@ -0,0 +1,355 @@
+#include "MockGame.h"
+
+#include <queue>
+#include <list>
+#include <functional>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+using namespace BWAPI;
+
+// ====================================================================================
+// MockUnit
+// ====================================================================================
+
+MockUnit::MockUnit(MockGame* game, int id, BWAPI::UnitType type, MockPlayer* player, BWAPI::Position position)
+	: id(id),
+	type(type),
+	player(player),
+	position(position),
+	initialPosition(position),
+	hitPoints(type.maxHitPoints()),
+	shields(type.maxShields()),
+	energy(0),
+	resourceGroup(0),
+	spaceRemaining(type.spaceProvided()),
+	groundWeaponCooldown(0),
+	airWeaponCooldown(0),
+	spellCooldown(0),
+	lastAttackingPlayer(nullptr),
+	order(Orders::Nothing),
+	orderTarget(nullptr),
+	orderTargetPosition(Positions::None),
+	target(nullptr),
+	targetPosition(position), // BWAPI gives the unit position when it has no target
+	flags(Exists | Completed),
+	game(game)
+{
+	setFlag(Flying, type.isFlyer());
+}
+
+Dump::Player MockUnit::getPlayer() const
+{
+	return player;
+}
+
+BWAPI::TilePosition MockUnit::getTilePosition() const
+{
+	// BWAPI gives the top left tile of the unit
+	return TilePosition(Position(position.x - type.tileWidth() * TILE_SIZE / 2, position.y - type.tileHeight() * TILE_SIZE / 2));
+}
+
+// BWAPI's Positions::Origin.getApproxDistance(Position(dx, dy))
+static int approxDistance(int dx, int dy)
+{
+	unsigned int min = std::abs(dx);
+	unsigned int max = std::abs(dy);
+	if (max < min) std::swap(min, max);
+	if (min < (max >> 2)) return max;
+	unsigned int minCalc = (3 * min) >> 3;
+	return (minCalc >> 5) + minCalc + max - (max >> 4) - (max >> 6);
+}
+
+int MockUnit::getDistance(BWAPI::Position target) const
+{
+	if (!exists() || target.x < 0 || target.y < 0
+		|| target.x >= game->mapWidth() * TILE_SIZE || target.y >= game->mapHeight() * TILE_SIZE) return INT_MAX; // not valid
+	int left = position.x - type.dimensionLeft();
+	int top = position.y - type.dimensionUp();
+	int right = position.x + type.dimensionRight();
+	int bottom = position.y + type.dimensionDown();
+	int xDist = left - (target.x + 1);
+	if (xDist < 0) {
+		xDist = (target.x - 1) - right;
+		if (xDist < 0) xDist = 0;
+	}
+	int yDist = top - (target.y + 1);
+	if (yDist < 0) {
+		yDist = (target.y - 1) - bottom;
+		if (yDist < 0) yDist = 0;
+	}
+	return approxDistance(xDist, yDist);
+}
+
+int MockUnit::getDistance(Dump::Unit target) const
+{
+	if (!exists() || target == nullptr || !target->exists()) return INT_MAX;
+	if (target == this) return 0;
+	const MockUnit* other = static_cast<const MockUnit*>(target);
+	int xDist = (position.x - type.dimensionLeft()) - (other->position.x + other->type.dimensionRight() + 1);
+	if (xDist < 0) {
+		xDist = (other->position.x - other->type.dimensionLeft()) - (position.x + type.dimensionRight() + 1);
+		if (xDist < 0) xDist = 0;
+	}
+	int yDist = (position.y - type.dimensionUp()) - (other->position.y + other->type.dimensionDown() + 1);
+	if (yDist < 0) {
+		yDist = (other->position.y - other->type.dimensionUp()) - (position.y + type.dimensionDown() + 1);
+		if (yDist < 0) yDist = 0;
+	}
+	return approxDistance(xDist, yDist);
+}
+
+Dump::Unitset MockUnit::getUnitsInRadius(int radius) const
+{
+	// as BWAPI: the distance from the box of this unit to the box of the others
+	Dump::Unitset ret;
+	for (const auto& u : game->getAllUnits()) {
+		if (u != this && !u->isLoaded() && getDistance(u) <= radius) ret.insert(u);
+	}
+	return ret;
+}
+
+// ====================================================================================
+// MockPlayer
+// ====================================================================================
+
+MockPlayer::MockPlayer(int id, const std::string& name, BWAPI::Race race)
+	: id(id),
+	name(name),
+	race(race),
+	neutral(false),
+	observer(false),
+	startLocation(TilePositions::None),
+	mineralCount(50),
+	gasCount(0),
+	gatheredMineralCount(0),
+	gatheredGasCount(0),
+	supplyUsedCount(8),
+	supplyTotalCount(18)
+{}
+
+int MockPlayer::getUpgradeLevel(BWAPI::UpgradeType upgrade) const
+{
+	auto it = upgradeLevels.find(upgrade);
+	if (it == upgradeLevels.end()) return 0;
+	return it->second;
+}
+
+// ====================================================================================
+// MockGame
+// ====================================================================================
+
+MockGame::MockGame(int width, int height, const std::string& mapHash)
+	: frameCount(0),
+	pathName("mock.rep"),
+	name("mock"),
+	hash(mapHash),
+	width(width),
+	height(height),
+	walkability(width * 4 * height * 4, true),
+	regionGrid(width * height, nullptr)
+{}
+
+MockGame::~MockGame()
+{
+	for (const auto& u : units) delete u.second;
+	for (const auto& p : playerById) delete p.second;
+	for (const auto& r : regions) delete r;
+	for (const auto& c : chokepoints) delete c;
+}
+
+MockPlayer* MockGame::createPlayer(int id, const std::string& name, BWAPI::Race race)
+{
+	MockPlayer* p = new MockPlayer(id, name, race);
+	playerById[id] = p;
+	players.insert(p);
+	return p;
+}
+
+MockUnit* MockGame::createUnit(int id, BWAPI::UnitType type, MockPlayer* player, BWAPI::Position position)
+{
+	MockUnit* u = new MockUnit(this, id, type, player, position);
+	units[id] = u;
+	allUnits.insert(u);
+	player->units.insert(u);
+	return u;
+}
+
+MockUnit* MockGame::getUnit(int id) const
+{
+	auto it = units.find(id);
+	if (it == units.end()) return nullptr;
+	return it->second;
+}
+
+MockPlayer* MockGame::getPlayer(int id) const
+{
+	auto it = playerById.find(id);
+	if (it == playerById.end()) return nullptr;
+	return it->second;
+}
+
+void MockGame::destroyUnit(MockUnit* unit)
+{
+	// like BWAPI, the unit object outlives the unit
+	unit->setFlag(MockUnit::Exists, false);
+	allUnits.erase(unit);
+	unit->player->units.erase(unit);
+}
+
+void MockGame::restoreUnit(MockUnit* unit)
+{
+	unit->setFlag(MockUnit::Exists, true);
+	allUnits.insert(unit);
+	unit->player->units.insert(unit);
+}
+
+void MockGame::changeOwner(MockUnit* unit, MockPlayer* player)
+{
+	unit->player->units.erase(unit);
+	unit->player = player;
+	player->units.insert(unit);
+}
+
+Dump::Unitset MockGame::getUnitsInRadius(BWAPI::Position center, int radius) const
+{
+	Dump::Unitset ret;
+	for (const auto& u : allUnits) {
+		if (!u->isLoaded() && u->getDistance(center) <= radius) ret.insert(u); // loaded units are not on the map
+	}
+	return ret;
+}
+
+void MockGame::setWalkable(int walkX, int walkY, bool walkable)
+{
+	walkability[walkX + walkY * width * 4] = walkable;
+}
+
+bool MockGame::isWalkable(int walkX, int walkY) const
+{
+	if (walkX < 0 || walkY < 0 || walkX >= width * 4 || walkY >= height * 4) return false;
+	return walkability[walkX + walkY * width * 4];
+}
+
+bool MockGame::isTileWalkable(int x, int y) const
+{
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			if (!isWalkable(x * 4 + i, y * 4 + j)) return false;
+		}
+	}
+	return true;
+}
+
+MockRegion* MockGame::createRegion(BWAPI::Position center)
+{
+	MockRegion* r = new MockRegion(center);
+	regions.insert(r);
+	return r;
+}
+
+MockChokepoint* MockGame::createChokepoint(BWAPI::Position center, double width, MockRegion* r1, MockRegion* r2)
+{
+	MockChokepoint* c = new MockChokepoint(center, width, r1, r2);
+	r1->chokepoints.insert(c);
+	r2->chokepoints.insert(c);
+	chokepoints.insert(c);
+	return c;
+}
+
+void MockGame::setRegion(BWAPI::TilePosition tp, MockRegion* region)
+{
+	regionGrid[tp.x + tp.y * width] = region;
+}
+
+void MockGame::computeReachableRegions()
+{
+	// connected components of the regions/chokepoints graph
+	for (const auto& r : regions) {
+		MockRegion* region = static_cast<MockRegion*>(r);
+		region->reachableRegions.clear();
+		std::list<Dump::Region*> toVisit(1, r);
+		while (!toVisit.empty()) {
+			Dump::Region* current = toVisit.front();
+			toVisit.pop_front();
+			if (!region->reachableRegions.insert(current).second) continue;
+			for (const auto& c : current->getChokepoints()) {
+				toVisit.push_back(c->getRegions().first);
+				toVisit.push_back(c->getRegions().second);
+			}
+		}
+	}
+}
+
+void MockGame::setGroundDistance(BWAPI::TilePosition start, BWAPI::TilePosition end, double distance)
+{
+	knownGroundDistances[std::make_pair(start, end)] = distance;
+}
+
+Dump::Region* MockGame::getRegion(BWAPI::TilePosition tp) const
+{
+	if (tp.x < 0 || tp.y < 0 || tp.x >= width || tp.y >= height) return nullptr;
+	return regionGrid[tp.x + tp.y * width];
+}
+
+// BWTA's AstarSearchDistance: 10 straight and 14 diagonal (g * 32 / 10 pixels), no diagonal between
+// two unwalkable tiles, only the start may be unwalkable
+double MockGame::findPath(BWAPI::TilePosition start, BWAPI::TilePosition end, std::vector<int>* parents) const
+{
+	if (start.x < 0 || start.y < 0 || start.x >= width || start.y >= height
+		|| end.x < 0 || end.y < 0 || end.x >= width || end.y >= height) return -1.0;
+
+	typedef std::pair<int, int> Node; // g, tile
+	std::vector<int> g(width * height, INT_MAX);
+	std::priority_queue<Node, std::vector<Node>, std::greater<Node> > open;
+	if (parents) parents->assign(width * height, -1);
+	int startIdx = start.x + start.y * width;
+	int endIdx = end.x + end.y * width;
+	g[startIdx] = 0;
+	open.push(Node(0, startIdx));
+	while (!open.empty()) {
+		Node n = open.top();
+		open.pop();
+		if (n.second == endIdx) return n.first * 32.0 / 10.0;
+		if (n.first > g[n.second]) continue;
+		int x = n.second % width;
+		int y = n.second / width;
+		for (int dx = -1; dx <= 1; ++dx) {
+			for (int dy = -1; dy <= 1; ++dy) {
+				if (dx == 0 && dy == 0) continue;
+				int nx = x + dx;
+				int ny = y + dy;
+				if (nx < 0 || ny < 0 || nx >= width || ny >= height || !isTileWalkable(nx, ny)
+					|| (dx != 0 && dy != 0 && !isTileWalkable(x, ny) && !isTileWalkable(nx, y))) continue;
+				int d = n.first + ((dx != 0 && dy != 0) ? 14 : 10);
+				int idx = nx + ny * width;
+				if (d < g[idx]) {
+					g[idx] = d;
+					if (parents) (*parents)[idx] = n.second;
+					open.push(Node(d, idx));
+				}
+			}
+		}
+	}
+	return -1.0; // no way to go there
+}
+
+double MockGame::getGroundDistance(BWAPI::TilePosition start, BWAPI::TilePosition end) const
+{
+	auto it = knownGroundDistances.find(std::make_pair(start, end));
+	if (it != knownGroundDistances.end()) return it->second;
+	return findPath(start, end, nullptr);
+}
+
+std::vector<BWAPI::TilePosition> MockGame::getShortestPath(BWAPI::TilePosition start, BWAPI::TilePosition end) const
+{
+	std::vector<BWAPI::TilePosition> path;
+	std::vector<int> parents;
+	if (findPath(start, end, &parents) < 0.0) return path;
+	for (int idx = end.x + end.y * width; idx != -1; idx = parents[idx]) {
+		path.push_back(TilePosition(idx % width, idx / width));
+	}
+	std::reverse(path.begin(), path.end());
+	return path;
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <map>
+#include <cstdint>
+
+#include "GameInterface.h"
+
+// In-memory Dump::Game backend: whoever drives it (a test, a benchmark, the trace replayer)
+// fills the public state and forwards the callbacks to the extractors, no StarCraft needed.
+
+class MockGame;
+class MockPlayer;
+
+class MockUnit : public Dump::UnitInterface
+{
+public:
+	enum Flag { // same bits as Trace::UnitFlag
+		Exists				= 1 << 0,
+		Attacking			= 1 << 1,
+		UnderAttack			= 1 << 2,
+		Completed			= 1 << 3,
+		Loaded				= 1 << 4,
+		Flying				= 1 << 5,
+		Cloaked				= 1 << 6,
+		GatheringMinerals	= 1 << 7,
+		GatheringGas		= 1 << 8,
+		Repairing			= 1 << 9,
+		Constructing		= 1 << 10
+	};
+
+	MockUnit(MockGame* game, int id, BWAPI::UnitType type, MockPlayer* player, BWAPI::Position position);
+
+	int id;
+	BWAPI::UnitType type;
+	MockPlayer* player;
+	BWAPI::Position position;
+	BWAPI::Position initialPosition;
+	int hitPoints;
+	int shields;
+	int energy;
+	int resourceGroup;
+	int spaceRemaining;
+	int groundWeaponCooldown;
+	int airWeaponCooldown;
+	int spellCooldown;
+	Dump::Player lastAttackingPlayer;
+	BWAPI::Order order;
+	Dump::Unit orderTarget;
+	BWAPI::Position orderTargetPosition;
+	Dump::Unit target;
+	BWAPI::Position targetPosition;
+	uint16_t flags;
+
+	void setFlag(Flag f, bool value) { if (value) flags |= f; else flags &= ~f; }
+	bool hasFlag(Flag f) const { return (flags & f) != 0; }
+
+	virtual int getID() const					{ return id; }
+	virtual bool exists() const					{ return hasFlag(Exists); }
+	virtual BWAPI::UnitType getType() const		{ return type; }
+	virtual Dump::Player getPlayer() const;
+	virtual BWAPI::Position getPosition() const	{ return position; }
+	virtual BWAPI::TilePosition getTilePosition() const;
+	virtual BWAPI::Position getInitialPosition() const	{ return initialPosition; }
+	virtual int getHitPoints() const			{ return hitPoints; }
+	virtual int getShields() const				{ return shields; }
+	virtual int getEnergy() const				{ return energy; }
+	virtual int getResourceGroup() const		{ return resourceGroup; }
+	virtual int getSpaceRemaining() const		{ return spaceRemaining; }
+	virtual int getGroundWeaponCooldown() const	{ return groundWeaponCooldown; }
+	virtual int getAirWeaponCooldown() const	{ return airWeaponCooldown; }
+	virtual int getSpellCooldown() const		{ return spellCooldown; }
+	virtual Dump::Player getLastAttackingPlayer() const { return lastAttackingPlayer; }
+
+	virtual BWAPI::Order getOrder() const		{ return order; }
+	virtual Dump::Unit getOrderTarget() const	{ return orderTarget; }
+	virtual BWAPI::Position getOrderTargetPosition() const { return orderTargetPosition; }
+	virtual Dump::Unit getTarget() const		{ return target; }
+	virtual BWAPI::Position getTargetPosition() const { return targetPosition; }
+
+	virtual bool isAttacking() const			{ return hasFlag(Attacking); }
+	virtual bool isUnderAttack() const			{ return hasFlag(UnderAttack); }
+	virtual bool isCompleted() const			{ return hasFlag(Completed); }
+	virtual bool isLoaded() const				{ return hasFlag(Loaded); }
+	virtual bool isFlying() const				{ return hasFlag(Flying); }
+	virtual bool isCloaked() const				{ return hasFlag(Cloaked); }
+	virtual bool isGatheringMinerals() const	{ return hasFlag(GatheringMinerals); }
+	virtual bool isGatheringGas() const			{ return hasFlag(GatheringGas); }
+	virtual bool isRepairing() const			{ return hasFlag(Repairing); }
+	virtual bool isConstructing() const			{ return hasFlag(Constructing); }
+
+	// as BWAPI: approximated distance between the boxes of the units (type dimensions), the box of a
+	// position is 3x3 pixels
+	virtual int getDistance(BWAPI::Position target) const;
+	virtual int getDistance(Dump::Unit target) const;
+	virtual Dump::Unitset getUnitsInRadius(int radius) const;
+
+private:
+	MockGame* game;
+};
+
+class MockPlayer : public Dump::PlayerInterface
+{
+public:
+	MockPlayer(int id, const std::string& name, BWAPI::Race race);
+
+	int id;
+	std::string name;
+	BWAPI::Race race;
+	bool neutral;
+	bool observer;
+	Dump::Unitset units;
+	BWAPI::TilePosition startLocation;
+	int mineralCount;
+	int gasCount;
+	int gatheredMineralCount;
+	int gatheredGasCount;
+	int supplyUsedCount;
+	int supplyTotalCount;
+	std::set<BWAPI::TechType> researching;
+	std::set<BWAPI::TechType> researched;
+	std::set<BWAPI::UpgradeType> upgrading;
+	std::map<BWAPI::UpgradeType, int> upgradeLevels;
+
+	virtual int getID() const						{ return id; }
+	virtual std::string getName() const				{ return name; }
+	virtual BWAPI::Race getRace() const				{ return race; }
+	virtual bool isNeutral() const					{ return neutral; }
+	virtual bool isObserver() const					{ return observer; }
+	virtual const Dump::Unitset& getUnits() const	{ return units; }
+	virtual BWAPI::TilePosition getStartLocation() const { return startLocation; }
+
+	virtual int minerals() const					{ return mineralCount; }
+	virtual int gas() const							{ return gasCount; }
+	virtual int gatheredMinerals() const			{ return gatheredMineralCount; }
+	virtual int gatheredGas() const					{ return gatheredGasCount; }
+	virtual int supplyUsed() const					{ return supplyUsedCount; }
+	virtual int supplyTotal() const					{ return supplyTotalCount; }
+
+	virtual bool isResearching(BWAPI::TechType tech) const		{ return researching.count(tech) != 0; }
+	virtual bool hasResearched(BWAPI::TechType tech) const		{ return researched.count(tech) != 0; }
+	virtual bool isUpgrading(BWAPI::UpgradeType upgrade) const	{ return upgrading.count(upgrade) != 0; }
+	virtual int getUpgradeLevel(BWAPI::UpgradeType upgrade) const;
+};
+
+class MockRegion : public Dump::Region
+{
+public:
+	MockRegion(BWAPI::Position center) : center(center), polygonCenter(center) {}
+
+	BWAPI::Position center;
+	BWAPI::Position polygonCenter;
+	std::vector<BWAPI::Position> polygon;
+	std::set<Dump::Chokepoint*> chokepoints;
+	std::set<Dump::Region*> reachableRegions;
+
+	virtual BWAPI::Position getCenter() const		 { return center; }
+	virtual const std::vector<BWAPI::Position>& getPolygon() const { return polygon; }
+	virtual BWAPI::Position getPolygonCenter() const { return polygonCenter; }
+	virtual const std::set<Dump::Chokepoint*>& getChokepoints() const { return chokepoints; }
+	virtual const std::set<Dump::Region*>& getReachableRegions() const { return reachableRegions; }
+};
+
+class MockChokepoint : public Dump::Chokepoint
+{
+public:
+	MockChokepoint(BWAPI::Position center, double width, Dump::Region* r1, Dump::Region* r2)
+		: center(center), width(width), regions(r1, r2), sides(center, center) {}
+
+	BWAPI::Position center;
+	double width;
+	std::pair<Dump::Region*, Dump::Region*> regions;
+	std::pair<BWAPI::Position, BWAPI::Position> sides;
+
+	virtual BWAPI::Position getCenter() const { return center; }
+	virtual double getWidth() const { return width; }
+	virtual const std::pair<Dump::Region*, Dump::Region*>& getRegions() const { return regions; }
+	virtual const std::pair<BWAPI::Position, BWAPI::Position>& getSides() const { return sides; }
+};
+
+class MockGame : public Dump::Game
+{
+public:
+	// width and height in build tiles, everything walkable and without regions
+	MockGame(int width, int height, const std::string& mapHash = "mock");
+	~MockGame();
+
+	int frameCount;
+	std::string pathName;
+	std::string name;
+	std::string hash;
+	std::vector<BWAPI::TilePosition> startLocations;
+
+	// players and units
+	MockPlayer* createPlayer(int id, const std::string& name, BWAPI::Race race);
+	MockUnit* createUnit(int id, BWAPI::UnitType type, MockPlayer* player, BWAPI::Position position);
+	MockUnit* getUnit(int id) const;
+	MockPlayer* getPlayer(int id) const;
+	void destroyUnit(MockUnit* unit);
+	void restoreUnit(MockUnit* unit); // undo destroyUnit, for units coming back into view
+	void changeOwner(MockUnit* unit, MockPlayer* player);
+
+	// terrain
+	void setWalkable(int walkX, int walkY, bool walkable);
+	MockRegion* createRegion(BWAPI::Position center);
+	MockChokepoint* createChokepoint(BWAPI::Position center, double width, MockRegion* r1, MockRegion* r2);
+	void setRegion(BWAPI::TilePosition tp, MockRegion* region);
+	void computeReachableRegions(); // call once all the regions and chokepoints are created
+	void setGroundDistance(BWAPI::TilePosition start, BWAPI::TilePosition end, double distance); // overrides the pathfinding
+
+	virtual int getFrameCount() const { return frameCount; }
+	virtual const Dump::Playerset& getPlayers() const { return players; }
+	virtual const Dump::Unitset& getAllUnits() const { return allUnits; }
+	virtual Dump::Unitset getUnitsInRadius(BWAPI::Position center, int radius) const;
+	virtual bool isVisible(BWAPI::TilePosition) const { return true; }
+	virtual void setVision(Dump::Player, bool) {}
+
+	virtual int mapWidth() const { return width; }
+	virtual int mapHeight() const { return height; }
+	virtual bool isWalkable(int walkX, int walkY) const;
+	virtual std::string mapPathName() const { return pathName; }
+	virtual std::string mapName() const { return name; }
+	virtual std::string mapHash() const { return hash; }
+	virtual const std::vector<BWAPI::TilePosition>& getStartLocations() const { return startLocations; }
+
+	virtual const std::set<Dump::Region*>& getRegions() const { return regions; }
+	virtual const std::set<Dump::Chokepoint*>& getChokepoints() const { return chokepoints; }
+	virtual Dump::Region* getRegion(BWAPI::TilePosition tp) const;
+	virtual Dump::Region* getRegion(BWAPI::Position p) const { return getRegion(BWAPI::TilePosition(p)); }
+	virtual double getGroundDistance(BWAPI::TilePosition start, BWAPI::TilePosition end) const;
+	virtual std::vector<BWAPI::TilePosition> getShortestPath(BWAPI::TilePosition start, BWAPI::TilePosition end) const;
+
+	virtual void printText(const std::string&) {}
+	virtual void drawCircleMap(BWAPI::Position, int, BWAPI::Color, bool = false) {}
+	virtual void drawLineMap(BWAPI::Position, BWAPI::Position, BWAPI::Color) {}
+	virtual void drawBoxMap(BWAPI::Position, BWAPI::Position, BWAPI::Color, bool = false) {}
+	virtual void drawTextMap(BWAPI::Position, const std::string&) {}
+	virtual void setLocalSpeed(int) {}
+	virtual void setScreenPosition(BWAPI::Position) {}
+
+private:
+	int width;
+	int height;
+	std::vector<bool> walkability; // walk tiles resolution
+	std::vector<Dump::Region*> regionGrid; // build tiles resolution
+	std::map<int, MockUnit*> units;
+	std::map<int, MockPlayer*> playerById;
+	Dump::Unitset allUnits;
+	Dump::Playerset players;
+	std::set<Dump::Region*> regions;
+	std::set<Dump::Chokepoint*> chokepoints;
+	std::map<std::pair<BWAPI::TilePosition, BWAPI::TilePosition>, double> knownGroundDistances;
+
+	bool isTileWalkable(int x, int y) const;
+	// getGroundDistance with the cost model of BWTA, fills the parent of each visited tile
+	double findPath(BWAPI::TilePosition start, BWAPI::TilePosition end, std::vector<int>* parents) const;
+};
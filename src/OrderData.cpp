@@ -4,8 +4,11 @@ using namespace BWAPI;
 
 OrderData::OrderData()
 {
-	std::string ordersfilepath = Broodwar->mapPathName() + ".rod";
-	replayOrdersDat.open(ordersfilepath.c_str());
+	if (COMPRESS_ROD_RLD) {
+		replayOrdersDat.open(game->mapPathName() + ".rodz", true, Compressed::loadDictionary(COMPRESSION_DICTIONARY));
+	} else {
+		replayOrdersDat.open(game->mapPathName() + ".rod", false);
+	}
 }
 
 OrderData::~OrderData()
@@ -15,7 +18,8 @@ OrderData::~OrderData()
 
 void OrderData::onFrame()
 {
-	for (const auto& u : Broodwar->getAllUnits()) {
+	replayOrdersDat.beginFrame(game->getFrameCount());
+	for (const auto& u : game->getAllUnits()) {
 		bool mining = isGatheringResources(u);
 		bool newOrders = false;
 
@@ -57,8 +61,8 @@ void OrderData::onFrame()
 			}
 		}
 
-		if (newOrders && Broodwar->getFrameCount() > 0) {
-			replayOrdersDat << Broodwar->getFrameCount() << "," << u->getID() << "," << u->getOrder().getName();
+		if (newOrders && game->getFrameCount() > 0) {
+			replayOrdersDat << game->getFrameCount() << "," << u->getID() << "," << u->getOrder().getName();
 			if (u->getTarget() != NULL) {
 				replayOrdersDat << ",T," << u->getTarget()->getPosition().x << "," << u->getTarget()->getPosition().y << "\n";
 			} else {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Utils.h"
+#include "CompressedFile.h"
 
 class OrderData
 {
@@ -10,9 +11,9 @@ public:
 	void onFrame();
 
 private:
-	std::ofstream replayOrdersDat;
-	std::map<BWAPI::Unit, BWAPI::Order> unitOrders;
-	std::map<BWAPI::Unit, BWAPI::Unit> unitOrdersTargets;
-	std::map<BWAPI::Unit, BWAPI::Position> unitOrdersTargetPositions;
-	std::map<BWAPI::Unit, int> minerResourceGroup;
+	CompressedOutputFile replayOrdersDat;
+	std::map<Dump::Unit, BWAPI::Order, Dump::ByID> unitOrders;
+	std::map<Dump::Unit, Dump::Unit, Dump::ByID> unitOrdersTargets;
+	std::map<Dump::Unit, BWAPI::Position, Dump::ByID> unitOrdersTargetPositions;
+	std::map<Dump::Unit, int, Dump::ByID> minerResourceGroup;
 };
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+	struct Ring
+	{
+		Ring(int tid) : tid(tid), next(0) {}
+		int tid;
+		std::vector<Profiler::Span> spans; // grows up to RING_SIZE, then wraps around
+		size_t next;
+	};
+
+	std::mutex ringsMutex;
+	std::vector<std::unique_ptr<Ring> > rings; // kept until exit, a thread can outlive a replay
+	PROFILER_THREAD_LOCAL Ring* threadRing = nullptr;
+
+	Ring* getThreadRing()
+	{
+		if (threadRing == nullptr) {
+			std::lock_guard<std::mutex> lock(ringsMutex);
+			rings.push_back(std::unique_ptr<Ring>(new Ring(static_cast<int>(rings.size()))));
+			threadRing = rings.back().get();
+		}
+		return threadRing;
+	}
+}
+
+void Profiler::record(const char* name, int64_t start, int64_t end)
+{
+	Ring* ring = getThreadRing();
+	Span span = { name, start, end - start };
+	if (ring->spans.size() < RING_SIZE) ring->spans.push_back(span);
+	else ring->spans[ring->next] = span;
+	ring->next = (ring->next + 1) % RING_SIZE;
+}
+
+void Profiler::writeChromeTrace(const std::string& path)
+{
+	// the other threads are expected to be idle (called at the end of the replay)
+	std::lock_guard<std::mutex> lock(ringsMutex);
+
+	int64_t epoch = INT64_MAX;
+	for (const auto& ring : rings) {
+		for (const auto& span : ring->spans) epoch = std::min(epoch, span.start);
+	}
+
+	std::ofstream out(path.c_str());
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const auto& ring : rings) {
+		if (ring->spans.empty()) continue;
+		if (!first) out << ",\n";
+		first = false;
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << ring->tid
+			<< ",\"args\":{\"name\":\"" << (ring->tid == 0 ? "main" : "worker " + std::to_string(ring->tid)) << "\"}}";
+		for (const auto& span : ring->spans) {
+			out << ",\n{\"name\":\"" << span.name << "\",\"cat\":\"BWRepDump\",\"ph\":\"X\",\"pid\":0,\"tid\":" << ring->tid
+				<< ",\"ts\":" << (span.start - epoch) / 1000.0 << ",\"dur\":" << span.duration / 1000.0 << "}";
+		}
+		ring->spans.clear();
+		ring->next = 0;
+	}
+	out << "\n]}\n";
+}
+
+std::vector<Profiler::Span> Profiler::collect()
+{
+	std::lock_guard<std::mutex> lock(ringsMutex);
+	std::vector<Span> ret;
+	for (const auto& ring : rings) {
+		ret.insert(ret.end(), ring->spans.begin(), ring->spans.end());
+		ring->spans.clear();
+		ring->next = 0;
+	}
+	return ret;
+}
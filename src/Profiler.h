@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped timers ("spans") saved in a per-thread ring buffer and written in Chrome trace event
+// format (open it with chrome://tracing or ui.perfetto.dev) at the end of the replay.
+// Only active when PROFILE_SPANS is true, otherwise a span costs a branch.
+//
+//   void GameData::handleVisionEvents()
+//   {
+//       PROFILE_SPAN("GameData::handleVisionEvents");
+//       ...
+
+extern bool PROFILE_SPANS;
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define PROFILER_THREAD_LOCAL __declspec(thread) // no thread_local in VS2013
+#else
+#define PROFILER_THREAD_LOCAL thread_local
+#endif
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+#define PROFILE_SPAN(name) ScopedSpan PROFILER_CONCAT(profileSpan, __LINE__)(name)
+
+namespace Profiler
+{
+	const size_t RING_SIZE = 1 << 20; // spans kept per thread (24 MB), the oldest ones are overwritten
+
+	struct Span
+	{
+		const char* name; // string literal
+		int64_t start;    // ns since the profiler epoch
+		int64_t duration; // ns
+	};
+
+	inline int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void record(const char* name, int64_t start, int64_t end);
+
+	// writes the spans of all threads since the last call and empties the rings
+	void writeChromeTrace(const std::string& path);
+	// same but returns them (all threads mixed), for the benchmarks
+	std::vector<Span> collect();
+}
+
+class ScopedSpan
+{
+public:
+	explicit ScopedSpan(const char* name) : name(name), start(PROFILE_SPANS ? Profiler::now() : 0) {}
+	~ScopedSpan() { if (PROFILE_SPANS) Profiler::record(name, start, Profiler::now()); }
+
+private:
+	const char* name;
+	int64_t start;
+	ScopedSpan(const ScopedSpan&);
+	ScopedSpan& operator=(const ScopedSpan&);
+};
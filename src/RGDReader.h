@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "RGDSchema.h"
+
+// Zero-copy reader of a binary RGD (see RGDSchema.h) already in memory, typically memory mapped.
+// Header only, it does not depend on BWAPI:
+//
+//   RGDReader reader(data, size); // throws std::runtime_error if it is not a valid .rgdb
+//   for (const auto& block : reader.getBlocks()) {
+//       const int32_t* frames = block.frame();
+//       for (uint32_t i = 0; i < block.size(); ++i) {
+//           if (block.kind()[i] == RGDB::R) total += block.resources(i)->minerals;
+//       }
+//   }
+class RGDReader
+{
+public:
+	class Block
+	{
+	public:
+		uint32_t size() const { return events; }
+
+		// one accessor per column, arrays of size() values
+#define RGDB_COLUMN_ACCESSOR(name, type) const type* name() const { return name##Column; }
+		RGDB_COLUMNS(RGDB_COLUMN_ACCESSOR)
+#undef RGDB_COLUMN_ACCESSOR
+
+		// payload of the i-th event, nullptr if it does not have this kind of payload
+		const RGDB::Text* text(uint32_t i) const
+		{
+			if (RGDB::payloadKind(kindColumn[i]) != RGDB::Payload::Text) return nullptr;
+			const RGDB::Text* t = static_cast<const RGDB::Text*>(heapEntry(i, sizeof(RGDB::Text)));
+			if (t == nullptr || payloadColumn[i] + sizeof(RGDB::Text) + t->length > heapSize) return nullptr;
+			return t;
+		}
+		std::string textString(uint32_t i) const
+		{
+			const RGDB::Text* t = text(i);
+			return t == nullptr ? std::string() : std::string(t->data(), t->length);
+		}
+		const RGDB::Resources* resources(uint32_t i) const
+		{
+			if (RGDB::payloadKind(kindColumn[i]) != RGDB::Payload::Resources) return nullptr;
+			return static_cast<const RGDB::Resources*>(heapEntry(i, sizeof(RGDB::Resources)));
+		}
+		const RGDB::Attack* attack(uint32_t i) const // with its counts
+		{
+			if (RGDB::payloadKind(kindColumn[i]) != RGDB::Payload::Attack) return nullptr;
+			const RGDB::Attack* a = static_cast<const RGDB::Attack*>(heapEntry(i, sizeof(RGDB::Attack)));
+			if (a == nullptr || payloadColumn[i] + a->size() > heapSize) return nullptr;
+			return a;
+		}
+
+	private:
+		friend class RGDReader;
+		uint32_t events;
+		uint32_t heapSize;
+		const char* heap;
+#define RGDB_COLUMN_POINTER(name, type) const type* name##Column;
+		RGDB_COLUMNS(RGDB_COLUMN_POINTER)
+#undef RGDB_COLUMN_POINTER
+
+		const void* heapEntry(uint32_t i, size_t size) const
+		{
+			if (payloadColumn[i] + size > heapSize) return nullptr;
+			return heap + payloadColumn[i];
+		}
+	};
+
+	RGDReader(const char* data, size_t size)
+	{
+		if (size < sizeof(RGDB::FileHeader)) throw std::runtime_error("not a RGDB file (too small)");
+		const RGDB::FileHeader* header = reinterpret_cast<const RGDB::FileHeader*>(data);
+		if (header->magic != RGDB::MAGIC) throw std::runtime_error("not a RGDB file (bad magic)");
+		if (header->version != RGDB::VERSION || header->schema != RGDB::schemaHash()) {
+			throw std::runtime_error("RGDB file written with another schema version");
+		}
+
+		size_t offset = sizeof(RGDB::FileHeader);
+		while (offset < size) {
+			if (offset + sizeof(RGDB::BlockHeader) > size) throw std::runtime_error("truncated RGDB block header");
+			const RGDB::BlockHeader* blockHeader = reinterpret_cast<const RGDB::BlockHeader*>(data + offset);
+			offset += sizeof(RGDB::BlockHeader);
+			Block block;
+			block.events = blockHeader->events;
+#define RGDB_COLUMN_READ(name, type) \
+			block.name##Column = reinterpret_cast<const type*>(data + offset); \
+			offset += RGDB::padded(block.events * sizeof(type));
+			RGDB_COLUMNS(RGDB_COLUMN_READ)
+#undef RGDB_COLUMN_READ
+			block.heap = data + offset;
+			block.heapSize = blockHeader->heapSize;
+			offset += blockHeader->heapSize;
+			if (offset > size) throw std::runtime_error("truncated RGDB block");
+			blocks.push_back(block);
+		}
+	}
+
+	const std::vector<Block>& getBlocks() const { return blocks; }
+
+private:
+	std::vector<Block> blocks;
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Binary RGD (.rgdb, see CREATE_RGD_BINARY): the RGD events as typed columns, so they can be
+// loaded without parsing text. This schema is the only definition of the format, RGDWriter
+// (BWRepDump side) and RGDReader (consumers side) are generated from it with the X-macros below.
+// Little endian:
+//   RGDB::FileHeader
+//   { block } until the end of the file
+// A block holds up to BLOCK_EVENTS events:
+//   RGDB::BlockHeader
+//   one array per column (in RGDB_COLUMNS order) of BlockHeader::events values, padded to 8 bytes
+//   heap of BlockHeader::heapSize bytes (texts and structs referenced by the payload column)
+// so the columns of a memory mapped file are read in place.
+
+// COLUMN(name, type)
+#define RGDB_COLUMNS(COLUMN) \
+	COLUMN(frame, int32_t) \
+	COLUMN(player, int32_t) \
+	COLUMN(kind, uint8_t) \
+	COLUMN(unit, int32_t) \
+	COLUMN(type, int32_t) \
+	COLUMN(x, int32_t) \
+	COLUMN(y, int32_t) \
+	COLUMN(payload, uint32_t)
+
+// EVENT(name, payload), the payload column is either unused (None), a value (Value),
+// or the heap offset of a RGDB::Text (Text), a RGDB::Resources (Resources) or a RGDB::Attack (Attack).
+// Unused columns are 0. Types are BWAPI ids (UnitType, TechType, UpgradeType, Race).
+#define RGDB_EVENTS(EVENT) \
+	EVENT(RepPath, Text)            /* text: replay path */ \
+	EVENT(MapName, Text)            /* x: number of start positions, text: map name */ \
+	EVENT(PlayerInfo, Text)         /* player, type: race, x: start location, text: player name */ \
+	EVENT(Created, None)            /* player, unit, type, x, y */ \
+	EVENT(Destroyed, None)          /* player, unit, type, x, y */ \
+	EVENT(Discovered, None)         /* player, unit, type */ \
+	EVENT(R, Resources)             /* player */ \
+	EVENT(ChangedOwnership, None)   /* player, unit */ \
+	EVENT(Morph, None)              /* player, unit, type, x, y */ \
+	EVENT(StartResearch, None)      /* player, type */ \
+	EVENT(FinishResearch, None)     /* player, type */ \
+	EVENT(CancelResearch, None)     /* player, type */ \
+	EVENT(StartUpgrade, Value)      /* player, type, value: upgrade level */ \
+	EVENT(FinishUpgrade, Value)     /* player, type, value: upgrade level */ \
+	EVENT(CancelUpgrade, Value)     /* player, type, value: upgrade level */ \
+	EVENT(SendMessage, Text)        /* player, text: message */ \
+	EVENT(PlayerLeftGame, None)     /* player */ \
+	EVENT(NuclearLaunch, None)      /* player (-1), x, y */ \
+	EVENT(IsAttacked, Attack)       /* frame: first frame, player: defender, x, y: initial position, */ \
+	                                /* attack: the rest of the RGD line */ \
+	EVENT(EndGame, None)
+
+namespace RGDB
+{
+	const uint32_t MAGIC = 0x42444752; // "RGDB"
+	const uint32_t VERSION = 2;
+	const uint32_t BLOCK_EVENTS = 4096;
+
+	enum class Payload { None, Value, Text, Resources, Attack };
+
+#define RGDB_EVENT_ENUM(name, payload) name,
+	enum EventKind : uint8_t { RGDB_EVENTS(RGDB_EVENT_ENUM) EVENT_KINDS };
+#undef RGDB_EVENT_ENUM
+
+	inline const char* eventName(uint8_t kind)
+	{
+#define RGDB_EVENT_NAME(name, payload) #name,
+		static const char* names[] = { RGDB_EVENTS(RGDB_EVENT_NAME) "Unknown" };
+#undef RGDB_EVENT_NAME
+		return names[kind < EVENT_KINDS ? kind : static_cast<uint8_t>(EVENT_KINDS)];
+	}
+
+	inline Payload payloadKind(uint8_t kind)
+	{
+#define RGDB_EVENT_PAYLOAD(name, payload) Payload::payload,
+		static const Payload payloads[] = { RGDB_EVENTS(RGDB_EVENT_PAYLOAD) Payload::None };
+#undef RGDB_EVENT_PAYLOAD
+		return payloads[kind < EVENT_KINDS ? kind : static_cast<uint8_t>(EVENT_KINDS)];
+	}
+
+	// FNV-1a of the schema text, a reader only accepts files written with the same schema
+	inline uint32_t schemaHash()
+	{
+#define RGDB_COLUMN_TEXT(name, type) #name ":" #type ","
+#define RGDB_EVENT_TEXT(name, payload) #name ":" #payload ","
+		const char* schema = RGDB_COLUMNS(RGDB_COLUMN_TEXT) RGDB_EVENTS(RGDB_EVENT_TEXT);
+#undef RGDB_COLUMN_TEXT
+#undef RGDB_EVENT_TEXT
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < strlen(schema); ++i) hash = (hash ^ static_cast<uint8_t>(schema[i])) * 16777619u;
+		return hash;
+	}
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t schema; // schemaHash()
+		uint32_t blockEvents;
+	};
+
+	struct BlockHeader
+	{
+		uint32_t events;
+		uint32_t heapSize; // padded to 8 bytes
+	};
+
+	// heap entries, 8 bytes aligned
+	struct Text
+	{
+		uint32_t length;
+		// followed by length chars (not null terminated)
+		const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+	};
+
+	struct Resources
+	{
+		int32_t minerals;
+		int32_t gas;
+		int32_t gatheredMinerals;
+		int32_t gatheredGas;
+		int32_t supplyUsed;
+		int32_t supplyTotal;
+	};
+
+	// bits of Attack::types, the AttackType of GameData
+	enum AttackTypeBit { DropAttack = 1 << 0, GroundAttack = 1 << 1, AirAttack = 1 << 2, InvisAttack = 1 << 3 };
+
+	struct UnitCount
+	{
+		int32_t player;
+		int32_t type; // -1 (and count 0) for a player without any unit
+		int32_t count;
+	};
+
+	struct PlayerCount
+	{
+		int32_t player;
+		int32_t count;
+	};
+
+	// followed by the involved and the atEnd UnitCounts, then the workers PlayerCounts,
+	// in the order of the RGD line (players then types by increasing id)
+	struct Attack
+	{
+		uint32_t types;    // AttackTypeBit
+		int32_t cdr;       // ChokeDepReg of the initial position
+		int32_t region;    // region (hashRegionCenter) of the initial position
+		int32_t lastX;     // last position
+		int32_t lastY;
+		int32_t lastFrame;
+		int32_t winner;    // player, -1 if none
+		uint32_t involved; // max number of units of each type involved
+		uint32_t atEnd;    // units of each type alive at the end
+		uint32_t workers;  // workers dead of each player
+		double scoreGroundCDR;
+		double scoreGroundRegion;
+		double scoreAirCDR;
+		double scoreAirRegion;
+		double scoreDetectCDR;
+		double scoreDetectRegion;
+		double economicImportanceCDR;
+		double economicImportanceRegion;
+		double tacticalImportanceCDR;
+		double tacticalImportanceRegion;
+
+		const UnitCount* involvedCounts() const { return reinterpret_cast<const UnitCount*>(this + 1); }
+		const UnitCount* atEndCounts() const { return involvedCounts() + involved; }
+		const PlayerCount* workersDead() const { return reinterpret_cast<const PlayerCount*>(atEndCounts() + atEnd); }
+		size_t size() const { return sizeof(Attack) + (involved + atEnd) * sizeof(UnitCount) + workers * sizeof(PlayerCount); }
+	};
+
+	inline size_t padded(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+}
@@ -0,0 +1,81 @@
+#include "RGDWriter.h"
+
+RGDWriter::RGDWriter(const std::string& path)
+{
+	file.open(path, std::ios_base::out | std::ios_base::binary);
+	RGDB::FileHeader header = { RGDB::MAGIC, RGDB::VERSION, RGDB::schemaHash(), RGDB::BLOCK_EVENTS };
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+#define RGDB_COLUMN_RESERVE(name, type) name##Column.reserve(RGDB::BLOCK_EVENTS);
+	RGDB_COLUMNS(RGDB_COLUMN_RESERVE)
+#undef RGDB_COLUMN_RESERVE
+}
+
+RGDWriter::~RGDWriter()
+{
+	writeBlock();
+	file.close();
+}
+
+void RGDWriter::event(RGDB::EventKind kind, int frame, int player, int unit, int type, int x, int y, uint32_t payload)
+{
+	frameColumn.push_back(frame);
+	playerColumn.push_back(player);
+	kindColumn.push_back(kind);
+	unitColumn.push_back(unit);
+	typeColumn.push_back(type);
+	xColumn.push_back(x);
+	yColumn.push_back(y);
+	payloadColumn.push_back(payload);
+	if (frameColumn.size() == RGDB::BLOCK_EVENTS) writeBlock();
+}
+
+void RGDWriter::text(RGDB::EventKind kind, int frame, int player, const std::string& text, int type, int x, int y)
+{
+	uint32_t length = static_cast<uint32_t>(text.size());
+	event(kind, frame, player, 0, type, x, y, addToHeap(&length, sizeof(length), text.data(), text.size()));
+}
+
+void RGDWriter::resources(int frame, int player, const RGDB::Resources& resources)
+{
+	event(RGDB::R, frame, player, 0, 0, 0, 0, addToHeap(&resources, sizeof(resources)));
+}
+
+void RGDWriter::attack(int frame, int player, int x, int y, const RGDB::Attack& attack, const std::vector<RGDB::UnitCount>& involved,
+	const std::vector<RGDB::UnitCount>& atEnd, const std::vector<RGDB::PlayerCount>& workers)
+{
+	RGDB::Attack a(attack);
+	a.involved = static_cast<uint32_t>(involved.size());
+	a.atEnd = static_cast<uint32_t>(atEnd.size());
+	a.workers = static_cast<uint32_t>(workers.size());
+	std::vector<char> entry(reinterpret_cast<const char*>(&a), reinterpret_cast<const char*>(&a + 1));
+	entry.insert(entry.end(), reinterpret_cast<const char*>(involved.data()), reinterpret_cast<const char*>(involved.data() + involved.size()));
+	entry.insert(entry.end(), reinterpret_cast<const char*>(atEnd.data()), reinterpret_cast<const char*>(atEnd.data() + atEnd.size()));
+	entry.insert(entry.end(), reinterpret_cast<const char*>(workers.data()), reinterpret_cast<const char*>(workers.data() + workers.size()));
+	event(RGDB::IsAttacked, frame, player, 0, 0, x, y, addToHeap(entry.data(), entry.size()));
+}
+
+uint32_t RGDWriter::addToHeap(const void* data, size_t size, const void* data2, size_t size2)
+{
+	uint32_t offset = static_cast<uint32_t>(heap.size());
+	heap.insert(heap.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+	if (size2 > 0) heap.insert(heap.end(), static_cast<const char*>(data2), static_cast<const char*>(data2) + size2);
+	heap.resize((heap.size() + 7) & ~static_cast<size_t>(7), 0); // next entry 8 bytes aligned
+	return offset;
+}
+
+void RGDWriter::writeBlock()
+{
+	if (frameColumn.empty()) return;
+	static const char zeros[8] = {};
+	RGDB::BlockHeader header = { static_cast<uint32_t>(frameColumn.size()), static_cast<uint32_t>(RGDB::padded(heap.size())) };
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+#define RGDB_COLUMN_WRITE(name, type) \
+	file.write(reinterpret_cast<const char*>(name##Column.data()), name##Column.size() * sizeof(type)); \
+	file.write(zeros, RGDB::padded(name##Column.size() * sizeof(type)) - name##Column.size() * sizeof(type)); \
+	name##Column.clear();
+	RGDB_COLUMNS(RGDB_COLUMN_WRITE)
+#undef RGDB_COLUMN_WRITE
+	file.write(heap.data(), heap.size());
+	file.write(zeros, header.heapSize - heap.size());
+	heap.clear();
+}
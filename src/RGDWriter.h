@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "AsyncWriter.h"
+#include "RGDSchema.h"
+
+// Writes a binary RGD (.rgdb, see RGDSchema.h): the events are appended to in-memory columns
+// and written a block at a time (every RGDB::BLOCK_EVENTS events and on destruction).
+class RGDWriter
+{
+public:
+	RGDWriter(const std::string& path);
+	~RGDWriter();
+
+	void event(RGDB::EventKind kind, int frame, int player, int unit = 0, int type = 0, int x = 0, int y = 0, uint32_t payload = 0);
+	void text(RGDB::EventKind kind, int frame, int player, const std::string& text, int type = 0, int x = 0, int y = 0);
+	void resources(int frame, int player, const RGDB::Resources& resources);
+	// the counts of attack are the sizes of the vectors
+	void attack(int frame, int player, int x, int y, const RGDB::Attack& attack, const std::vector<RGDB::UnitCount>& involved,
+		const std::vector<RGDB::UnitCount>& atEnd, const std::vector<RGDB::PlayerCount>& workers);
+
+private:
+	AsyncOutputFile file;
+#define RGDB_COLUMN_VECTOR(name, type) std::vector<type> name##Column;
+	RGDB_COLUMNS(RGDB_COLUMN_VECTOR)
+#undef RGDB_COLUMN_VECTOR
+	std::vector<char> heap;
+
+	uint32_t addToHeap(const void* data, size_t size, const void* data2 = nullptr, size_t size2 = 0);
+	void writeBlock();
+};
@@ -0,0 +1,543 @@
+#include "ReplayParser.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARSE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include "boost/filesystem.hpp"
+
+#include "CompressedFile.h"
+
+using Parse::Token;
+
+// ====================================================================================
+// Scanning
+// ====================================================================================
+
+namespace
+{
+#ifdef PARSE_SSE2
+	inline unsigned firstBit(unsigned mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	// bit i set if p[i] == c, 16 bytes
+	inline unsigned matches(const char* p, __m128i c)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, c)));
+	}
+#endif
+
+	inline Token token(const char* begin, const char* end)
+	{
+		Token t = { begin, end };
+		return t;
+	}
+
+	Token trimmed(Token t)
+	{
+		while (t.begin < t.end && *t.begin == ' ') ++t.begin;
+		return t;
+	}
+
+	bool startsWith(Token line, const char* prefix)
+	{
+		size_t length = strlen(prefix);
+		return line.size() >= length && memcmp(line.begin, prefix, length) == 0;
+	}
+}
+
+double Token::toDouble() const
+{
+	char buffer[64];
+	Token t = trimmed(*this);
+	if (t.begin < t.end && *t.begin == '(') ++t.begin;
+	size_t length = std::min(t.size(), sizeof(buffer) - 1);
+	memcpy(buffer, t.begin, length);
+	buffer[length] = '\0';
+	return strtod(buffer, nullptr);
+}
+
+const char* Parse::find(const char* begin, const char* end, char c)
+{
+	const char* p = begin;
+#ifdef PARSE_SSE2
+	const __m128i needle = _mm_set1_epi8(c);
+	for (; p + 16 <= end; p += 16) {
+		unsigned mask = matches(p, needle);
+		if (mask != 0) return p + firstBit(mask);
+	}
+#endif
+	for (; p < end; ++p) {
+		if (*p == c) return p;
+	}
+	return end;
+}
+
+size_t Parse::split(Token line, char delimiter, Token* fields, size_t maxFields)
+{
+	if (maxFields == 0) return 0;
+	size_t n = 0;
+	const char* start = line.begin;
+	const char* p = line.begin;
+#ifdef PARSE_SSE2
+	// every delimiter of 16 bytes from one compare
+	const __m128i needle = _mm_set1_epi8(delimiter);
+	for (; p + 16 <= line.end && n + 1 < maxFields; p += 16) {
+		for (unsigned mask = matches(p, needle); mask != 0 && n + 1 < maxFields; mask &= mask - 1) {
+			const char* d = p + firstBit(mask);
+			fields[n++] = token(start, d);
+			start = d + 1;
+		}
+	}
+	p = std::max(p, start);
+#endif
+	for (; p < line.end && n + 1 < maxFields; ++p) {
+		if (*p == delimiter) {
+			fields[n++] = token(start, p);
+			start = p + 1;
+		}
+	}
+	fields[n++] = token(start, line.end);
+	return n;
+}
+
+bool Parse::LineReader::next(Token& line)
+{
+	if (pos >= end) return false;
+	const char* newline = find(pos, end, '\n');
+	line = token(pos, newline);
+	if (line.end > line.begin && line.end[-1] == '\r') --line.end;
+	pos = newline == end ? end : newline + 1;
+	return true;
+}
+
+size_t Parse::LineReader::next(Token& line, char delimiter, Token* fields, size_t maxFields)
+{
+	if (pos >= end || maxFields == 0) return 0;
+	size_t n = 0;
+	const char* start = pos;
+	const char* p = pos;
+	const char* newline = nullptr;
+#ifdef PARSE_SSE2
+	// the delimiters before the first newline of 16 bytes, from the same loads
+	const __m128i newlines = _mm_set1_epi8('\n');
+	const __m128i delimiters = _mm_set1_epi8(delimiter);
+	for (; newline == nullptr && p + 16 <= end; p += 16) {
+		unsigned lineMask = matches(p, newlines);
+		unsigned mask = n + 1 < maxFields ? matches(p, delimiters) : 0;
+		if (lineMask != 0) {
+			newline = p + firstBit(lineMask);
+			mask &= (lineMask & (0u - lineMask)) - 1;
+		}
+		for (; mask != 0 && n + 1 < maxFields; mask &= mask - 1) {
+			const char* d = p + firstBit(mask);
+			fields[n++] = token(start, d);
+			start = d + 1;
+		}
+	}
+	if (newline == nullptr) p = std::max(p, start);
+#endif
+	for (; newline == nullptr && p < end; ++p) {
+		if (*p == '\n') newline = p;
+		else if (*p == delimiter && n + 1 < maxFields) {
+			fields[n++] = token(start, p);
+			start = p + 1;
+		}
+	}
+	if (newline == nullptr) newline = end;
+	line = token(pos, newline);
+	if (line.end > line.begin && line.end[-1] == '\r') --line.end;
+	fields[n++] = token(std::min(start, line.end), line.end);
+	pos = newline == end ? end : newline + 1;
+	return n;
+}
+
+Parse::Source::Source(const std::string& path, const std::string& dictionary)
+{
+	if (path.size() > 1 && path[path.size() - 1] == 'z') {
+		// never mapped as text, an empty text is an empty source
+		CompressedFileReader reader(path, dictionary);
+		text = reader.read(INT_MIN, INT_MAX);
+		return;
+	}
+	if (boost::filesystem::exists(path) && boost::filesystem::file_size(path) == 0) return; // cannot be mapped
+	file.open(path);
+	if (!file.is_open()) throw std::runtime_error("cannot open " + path);
+}
+
+// ====================================================================================
+// RGD
+// ====================================================================================
+
+namespace
+{
+	// RGDB::EVENT_KINDS if it is not an event name
+	RGDB::EventKind eventKind(Token name)
+	{
+		static const std::vector<size_t> lengths = []() {
+			std::vector<size_t> l;
+			for (uint8_t kind = 0; kind < RGDB::EVENT_KINDS; ++kind) l.push_back(strlen(RGDB::eventName(kind)));
+			return l;
+		}();
+		for (uint8_t kind = 0; kind < RGDB::EVENT_KINDS; ++kind) {
+			if (name.size() == lengths[kind] && *name.begin == *RGDB::eventName(kind)
+				&& memcmp(name.begin, RGDB::eventName(kind), lengths[kind]) == 0) {
+				return static_cast<RGDB::EventKind>(kind);
+			}
+		}
+		return RGDB::EVENT_KINDS;
+	}
+}
+
+RGDParser::RGDParser(const char* data, size_t size)
+	: lines(data, size), lastFrame(0)
+{
+	header.startPositions = 0;
+	header.repPath = header.mapName = token(data, data);
+	Token line;
+	bool players = false;
+	while (lines.next(line)) {
+		if (line == "Begin replay data:") break;
+		if (startsWith(line, "RepPath: ")) header.repPath = token(line.begin + 9, line.end);
+		else if (startsWith(line, "MapName: ")) header.mapName = token(line.begin + 9, line.end);
+		else if (startsWith(line, "NumStartPositions: ")) header.startPositions = token(line.begin + 19, line.end).toInt();
+		else if (line == "The following players are in this replay:") players = true;
+		else if (players) {
+			Token fields[4];
+			if (Parse::split(line, ',', fields, 4) < 4) continue;
+			RGDHeader::Player player = { fields[0].toInt(), trimmed(fields[1]), trimmed(fields[2]), fields[3].toInt() };
+			header.players.push_back(player);
+		}
+	}
+}
+
+bool RGDParser::next(RGDEvent& event)
+{
+	Token line;
+	Token fields[9];
+	size_t n = lines.next(line, ',', fields, 4);
+	if (n == 0) return false;
+	memset(&event, 0, sizeof(event));
+	if (line == "[EndGame]") {
+		event.frame = lastFrame;
+		event.player = -1;
+		event.kind = RGDB::EndGame;
+		return true;
+	}
+
+	// $frame,$player,$kind,... the texts of SendMessage and IsAttacked can have commas
+	event.frame = lastFrame = fields[0].toInt();
+	event.player = n > 1 ? fields[1].toInt() : -1;
+	event.kind = n > 2 ? eventKind(fields[2]) : RGDB::EVENT_KINDS;
+	Token rest = n > 3 ? fields[3] : token(line.end, line.end);
+	switch (event.kind) {
+	case RGDB::Created:
+	case RGDB::Destroyed:
+	case RGDB::Morph:
+	case RGDB::Discovered:
+		n = Parse::split(rest, ',', fields, 4);
+		event.unit = fields[0].toInt();
+		if (n > 1) event.type = fields[1];
+		if (n > 3) {
+			event.x = fields[2].toInt();
+			event.y = fields[3].toInt();
+		}
+		break;
+	case RGDB::R:
+		n = Parse::split(rest, ',', fields, 6);
+		if (n == 6) {
+			RGDB::Resources r = { fields[0].toInt(), fields[1].toInt(), fields[2].toInt(), fields[3].toInt(), fields[4].toInt(), fields[5].toInt() };
+			event.resources = r;
+		}
+		break;
+	case RGDB::ChangedOwnership:
+		event.unit = rest.toInt();
+		break;
+	case RGDB::StartResearch:
+	case RGDB::FinishResearch:
+	case RGDB::CancelResearch:
+		event.type = rest;
+		break;
+	case RGDB::StartUpgrade:
+	case RGDB::FinishUpgrade:
+	case RGDB::CancelUpgrade:
+		n = Parse::split(rest, ',', fields, 2);
+		event.type = fields[0];
+		if (n > 1) event.value = fields[1].toInt();
+		break;
+	case RGDB::SendMessage:
+		event.text = rest;
+		break;
+	case RGDB::NuclearLaunch:
+		n = Parse::split(rest, ',', fields, 2);
+		event.x = fields[0].toInt();
+		if (n > 1) event.y = fields[1].toInt();
+		break;
+	case RGDB::IsAttacked: {
+		// ($attackTypes),($initX,$initY),...
+		event.text = rest;
+		const char* position = Parse::find(rest.begin, rest.end, ')');
+		if (position + 2 < rest.end) {
+			n = Parse::split(token(position + 2, rest.end), ',', fields, 3);
+			event.x = fields[0].toInt();
+			if (n > 1) event.y = fields[1].toInt();
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	return true;
+}
+
+// ====================================================================================
+// ROD
+// ====================================================================================
+
+bool RODParser::next(RODEvent& event)
+{
+	Token line;
+	Token fields[6];
+	size_t n;
+	do {
+		n = lines.next(line, ',', fields, 6);
+		if (n == 0) return false;
+	} while (n < 6);
+	event.frame = fields[0].toInt();
+	event.unit = fields[1].toInt();
+	event.order = fields[2];
+	event.unitTarget = fields[3] == "T";
+	event.x = fields[4].toInt();
+	event.y = fields[5].toInt();
+	return true;
+}
+
+// ====================================================================================
+// RLD
+// ====================================================================================
+
+int DistanceTable::distance(int from, int to) const
+{
+	auto i = std::lower_bound(ids.begin(), ids.end(), from);
+	auto j = std::lower_bound(ids.begin(), ids.end(), to);
+	if (i == ids.end() || *i != from || j == ids.end() || *j != to) return -1;
+	return distances[(i - ids.begin()) * ids.size() + (j - ids.begin())];
+}
+
+namespace
+{
+	// "Regions,$id,..." then one line per id, from the biggest: "$id,{$distanceToSmallerId}"
+	void readDistances(Parse::LineReader& lines, Token columns, DistanceTable& table)
+	{
+		std::vector<Token> fields(1 + std::count(columns.begin, columns.end, ','));
+		size_t n = Parse::split(columns, ',', fields.data(), fields.size());
+		for (size_t i = 1; i < n; ++i) table.ids.push_back(fields[i].toInt());
+		std::sort(table.ids.begin(), table.ids.end());
+		size_t size = table.ids.size();
+		table.distances.assign(size * size, -1);
+		for (size_t i = 0; i < size; ++i) table.distances[i * size + i] = 0;
+
+		fields.resize(size + 1);
+		Token line;
+		for (size_t row = 0; row < size && lines.next(line); ++row) {
+			n = Parse::split(line, ',', fields.data(), fields.size());
+			auto it = std::lower_bound(table.ids.begin(), table.ids.end(), fields[0].toInt());
+			if (it == table.ids.end()) continue;
+			size_t from = it - table.ids.begin();
+			for (size_t to = 0; to + 1 < n && to < from; ++to) {
+				table.distances[from * size + to] = table.distances[to * size + from] = fields[to + 1].toInt();
+			}
+		}
+	}
+}
+
+RLDParser::RLDParser(const char* data, size_t size)
+	: lines(data, size)
+{
+	Token line;
+	while (lines.next(line)) {
+		if (line == "[Replay Start]") break;
+		if (startsWith(line, "Regions,")) readDistances(lines, line, regions);
+		else if (startsWith(line, "ChokeDepReg,")) readDistances(lines, line, cdrs);
+	}
+}
+
+bool RLDParser::next(RLDEvent& event)
+{
+	Token line;
+	Token fields[4];
+	size_t n;
+	do {
+		n = lines.next(line, ',', fields, 4);
+		if (n == 0) return false;
+	} while (n < 4);
+	event.frame = fields[0].toInt();
+	event.unit = fields[1].toInt();
+	event.x = event.y = event.region = 0;
+	if (fields[2] == "Reg" || fields[2] == "CDR") {
+		event.kind = fields[2] == "Reg" ? RLDEvent::Region : RLDEvent::CDR;
+		event.region = fields[3].toInt();
+	} else {
+		event.kind = RLDEvent::Position;
+		event.x = fields[2].toInt();
+		event.y = fields[3].toInt();
+	}
+	return true;
+}
+
+// ====================================================================================
+// RCD
+// ====================================================================================
+
+RCDParser::RCDParser(const char* data, size_t size)
+	: lines(data, size), hasPending(false)
+{
+	// $replayPath,$mapHash, the path can have commas
+	Token line = token(data, data);
+	lines.next(line);
+	const char* comma = line.end;
+	while (comma > line.begin && comma[-1] != ',') --comma;
+	replayPath = token(line.begin, comma > line.begin ? comma - 1 : line.end);
+	mapHash = token(comma > line.begin ? comma : line.end, line.end);
+}
+
+bool RCDParser::next(RCDCombat& combat)
+{
+	Token line;
+	if (hasPending) {
+		line = pending;
+		hasPending = false;
+	} else {
+		do {
+			if (!lines.next(line)) return false;
+		} while (!startsWith(line, "NEW_COMBAT,"));
+	}
+
+	// NEW_COMBAT,$startFrame,$endFrame,$reason
+	Token fields[7];
+	size_t n = Parse::split(line, ',', fields, 4);
+	combat.startFrame = n > 1 ? fields[1].toInt() : 0;
+	combat.endFrame = n > 2 ? fields[2].toInt() : 0;
+	combat.reason = n > 3 ? fields[3] : token(line.end, line.end);
+	combat.armies.clear();
+	combat.kills.clear();
+	combat.notParticipated.clear();
+
+	enum Section { None, ArmyStart, ArmyEnd, Kills, NotParticipated } section = None;
+	size_t army = 0;
+	auto armyOf = [&combat](int player) {
+		for (size_t i = 0; i < combat.armies.size(); ++i) {
+			if (combat.armies[i].player == player) return i;
+		}
+		RCDCombat::Army a;
+		a.player = player;
+		a.upgrades = a.techs = Token();
+		combat.armies.push_back(a);
+		return combat.armies.size() - 1;
+	};
+
+	while (lines.next(line)) {
+		if (startsWith(line, "NEW_COMBAT,")) {
+			pending = line;
+			hasPending = true;
+			break;
+		}
+		if (startsWith(line, "ARMY_UPGRADES ") || startsWith(line, "ARMY_TECHS ")) {
+			bool upgrades = line.begin[5] == 'U';
+			const char* player = Parse::find(line.begin, line.end, ' ') + 1;
+			const char* comma = Parse::find(player, line.end, ',');
+			RCDCombat::Army& a = combat.armies[armyOf(token(player, comma).toInt())];
+			(upgrades ? a.upgrades : a.techs) = token(comma < line.end ? comma + 1 : comma, line.end);
+		} else if (startsWith(line, "ARMY_START ") || startsWith(line, "ARMY_END ")) {
+			section = line.begin[5] == 'S' ? ArmyStart : ArmyEnd;
+			army = armyOf(token(Parse::find(line.begin, line.end, ' ') + 1, line.end).toInt());
+		} else if (line == "KILLS") {
+			section = Kills;
+		} else if (line == "UNITS_NOT_PARTICIPATED") {
+			section = NotParticipated;
+		} else if (section == ArmyStart || section == ArmyEnd) {
+			if (Parse::split(line, ',', fields, 7) < 7) continue;
+			RCDCombat::Unit unit = { fields[0].toInt(), fields[1], fields[2].toInt(), fields[3].toInt(),
+				fields[4].toInt(), fields[5].toInt(), fields[6].toInt() };
+			(section == ArmyStart ? combat.armies[army].start : combat.armies[army].end).push_back(unit);
+		} else if (section == Kills) {
+			n = Parse::split(line, ',', fields, 3);
+			RCDCombat::Kill kill = { fields[0].toInt(), n > 1 ? fields[1].toInt() : 0, n > 2 && fields[2] == "LOADED" };
+			combat.kills.push_back(kill);
+		} else if (section == NotParticipated) {
+			for (const char* p = line.begin; p < line.end;) {
+				const char* comma = Parse::find(p, line.end, ',');
+				combat.notParticipated.push_back(token(p, comma).toInt());
+				p = comma + 1;
+			}
+		}
+	}
+	return true;
+}
+
+// ====================================================================================
+// ASD
+// ====================================================================================
+
+bool ASDParser::next(ASDSample& sample)
+{
+	// $unitType,$unitTypeName,$region,$order,$targetRegion#{ATTACK|MOVE:$region}#{$region:$f,$e,$tf,$te}
+	Token line;
+	Token fields[5];
+	const char* hash;
+	do {
+		if (!lines.next(line)) return false;
+		hash = Parse::find(line.begin, line.end, '#');
+	} while (Parse::split(token(line.begin, hash), ',', fields, 5) < 5); // empty or truncated line
+	sample.unitType = fields[0].toInt();
+	sample.unitTypeName = fields[1];
+	sample.region = fields[2].toInt();
+	sample.order = fields[3];
+	sample.targetRegion = fields[4].toInt();
+	sample.actions = token(line.end, line.end);
+	sample.canAttack = false;
+	sample.moves.clear();
+	sample.regions.clear();
+	if (hash == line.end) return true;
+
+	const char* p = hash + 1;
+	const char* end = Parse::find(p, line.end, '#');
+	sample.actions = token(p, end);
+	while (p < end) {
+		const char* comma = Parse::find(p, end, ',');
+		Token action = token(p, comma);
+		if (action == "ATTACK") sample.canAttack = true;
+		else if (startsWith(action, "MOVE:")) sample.moves.push_back(token(action.begin + 5, action.end).toInt());
+		p = comma + 1;
+	}
+	while (end < line.end) {
+		p = end + 1;
+		end = Parse::find(p, line.end, '#');
+		const char* colon = Parse::find(p, end, ':');
+		if (colon == end) continue;
+		size_t n = Parse::split(token(colon + 1, end), ',', fields, 4);
+		ASDSample::RegionFeatures features = { token(p, colon).toInt(), fields[0] == "1",
+			n > 1 && fields[1] == "1", n > 2 && fields[2] == "1", n > 3 && fields[3] == "1" };
+		sample.regions.push_back(features);
+	}
+	return true;
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "boost/iostreams/device/mapped_file.hpp"
+
+#include "RGDSchema.h"
+
+// Readers of the text outputs (RGD, ROD, RLD, RCD, ASD) for the analysis tools, replacing the
+// line.split(',') of the Python scripts. The text is read in place (memory mapped file, or a
+// stream of a CorpusReader) and cut with SSE2 scans for the newlines and the delimiters, the
+// events are returned as structs whose strings (Token) point into the text:
+//
+//   Parse::Source source("replay.rep.rgd"); // .rodz and .rldz are decompressed first
+//   RGDParser rgd(source.data(), source.size());
+//   for (const auto& e : rgd) {
+//       if (e.kind == RGDB::Created) count[e.type.str()]++;
+//   }
+//
+// Unit, order, tech and upgrade types are the BWAPI names as written, it does not depend on BWAPI.
+// Lines may end with "\r\n" (files written in text mode on Windows).
+namespace Parse
+{
+	// [begin, end) of the text, not null terminated
+	struct Token
+	{
+		const char* begin;
+		const char* end;
+
+		size_t size() const { return end - begin; }
+		bool empty() const { return begin == end; }
+		std::string str() const { return std::string(begin, end); }
+		bool operator==(const char* s) const { return size() == strlen(s) && memcmp(begin, s, size()) == 0; }
+		bool operator!=(const char* s) const { return !(*this == s); }
+		int toInt() const;       // skips a leading '(' or ' ', stops at the first non digit
+		double toDouble() const;
+	};
+
+	inline int Token::toInt() const
+	{
+		const char* p = begin;
+		while (p < end && (*p == '(' || *p == ' ')) ++p;
+		bool negative = p < end && *p == '-';
+		if (negative) ++p;
+		int value = 0;
+		for (; p < end && static_cast<unsigned>(*p - '0') < 10; ++p) value = value * 10 + (*p - '0');
+		return negative ? -value : value;
+	}
+
+	const char* find(const char* begin, const char* end, char c); // end if not found
+	// splits on delimiter, at most maxFields fields, the last one holds the rest of the line
+	size_t split(Token line, char delimiter, Token* fields, size_t maxFields);
+
+	class LineReader
+	{
+	public:
+		LineReader(const char* data, size_t size) : pos(data), end(data + size) {}
+		bool next(Token& line); // without the "\n" or "\r\n"
+		// next line and its fields as split() in the same scan, 0 at the end of the text
+		size_t next(Token& line, char delimiter, Token* fields, size_t maxFields);
+	private:
+		const char* pos;
+		const char* end;
+	};
+
+	// a file memory mapped, or decompressed if it is a .rodz/.rldz (see CompressedFile.h)
+	class Source
+	{
+	public:
+		Source(const std::string& path, const std::string& dictionary = ""); // throws std::runtime_error
+		const char* data() const { return text.empty() ? file.data() : text.data(); }
+		size_t size() const { return text.empty() ? file.size() : text.size(); }
+	private:
+		boost::iostreams::mapped_file_source file;
+		std::string text;
+	};
+
+	// gives the range-for iterators to Parser, which has a bool next(Event&)
+	template <class Parser, class Event>
+	class EventParser
+	{
+	public:
+		class iterator
+		{
+		public:
+			iterator(Parser* p) : parser(p) { ++*this; }
+			const Event& operator*() const { return event; }
+			const Event* operator->() const { return &event; }
+			iterator& operator++()
+			{
+				if (parser != nullptr && !parser->next(event)) parser = nullptr;
+				return *this;
+			}
+			bool operator!=(const iterator& other) const { return parser != other.parser; }
+			bool operator==(const iterator& other) const { return parser == other.parser; }
+		private:
+			Parser* parser;
+			Event event;
+		};
+		iterator begin() { return iterator(static_cast<Parser*>(this)); }
+		iterator end() { return iterator(nullptr); }
+	};
+}
+
+// ====================================================================================
+// RGD
+// ====================================================================================
+
+struct RGDHeader
+{
+	struct Player
+	{
+		int id;
+		Parse::Token name;
+		Parse::Token race;
+		int startLocation;
+	};
+	Parse::Token repPath;
+	Parse::Token mapName;
+	int startPositions;
+	std::vector<Player> players;
+};
+
+// fields as in the RGDB columns (see RGDSchema.h), the unused ones are 0 (empty tokens)
+struct RGDEvent
+{
+	int frame;
+	int player;
+	RGDB::EventKind kind; // RGDB::EVENT_KINDS if it is unknown
+	int unit;
+	Parse::Token type;    // unit, tech or upgrade type
+	int x;
+	int y;
+	int value;            // upgrade level
+	RGDB::Resources resources;
+	Parse::Token text;    // SendMessage: message, IsAttacked: the rest of the line after "IsAttacked,"
+};
+
+class RGDParser : public Parse::EventParser<RGDParser, RGDEvent>
+{
+public:
+	RGDParser(const char* data, size_t size); // reads the header
+	const RGDHeader& getHeader() const { return header; }
+	bool next(RGDEvent& event);
+private:
+	Parse::LineReader lines;
+	RGDHeader header;
+	int lastFrame;
+};
+
+// ====================================================================================
+// ROD
+// ====================================================================================
+
+struct RODEvent
+{
+	int frame;
+	int unit;
+	Parse::Token order;
+	bool unitTarget; // T: position of the target unit, P: target position of the order
+	int x;
+	int y;
+};
+
+class RODParser : public Parse::EventParser<RODParser, RODEvent>
+{
+public:
+	RODParser(const char* data, size_t size) : lines(data, size) {}
+	bool next(RODEvent& event);
+private:
+	Parse::LineReader lines;
+};
+
+// ====================================================================================
+// RLD
+// ====================================================================================
+
+// distances between regions (or CDRs) of the RLD header, -1 if unknown
+struct DistanceTable
+{
+	std::vector<int> ids; // sorted
+	std::vector<int> distances; // ids.size() x ids.size()
+	int distance(int from, int to) const;
+};
+
+struct RLDEvent
+{
+	enum Kind { Position, Region, CDR };
+	int frame;
+	int unit;
+	Kind kind;
+	int x;      // Position
+	int y;
+	int region; // Region and CDR
+};
+
+class RLDParser : public Parse::EventParser<RLDParser, RLDEvent>
+{
+public:
+	RLDParser(const char* data, size_t size); // reads the distances tables
+	const DistanceTable& getRegions() const { return regions; }
+	const DistanceTable& getCDRs() const { return cdrs; }
+	bool next(RLDEvent& event);
+private:
+	Parse::LineReader lines;
+	DistanceTable regions;
+	DistanceTable cdrs;
+};
+
+// ====================================================================================
+// RCD
+// ====================================================================================
+
+struct RCDCombat
+{
+	struct Unit
+	{
+		int id;
+		Parse::Token type;
+		int x; // TilePosition
+		int y;
+		int hitPoints;
+		int shields;
+		int energy;
+	};
+	struct Army
+	{
+		int player;
+		Parse::Token upgrades; // "$upgradeName:$level,..."
+		Parse::Token techs;    // "$techName,..."
+		std::vector<Unit> start;
+		std::vector<Unit> end;
+	};
+	struct Kill
+	{
+		int unit;
+		int frame;
+		bool loaded;
+	};
+	int startFrame;
+	int endFrame;
+	Parse::Token reason; // GAME_END, REINFORCEMENT $unitID, ARMY_DESTROYED, PEACE
+	std::vector<Army> armies;
+	std::vector<Kill> kills;
+	std::vector<int> notParticipated;
+};
+
+class RCDParser : public Parse::EventParser<RCDParser, RCDCombat>
+{
+public:
+	RCDParser(const char* data, size_t size); // reads the header
+	Parse::Token getReplayPath() const { return replayPath; }
+	Parse::Token getMapHash() const { return mapHash; }
+	bool next(RCDCombat& combat); // the vectors of combat are reused
+private:
+	Parse::LineReader lines;
+	Parse::Token replayPath;
+	Parse::Token mapHash;
+	Parse::Token pending; // NEW_COMBAT line of the next combat
+	bool hasPending;
+};
+
+// ====================================================================================
+// ASD
+// ====================================================================================
+
+struct ASDSample
+{
+	struct RegionFeatures
+	{
+		int region;
+		bool hasFriend;
+		bool hasEnemy;
+		bool towardsFriendBase;
+		bool towardsEnemyBase;
+	};
+	int unitType;
+	Parse::Token unitTypeName;
+	int region;
+	Parse::Token order; // AbstractOrder name: Nothing, Idle, Attack, Move, ...
+	int targetRegion;
+	Parse::Token actions;                // possible actions as written, "ATTACK,MOVE:$region,..."
+	bool canAttack;                      // ATTACK is possible (IDLE always is)
+	std::vector<int> moves;              // MOVE:$region possible
+	std::vector<RegionFeatures> regions; // current region, then its neighbors
+};
+
+class ASDParser : public Parse::EventParser<ASDParser, ASDSample>
+{
+public:
+	ASDParser(const char* data, size_t size) : lines(data, size) {}
+	bool next(ASDSample& sample); // the vectors of sample are reused
+private:
+	Parse::LineReader lines;
+};
@@ -1,96 +1,28 @@
 #pragma once
 
 #include <fstream>
-#include <filesystem>
 
-#include "boost/archive/binary_oarchive.hpp"
-#include "boost/archive/binary_iarchive.hpp"
-#include "boost/serialization/map.hpp"
-#include "boost/serialization/vector.hpp"
-#include "boost/serialization/utility.hpp"
-
-#include <BWAPI.h>
-#include <BWTA.h>
-
-#include "Utils.h"
-
-typedef int ChokeDepReg;
-
-struct PathAwareMaps
-{
-	friend class boost::serialization::access;
-	template <class archive>
-	void serialize(archive & ar, const unsigned int version)
-	{
-		ar & regionsPFCenters;
-		ar & distRegions;
-		ar & distCDR;
-	}
-	std::map<int, std::pair<int, int> > regionsPFCenters; // Pathfinding wise region centers
-	std::map<int, std::map<int, double> > distRegions; // distRegions[R1][R2] w.r.t regionsPFCenters
-	std::map<int, std::map<int, double> > distCDR;
-};
-BOOST_CLASS_TRACKING(PathAwareMaps, boost::serialization::track_never);
-BOOST_CLASS_VERSION(PathAwareMaps, 1);
-
-struct RegionsData
-{
-	friend class boost::serialization::access;
-	template <class Archive>
-	void serialize(Archive & ar, const unsigned int version)
-	{
-		ar & chokeDependantRegion;
-	}
-	// -1 -> unwalkable regions
-	std::vector<std::vector<ChokeDepReg> > chokeDependantRegion;
-	RegionsData()
-		: chokeDependantRegion(std::vector<std::vector<ChokeDepReg> >(BWAPI::Broodwar->mapWidth(), std::vector<ChokeDepReg>(BWAPI::Broodwar->mapHeight(), -1)))
-	{}
-	RegionsData(const std::vector<std::vector<ChokeDepReg> >& cdr)
-		: chokeDependantRegion(cdr)
-	{}
-};
-BOOST_CLASS_TRACKING(RegionsData, boost::serialization::track_never);
-BOOST_CLASS_VERSION(RegionsData, 2);
-
-// Neither Region* (of course) nor the ordering in the Regions set is
-// deterministic, so we have a map which maps Region* to a unique int
-// which is region's center (0)<x Position + 1><y Position>
-// on                               16 bits      16 bits
+#include "MapModel.h"
+#include "CompressedFile.h"
 
+// Locations of the units over the replay (RLD file), in the regions and CDRs of the MapModel
 class TerrainAnalyzer
 {
 public:
-	RegionsData regionData;
-	PathAwareMaps _pfMaps;
-	std::set<ChokeDepReg> allChokeDepRegs;
-
-	TerrainAnalyzer(); // Generates RLD file
+	TerrainAnalyzer(const MapModel& map); // Generates RLD file
 	~TerrainAnalyzer();
 	void onFrame();
-	void onUnitCreate(const BWAPI::Unit& unit);
-
-	bool isWalkable(const BWAPI::TilePosition& tp);
-	BWAPI::TilePosition findClosestWalkable(const BWAPI::TilePosition& tp);
-	BWAPI::TilePosition findClosestWalkableSameCDR(const BWAPI::TilePosition& p, ChokeDepReg c);
-	BWTA::Region* findClosestRegion(const BWAPI::TilePosition& tp);
-	ChokeDepReg findClosestCDR(const BWAPI::TilePosition& tp);
-	BWTA::Region* findClosestReachableRegion(BWTA::Region* q, BWTA::Region* r);
-	ChokeDepReg findClosestReachableCDR(ChokeDepReg q, ChokeDepReg cdr);
-	int hashRegionCenter(BWTA::Region* r);
+	void onUnitCreate(const Dump::Unit& unit);
 
 private:
-	std::ofstream replayLocationDat;
+	const MapModel& map;
+	CompressedOutputFile replayLocationDat;
 	std::ofstream replayOrdersDat;
 
-	std::map<BWAPI::Unit, BWAPI::Position> unitPositionMap;
-	std::map<BWAPI::Unit, ChokeDepReg> unitCDR;
-	std::map<BWAPI::Unit, BWTA::Region*> unitRegion;
-
-	bool* _lowResWalkability;
+	std::map<Dump::Unit, BWAPI::Position, Dump::ByID> unitPositionMap;
+	std::map<Dump::Unit, ChokeDepReg, Dump::ByID> unitCDR;
+	std::map<Dump::Unit, Dump::Region*, Dump::ByID> unitRegion;
 
-	void createChokeDependantRegions();
-	BWAPI::Position regionsPFCenters(BWTA::Region* r);
-	BWAPI::TilePosition cdrCenter(ChokeDepReg c);
+	void writeDistances(const std::string& name, const DistanceMatrix& matrix);
 	void displayChokeDependantRegions();
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "TerrainCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "boost/filesystem.hpp"
+
+#include "Utils.h"
+
+namespace
+{
+	uint64_t fnv1a(const char* data, size_t size)
+	{
+		uint64_t h = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; ++i) {
+			h ^= static_cast<unsigned char>(data[i]);
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	uint64_t align8(uint64_t offset)
+	{
+		return (offset + 7) & ~uint64_t(7);
+	}
+
+	uint16_t quantize(double distance)
+	{
+		if (distance < 0.0) return TerrainCache::NO_PATH;
+		if (distance >= TerrainCache::MAX_DISTANCE) return TerrainCache::MAX_DISTANCE;
+		return static_cast<uint16_t>(distance);
+	}
+}
+
+const char* TerrainCache::check(const char* data, size_t size, int width, int height)
+{
+	if (size < sizeof(Header)) return "too small";
+	Header header;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != MAGIC) return "not a terrain cache";
+	if (header.version != VERSION) return "other version";
+	if (header.width != width || header.height != height) return "other map size";
+	if (header.size != size) return "truncated";
+	uint64_t r = header.regions;
+	uint64_t c = header.cdrs;
+	uint64_t s = header.sortedRegions;
+	if (header.tiles < sizeof(Header) || header.tiles + uint64_t(width) * height * sizeof(TerrainCache::Tile) > size
+		|| header.regionIds + r * 4 > size || header.regionCenters + r * 8 > size || header.regionDistances + r * r * 2 > size
+		|| header.cdrIds + c * 4 > size || header.cdrDistances + c * c * 2 > size
+		|| header.closestRegions + uint64_t(width) * height * 4 > size || header.closestCDRs + uint64_t(width) * height * 4 > size
+		|| header.closestWalkable + uint64_t(width) * height * 4 > size
+		|| header.sortedRegionMap + uint64_t(width) * height * 4 > size || header.sortedRegionDistances + s * s * 4 > size) return "arrays out of the file";
+	if (fnv1a(data + sizeof(Header), size - sizeof(Header)) != header.checksum) return "wrong checksum";
+	return nullptr;
+}
+
+bool TerrainCacheFile::open(const std::string& path, int width, int height)
+{
+	if (!boost::filesystem::exists(path)) return false;
+	try {
+		file.open(path);
+	} catch (const std::exception& e) {
+		LOG("[TERRAIN] cannot map " << path << ": " << e.what());
+		return false;
+	}
+	const char* reason = TerrainCache::check(file.data(), file.size(), width, height);
+	if (reason != nullptr) {
+		LOG("[TERRAIN] " << path << " rejected (" << reason << "), computing it again");
+		file.close();
+		return false;
+	}
+	data = file.data();
+	return true;
+}
+
+void TerrainCacheFile::create(const std::string& path, int width, int height, const TerrainCache::Data& arrays)
+{
+	TerrainCache::Header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = TerrainCache::MAGIC;
+	header.version = TerrainCache::VERSION;
+	header.width = width;
+	header.height = height;
+	header.regions = static_cast<uint32_t>(arrays.regionIds.size());
+	header.cdrs = static_cast<uint32_t>(arrays.cdrIds.size());
+	header.sortedRegions = static_cast<uint32_t>(arrays.sortedRegions);
+	header.tiles = align8(sizeof(header));
+	header.regionIds = align8(header.tiles + arrays.tiles.size() * sizeof(TerrainCache::Tile));
+	header.regionCenters = align8(header.regionIds + arrays.regionIds.size() * 4);
+	header.regionDistances = align8(header.regionCenters + arrays.regionCenters.size() * 4);
+	header.cdrIds = align8(header.regionDistances + arrays.regionDistances.size() * 2);
+	header.cdrDistances = align8(header.cdrIds + arrays.cdrIds.size() * 4);
+	header.closestRegions = align8(header.cdrDistances + arrays.cdrDistances.size() * 2);
+	header.closestCDRs = align8(header.closestRegions + arrays.closestRegions.size() * 4);
+	header.closestWalkable = align8(header.closestCDRs + arrays.closestCDRs.size() * 4);
+	header.sortedRegionMap = align8(header.closestWalkable + arrays.closestWalkable.size() * 4);
+	header.sortedRegionDistances = align8(header.sortedRegionMap + arrays.sortedRegionMap.size() * 4);
+	header.size = align8(header.sortedRegionDistances + arrays.sortedRegionDistances.size() * 4);
+
+	image.assign(header.size / 8, 0);
+	char* out = reinterpret_cast<char*>(image.data());
+	memcpy(out + header.tiles, arrays.tiles.data(), arrays.tiles.size() * sizeof(TerrainCache::Tile));
+	memcpy(out + header.regionIds, arrays.regionIds.data(), arrays.regionIds.size() * 4);
+	memcpy(out + header.regionCenters, arrays.regionCenters.data(), arrays.regionCenters.size() * 4);
+	uint16_t* distances = reinterpret_cast<uint16_t*>(out + header.regionDistances);
+	for (size_t i = 0; i < arrays.regionDistances.size(); ++i) distances[i] = quantize(arrays.regionDistances[i]);
+	memcpy(out + header.cdrIds, arrays.cdrIds.data(), arrays.cdrIds.size() * 4);
+	distances = reinterpret_cast<uint16_t*>(out + header.cdrDistances);
+	for (size_t i = 0; i < arrays.cdrDistances.size(); ++i) distances[i] = quantize(arrays.cdrDistances[i]);
+	memcpy(out + header.closestRegions, arrays.closestRegions.data(), arrays.closestRegions.size() * 4);
+	memcpy(out + header.closestCDRs, arrays.closestCDRs.data(), arrays.closestCDRs.size() * 4);
+	memcpy(out + header.closestWalkable, arrays.closestWalkable.data(), arrays.closestWalkable.size() * 4);
+	memcpy(out + header.sortedRegionMap, arrays.sortedRegionMap.data(), arrays.sortedRegionMap.size() * 4);
+	memcpy(out + header.sortedRegionDistances, arrays.sortedRegionDistances.data(), arrays.sortedRegionDistances.size() * 4);
+	header.checksum = fnv1a(out + sizeof(header), header.size - sizeof(header));
+	memcpy(out, &header, sizeof(header));
+	data = out;
+
+	boost::filesystem::path tmp(path);
+	tmp += boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp");
+	try {
+		{
+			std::ofstream ofs(tmp.string().c_str(), std::ios::binary);
+			ofs.write(out, header.size);
+			ofs.close(); // flushes, a full disk fails here
+			if (!ofs) throw std::runtime_error("cannot write " + tmp.string());
+		}
+		boost::filesystem::rename(tmp, path);
+	} catch (const std::exception& e) {
+		LOG("[TERRAIN] " << path << " not written: " << e.what());
+		boost::system::error_code ignored;
+		boost::filesystem::remove(tmp, ignored);
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "boost/iostreams/device/mapped_file.hpp"
+
+// Cache of the terrain analysis of a map (MapModel), bwapi-data/AI/BWRepDumpCache/$mapHash.terrain.
+// The file is memory mapped and MapModel reads its arrays in place, nothing is parsed or
+// copied at the start of a replay. Little endian, each array starts on 8 bytes:
+//   TerrainCache::Header
+//   Tile   tiles[width * height]             CDR, region and walkability of each build tile
+//   int32  regionIds[regions]                hashRegionCenter of each region, sorted
+//   int32  regionCenters[regions][2]         pathfinding aware center (x, y pixels) of each region
+//   uint16 regionDistances[regions][regions] ground distances between the centers
+//   int32  cdrIds[cdrs]                      ChokeDepReg, sorted
+//   uint16 cdrDistances[cdrs][cdrs]          ground distances between the CDRs
+//   int32  closestRegions[width * height]    index in regionIds of the closest region center
+//   int32  closestCDRs[width * height]       index in cdrIds of the closest CDR center
+//   int32  closestWalkable[width * height]   x + y * width of the closest walkable tile
+//   int32  sortedRegionMap[width * height]   RegionID (ActionSelection) of each tile
+//   int32  sortedRegionDistances[sortedRegions][sortedRegions] ground distances between the region
+//                                            centers (getGroundDistance), in RegionID order
+// The per tile arrays are row-major (x + y * width, see TileGrid).
+// Distances are in pixels rounded down (as written in the RLD), NO_PATH if there is no ground path.
+// A file of another version or map size, truncated or whose checksum does not match is rejected,
+// then computed and written again. The file is written under a temporary name then renamed, so
+// processes sharing the cache folder never map a partial file.
+namespace TerrainCache
+{
+	const uint32_t MAGIC = 0x43545742; // "BWTC"
+	const uint32_t VERSION = 7;
+	const uint16_t NO_PATH = 0xFFFF;
+	const uint16_t MAX_DISTANCE = 0xFFFE; // longer distances are clamped
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		int32_t width;
+		int32_t height;
+		uint32_t regions;
+		uint32_t cdrs;
+		uint32_t sortedRegions;
+		uint32_t padding;
+		uint64_t size;     // of the file
+		uint64_t checksum; // FNV-1a 64 of the file after the header
+		uint64_t tiles;    // offsets of the arrays
+		uint64_t regionIds;
+		uint64_t regionCenters;
+		uint64_t regionDistances;
+		uint64_t cdrIds;
+		uint64_t cdrDistances;
+		uint64_t closestRegions;
+		uint64_t closestCDRs;
+		uint64_t closestWalkable;
+		uint64_t sortedRegionMap;
+		uint64_t sortedRegionDistances;
+	};
+
+	// what a lookup on a build tile needs, in one read
+	struct Tile
+	{
+		int32_t cdr;      // ChokeDepReg, -1 if none
+		int16_t region;   // index in regionIds of the region of the tile, -1 if none
+		uint8_t walkable; // all its walk tiles are walkable
+		uint8_t padding;
+	};
+	static_assert(sizeof(Tile) == 8, "TerrainCache::Tile must stay packed");
+
+	// arrays of a cache, see above, distances in pixels and -1 if there is no path,
+	// the matrices row-major in the order of the ids
+	struct Data
+	{
+		std::vector<Tile> tiles;
+		std::vector<int32_t> regionIds;
+		std::vector<int32_t> regionCenters;
+		std::vector<double> regionDistances;
+		std::vector<int32_t> cdrIds;
+		std::vector<double> cdrDistances;
+		std::vector<int32_t> closestRegions;
+		std::vector<int32_t> closestCDRs;
+		std::vector<int32_t> closestWalkable;
+		size_t sortedRegions;
+		std::vector<int32_t> sortedRegionMap;
+		std::vector<int32_t> sortedRegionDistances;
+	};
+
+	// why the data is not a valid cache of a width x height map, nullptr if it is
+	const char* check(const char* data, size_t size, int width, int height);
+}
+
+class TerrainCacheFile
+{
+public:
+	TerrainCacheFile() : data(nullptr) {}
+	// maps the file, false if it is missing or not valid for a width x height map (logged)
+	bool open(const std::string& path, int width, int height);
+	// lays out the arrays and writes them to path. Used from memory if the file cannot be written.
+	void create(const std::string& path, int width, int height, const TerrainCache::Data& data);
+
+	const TerrainCache::Header& header() const { return *reinterpret_cast<const TerrainCache::Header*>(data); }
+	template <class T>
+	const T* array(uint64_t offset) const { return reinterpret_cast<const T*>(data + offset); }
+
+private:
+	boost::iostreams::mapped_file_source file;
+	std::vector<uint64_t> image; // built by create, 8 bytes aligned
+	const char* data;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include <BWAPI/Position.h>
+
+// A value per build tile of the map in one row-major block (x + y * width), either owned or a view
+// of an array mapped from a file (TerrainCache). Reads are checked against the map in debug builds.
+template <class T>
+class TileGrid
+{
+public:
+	TileGrid() : cells(nullptr), width(0), height(0) {}
+	TileGrid(int width, int height, const T& value)
+		: storage(width * height, value), cells(storage.data()), width(width), height(height) {}
+	TileGrid(const T* mapped, int width, int height) : cells(mapped), width(width), height(height) {}
+	TileGrid(const TileGrid& other) { *this = other; }
+	TileGrid& operator=(const TileGrid& other)
+	{
+		storage = other.storage;
+		cells = storage.empty() ? other.cells : storage.data();
+		width = other.width;
+		height = other.height;
+		return *this;
+	}
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	bool isValid(int x, int y) const { return x >= 0 && y >= 0 && x < width && y < height; }
+	bool isValid(const BWAPI::TilePosition& tp) const { return isValid(tp.x, tp.y); }
+
+	const T& operator()(int x, int y) const
+	{
+		assert(isValid(x, y));
+		return cells[x + y * width];
+	}
+	const T& operator[](const BWAPI::TilePosition& tp) const { return (*this)(tp.x, tp.y); }
+	T& at(int x, int y) // owned grids only
+	{
+		assert(isValid(x, y) && !storage.empty());
+		return storage[x + y * width];
+	}
+	const T* data() const { return cells; }
+
+private:
+	std::vector<T> storage;
+	const T* cells;
+	int width;
+	int height;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+
+// Replay Trace Data (RTD) binary layout, written by TraceRecorder and read back by TraceReplayer.
+// Little endian, every record starts with a Trace::Record header and its payload is padded to 8 bytes
+// (so the Player/Unit arrays of a memory mapped trace can be read in place):
+//   Trace::FileHeader
+//   Map record       (static map, players, regions and chokepoints)
+//   Frame record     (initial state, before the extractors are created)
+//   { events (UnitCreate, UnitDestroy, ...) then the Frame record of the frame they happened }
+//   End record
+// Frame records are deltas: only the units/players whose state changed since the previous frame,
+// plus the ids of the units that stopped being accessible.
+
+namespace Trace
+{
+	const uint32_t MAGIC = 0x52545742; // "BWTR"
+	const uint32_t VERSION = 1;
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+	};
+
+	enum RecordKind : uint32_t {
+		Map = 1,
+		Frame,
+		UnitCreate,
+		UnitDestroy,
+		UnitMorph,
+		UnitRenegade,
+		ReceiveText,  // payload: int32 player, string text
+		PlayerLeft,   // payload: int32 player
+		NukeDetect,   // payload: int32 x, y
+		End
+	};
+
+	struct Record
+	{
+		uint32_t kind;
+		uint32_t size; // payload size in bytes (padding included)
+	};
+
+	// Frame payload: FrameHeader, Player[players], Unit[units], int32 removed unit ids[removed]
+	struct FrameHeader
+	{
+		int32_t frame;
+		uint32_t players;
+		uint32_t units;
+		uint32_t removed;
+	};
+
+	enum UnitFlag : uint16_t {
+		Exists				= 1 << 0,
+		Attacking			= 1 << 1,
+		UnderAttack			= 1 << 2,
+		Completed			= 1 << 3,
+		Loaded				= 1 << 4,
+		Flying				= 1 << 5,
+		Cloaked				= 1 << 6,
+		GatheringMinerals	= 1 << 7,
+		GatheringGas		= 1 << 8,
+		Repairing			= 1 << 9,
+		Constructing		= 1 << 10
+	};
+
+	// positions fit in int16 (including Positions::None/Unknown), ids of units and players are -1 when null
+	struct Unit
+	{
+		int32_t id;
+		int32_t orderTarget;
+		int32_t target;
+		int16_t x, y;
+		int16_t orderTargetX, orderTargetY;
+		int16_t targetX, targetY;
+		uint16_t type;
+		uint16_t hitPoints;
+		uint16_t shields;
+		uint16_t energy;
+		uint16_t flags;
+		uint16_t resourceGroup;
+		uint8_t order;
+		uint8_t spaceRemaining;
+		uint8_t groundWeaponCooldown;
+		uint8_t airWeaponCooldown;
+		uint8_t spellCooldown;
+		int8_t player;
+		int8_t lastAttackingPlayer;
+		uint8_t padding;
+	};
+	static_assert(sizeof(Unit) == 44, "Trace::Unit must stay packed");
+
+	// tech and upgrade ids are below 64 in BWAPI 4, upgrade levels use 2 bits each
+	struct Player
+	{
+		int32_t id;
+		int32_t minerals;
+		int32_t gas;
+		int32_t gatheredMinerals;
+		int32_t gatheredGas;
+		int32_t supplyUsed;
+		int32_t supplyTotal;
+		uint32_t padding;
+		uint64_t researching;
+		uint64_t researched;
+		uint64_t upgrading;
+		uint64_t upgradeLevels[2];
+	};
+	static_assert(sizeof(Player) == 72, "Trace::Player must stay packed");
+
+	// strings are uint32 length + chars, padded to 4 bytes
+	// Map payload:
+	//   int32 width, height (build tiles)
+	//   string mapPathName, mapName, mapHash
+	//   uint32 n, n x (int32 x, y) start locations
+	//   uint32 n, n x (int32 id, race, neutral, observer, startX, startY, string name) players
+	//   uint32 walkability bits (width*4 x height*4, row major), padded to 4 bytes
+	//   uint32 n, n x (int32 centerX, centerY, polygonCenterX, polygonCenterY, uint32 m, m x (int32 x, y)) regions
+	//   uint32 n, n x (int32 centerX, centerY, double width, int32 region1, region2, side1X, side1Y, side2X, side2Y) chokepoints
+	//   int32 region index per build tile (-1 if none), row major
+	//   double ground distance between each pair of regions centers (BWTA's, -1 if unreachable)
+}
@@ -0,0 +1,270 @@
+#include "TraceRecorder.h"
+
+#include <cstring>
+
+using namespace BWAPI;
+
+namespace
+{
+	int32_t traceID(Dump::Unit u) { return u ? u->getID() : -1; }
+	int8_t traceID(Dump::Player p) { return p ? static_cast<int8_t>(p->getID()) : -1; }
+
+	Trace::Unit toTraceUnit(Dump::Unit u)
+	{
+		Trace::Unit t = {};
+		t.id = u->getID();
+		t.orderTarget = traceID(u->getOrderTarget());
+		t.target = traceID(u->getTarget());
+		t.x = static_cast<int16_t>(u->getPosition().x);
+		t.y = static_cast<int16_t>(u->getPosition().y);
+		t.orderTargetX = static_cast<int16_t>(u->getOrderTargetPosition().x);
+		t.orderTargetY = static_cast<int16_t>(u->getOrderTargetPosition().y);
+		t.targetX = static_cast<int16_t>(u->getTargetPosition().x);
+		t.targetY = static_cast<int16_t>(u->getTargetPosition().y);
+		t.type = static_cast<uint16_t>(u->getType().getID());
+		t.hitPoints = static_cast<uint16_t>(u->getHitPoints());
+		t.shields = static_cast<uint16_t>(u->getShields());
+		t.energy = static_cast<uint16_t>(u->getEnergy());
+		t.resourceGroup = static_cast<uint16_t>(u->getResourceGroup());
+		t.order = static_cast<uint8_t>(u->getOrder().getID());
+		t.spaceRemaining = static_cast<uint8_t>(u->getSpaceRemaining());
+		t.groundWeaponCooldown = static_cast<uint8_t>(u->getGroundWeaponCooldown());
+		t.airWeaponCooldown = static_cast<uint8_t>(u->getAirWeaponCooldown());
+		t.spellCooldown = static_cast<uint8_t>(u->getSpellCooldown());
+		t.player = traceID(u->getPlayer());
+		t.lastAttackingPlayer = traceID(u->getLastAttackingPlayer());
+		if (u->exists())				t.flags |= Trace::Exists;
+		if (u->isAttacking())			t.flags |= Trace::Attacking;
+		if (u->isUnderAttack())			t.flags |= Trace::UnderAttack;
+		if (u->isCompleted())			t.flags |= Trace::Completed;
+		if (u->isLoaded())				t.flags |= Trace::Loaded;
+		if (u->isFlying())				t.flags |= Trace::Flying;
+		if (u->isCloaked())				t.flags |= Trace::Cloaked;
+		if (u->isGatheringMinerals())	t.flags |= Trace::GatheringMinerals;
+		if (u->isGatheringGas())		t.flags |= Trace::GatheringGas;
+		if (u->isRepairing())			t.flags |= Trace::Repairing;
+		if (u->isConstructing())		t.flags |= Trace::Constructing;
+		return t;
+	}
+
+	Trace::Player toTracePlayer(Dump::Player p)
+	{
+		Trace::Player t = {};
+		t.id = p->getID();
+		t.minerals = p->minerals();
+		t.gas = p->gas();
+		t.gatheredMinerals = p->gatheredMinerals();
+		t.gatheredGas = p->gatheredGas();
+		t.supplyUsed = p->supplyUsed();
+		t.supplyTotal = p->supplyTotal();
+		for (const auto& tech : TechTypes::allTechTypes()) {
+			if (tech.getID() >= 64) continue;
+			uint64_t bit = uint64_t(1) << tech.getID();
+			if (p->isResearching(tech)) t.researching |= bit;
+			if (p->hasResearched(tech)) t.researched |= bit;
+		}
+		for (const auto& upgrade : UpgradeTypes::allUpgradeTypes()) {
+			if (upgrade.getID() >= 64) continue;
+			if (p->isUpgrading(upgrade)) t.upgrading |= uint64_t(1) << upgrade.getID();
+			uint64_t level = p->getUpgradeLevel(upgrade) & 3;
+			t.upgradeLevels[upgrade.getID() / 32] |= level << ((upgrade.getID() % 32) * 2);
+		}
+		return t;
+	}
+}
+
+TraceRecorder::TraceRecorder()
+{
+	std::string tracefilepath = game->mapPathName() + ".rtd";
+	traceFile.open(tracefilepath.c_str(), std::ios::binary);
+
+	Trace::FileHeader header = { Trace::MAGIC, Trace::VERSION };
+	traceFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	writeMap();
+	writeFrame(); // state seen by the extractors constructors
+}
+
+TraceRecorder::~TraceRecorder()
+{
+	writeRecord(Trace::End);
+	traceFile.close();
+}
+
+void TraceRecorder::onFrame()
+{
+	writeFrame();
+}
+
+void TraceRecorder::onReceiveText(Dump::Player player, const std::string& text)
+{
+	put(static_cast<int32_t>(traceID(player)));
+	putString(text);
+	writeRecord(Trace::ReceiveText);
+}
+
+void TraceRecorder::onPlayerLeft(Dump::Player player)
+{
+	put(static_cast<int32_t>(traceID(player)));
+	writeRecord(Trace::PlayerLeft);
+}
+
+void TraceRecorder::onNukeDetect(BWAPI::Position target)
+{
+	put(static_cast<int32_t>(target.x));
+	put(static_cast<int32_t>(target.y));
+	writeRecord(Trace::NukeDetect);
+}
+
+void TraceRecorder::onUnitEvent(Trace::RecordKind kind, Dump::Unit unit)
+{
+	// the unit may not be in the next frame (destroyed), so we keep its state now
+	put(toTraceUnit(unit));
+	writeRecord(kind);
+}
+
+void TraceRecorder::put(const void* data, size_t size)
+{
+	const char* bytes = static_cast<const char*>(data);
+	payload.insert(payload.end(), bytes, bytes + size);
+}
+
+void TraceRecorder::putString(const std::string& str)
+{
+	put(static_cast<uint32_t>(str.size()));
+	put(str.data(), str.size());
+	pad(4);
+}
+
+void TraceRecorder::pad(size_t alignment)
+{
+	payload.resize((payload.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+void TraceRecorder::writeRecord(Trace::RecordKind kind)
+{
+	pad(8);
+	Trace::Record record = { kind, static_cast<uint32_t>(payload.size()) };
+	traceFile.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	if (!payload.empty()) traceFile.write(payload.data(), payload.size());
+	payload.clear();
+}
+
+void TraceRecorder::writeMap()
+{
+	int width = game->mapWidth();
+	int height = game->mapHeight();
+	put(static_cast<int32_t>(width));
+	put(static_cast<int32_t>(height));
+	putString(game->mapPathName());
+	putString(game->mapName());
+	putString(game->mapHash());
+
+	put(static_cast<uint32_t>(game->getStartLocations().size()));
+	for (const auto& tp : game->getStartLocations()) {
+		put(static_cast<int32_t>(tp.x));
+		put(static_cast<int32_t>(tp.y));
+	}
+
+	put(static_cast<uint32_t>(game->getPlayers().size()));
+	for (const auto& p : game->getPlayers()) {
+		put(static_cast<int32_t>(p->getID()));
+		put(static_cast<int32_t>(p->getRace().getID()));
+		put(static_cast<int32_t>(p->isNeutral()));
+		put(static_cast<int32_t>(p->isObserver()));
+		put(static_cast<int32_t>(p->getStartLocation().x));
+		put(static_cast<int32_t>(p->getStartLocation().y));
+		putString(p->getName());
+	}
+
+	// walkability bits
+	std::vector<uint32_t> walkBits((width * 4 * height * 4 + 31) / 32, 0);
+	for (int y = 0; y < height * 4; ++y) {
+		for (int x = 0; x < width * 4; ++x) {
+			int i = x + y * width * 4;
+			if (game->isWalkable(x, y)) walkBits[i / 32] |= uint32_t(1) << (i % 32);
+		}
+	}
+	put(walkBits.data(), walkBits.size() * sizeof(uint32_t));
+
+	// regions and chokepoints, referenced by their index in the trace
+	std::vector<Dump::Region*> regions(game->getRegions().begin(), game->getRegions().end());
+	std::map<Dump::Region*, int32_t> regionIndex;
+	put(static_cast<uint32_t>(regions.size()));
+	for (size_t i = 0; i < regions.size(); ++i) regionIndex[regions[i]] = static_cast<int32_t>(i);
+	for (const auto& r : regions) {
+		put(static_cast<int32_t>(r->getCenter().x));
+		put(static_cast<int32_t>(r->getCenter().y));
+		put(static_cast<int32_t>(r->getPolygonCenter().x));
+		put(static_cast<int32_t>(r->getPolygonCenter().y));
+		put(static_cast<uint32_t>(r->getPolygon().size()));
+		for (const auto& p : r->getPolygon()) {
+			put(static_cast<int32_t>(p.x));
+			put(static_cast<int32_t>(p.y));
+		}
+	}
+	put(static_cast<uint32_t>(game->getChokepoints().size()));
+	for (const auto& c : game->getChokepoints()) {
+		put(static_cast<int32_t>(c->getCenter().x));
+		put(static_cast<int32_t>(c->getCenter().y));
+		put(c->getWidth());
+		put(regionIndex.count(c->getRegions().first) ? regionIndex[c->getRegions().first] : int32_t(-1));
+		put(regionIndex.count(c->getRegions().second) ? regionIndex[c->getRegions().second] : int32_t(-1));
+		put(static_cast<int32_t>(c->getSides().first.x));
+		put(static_cast<int32_t>(c->getSides().first.y));
+		put(static_cast<int32_t>(c->getSides().second.x));
+		put(static_cast<int32_t>(c->getSides().second.y));
+	}
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			Dump::Region* r = game->getRegion(x, y);
+			put(r != nullptr && regionIndex.count(r) ? regionIndex[r] : int32_t(-1));
+		}
+	}
+
+	// the headless backend can't reproduce BWTA's pathfinding, keep the distances ActionSelection asks for
+	for (const auto& r1 : regions) {
+		for (const auto& r2 : regions) {
+			put(game->getGroundDistance(TilePosition(r1->getCenter()), TilePosition(r2->getCenter())));
+		}
+	}
+
+	writeRecord(Trace::Map);
+}
+
+void TraceRecorder::writeFrame()
+{
+	std::vector<Trace::Player> players;
+	for (const auto& p : game->getPlayers()) {
+		Trace::Player t = toTracePlayer(p);
+		auto it = lastPlayers.find(t.id);
+		if (it == lastPlayers.end() || memcmp(&it->second, &t, sizeof(t)) != 0) {
+			players.push_back(t);
+			lastPlayers[t.id] = t;
+		}
+	}
+
+	std::vector<Trace::Unit> units;
+	std::unordered_map<int, Trace::Unit> currentUnits;
+	currentUnits.reserve(lastUnits.size());
+	for (const auto& u : game->getAllUnits()) {
+		Trace::Unit t = toTraceUnit(u);
+		auto it = lastUnits.find(t.id);
+		if (it == lastUnits.end() || memcmp(&it->second, &t, sizeof(t)) != 0) units.push_back(t);
+		currentUnits[t.id] = t;
+	}
+
+	std::vector<int32_t> removed;
+	for (const auto& u : lastUnits) {
+		if (!currentUnits.count(u.first)) removed.push_back(u.first);
+	}
+	lastUnits.swap(currentUnits);
+
+	Trace::FrameHeader header = { game->getFrameCount(), static_cast<uint32_t>(players.size()),
+		static_cast<uint32_t>(units.size()), static_cast<uint32_t>(removed.size()) };
+	put(header);
+	if (!players.empty()) put(players.data(), players.size() * sizeof(Trace::Player));
+	if (!units.empty()) put(units.data(), units.size() * sizeof(Trace::Unit));
+	if (!removed.empty()) put(removed.data(), removed.size() * sizeof(int32_t));
+	writeRecord(Trace::Frame);
+}
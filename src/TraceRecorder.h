@@ -0,0 +1,34 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "Utils.h"
+#include "TraceFormat.h"
+
+// Records everything the extractors read from the game (see TraceFormat.h) so they can be
+// re-run offline with TraceReplayer, without StarCraft.
+class TraceRecorder
+{
+public:
+	TraceRecorder(); // Generates RTD file, starting with the map and the initial state
+	~TraceRecorder();
+	void onFrame();
+	void onReceiveText(Dump::Player player, const std::string& text);
+	void onPlayerLeft(Dump::Player player);
+	void onNukeDetect(BWAPI::Position target);
+	void onUnitEvent(Trace::RecordKind kind, Dump::Unit unit);
+
+private:
+	AsyncOutputFile traceFile;
+	std::vector<char> payload; // record being built
+	std::unordered_map<int, Trace::Unit> lastUnits;
+	std::unordered_map<int, Trace::Player> lastPlayers;
+
+	template <class T> void put(const T& value) { put(&value, sizeof(T)); }
+	void put(const void* data, size_t size);
+	void putString(const std::string& str);
+	void pad(size_t alignment);
+	void writeRecord(Trace::RecordKind kind);
+	void writeMap();
+	void writeFrame();
+};
@@ -0,0 +1,325 @@
+#include "TraceReplayer.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace BWAPI;
+
+namespace
+{
+	// sequential reads in the payload of a record
+	class PayloadReader
+	{
+	public:
+		PayloadReader(const Trace::Record* record)
+			: p(reinterpret_cast<const char*>(record + 1)), end(p + record->size) {}
+
+		template <class T> T get()
+		{
+			T value;
+			memcpy(&value, take(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		std::string getString()
+		{
+			uint32_t size = get<uint32_t>();
+			std::string str(take(size), size);
+			take((4 - size % 4) % 4);
+			return str;
+		}
+
+	private:
+		const char* p;
+		const char* end;
+
+		const char* take(size_t size)
+		{
+			if (size > static_cast<size_t>(end - p)) throw std::runtime_error("Truncated trace record");
+			const char* ret = p;
+			p += size;
+			return ret;
+		}
+	};
+}
+
+TraceReplayer::TraceReplayer(const std::string& tracePath)
+	: cursor(nullptr), end(nullptr), mockGame(nullptr), extractors(nullptr)
+{
+	CREATE_RTD = false; // never record over the trace we are reading
+
+	file.open(tracePath);
+	cursor = file.data();
+	end = cursor + file.size();
+
+	Trace::FileHeader header;
+	if (file.size() < sizeof(header)) throw std::runtime_error("Not a trace: " + tracePath);
+	memcpy(&header, cursor, sizeof(header));
+	if (header.magic != Trace::MAGIC) throw std::runtime_error("Not a trace: " + tracePath);
+	if (header.version != Trace::VERSION) throw std::runtime_error("Unsupported trace version: " + tracePath);
+	cursor += sizeof(header);
+
+	const Trace::Record* record = nextRecord();
+	if (record == nullptr || record->kind != Trace::Map) throw std::runtime_error("Trace without map: " + tracePath);
+	readMap(record);
+
+	std::string extension(".rtd");
+	if (tracePath.size() > extension.size() && tracePath.compare(tracePath.size() - extension.size(), extension.size(), extension) == 0) {
+		mockGame->pathName = tracePath.substr(0, tracePath.size() - extension.size());
+	} else {
+		mockGame->pathName = tracePath;
+	}
+
+	// initial state, seen by the extractors constructors
+	record = nextRecord();
+	if (record == nullptr || record->kind != Trace::Frame) throw std::runtime_error("Trace without initial frame: " + tracePath);
+	applyFrame(record);
+}
+
+TraceReplayer::~TraceReplayer()
+{
+	delete extractors;
+	delete mockGame;
+}
+
+void TraceReplayer::run()
+{
+	extractors = new Extractors(mockGame);
+
+	// callbacks are recorded before the state of their frame
+	std::vector<const Trace::Record*> events;
+	for (const Trace::Record* record = nextRecord(); record != nullptr && record->kind != Trace::End; record = nextRecord()) {
+		if (record->kind == Trace::Frame) {
+			applyFrame(record);
+			for (const auto& e : events) dispatch(e);
+			events.clear();
+			extractors->onFrame();
+		} else {
+			events.push_back(record);
+		}
+	}
+	for (const auto& e : events) dispatch(e); // received before onEnd
+
+	delete extractors;
+	extractors = nullptr;
+}
+
+const Trace::Record* TraceReplayer::nextRecord()
+{
+	if (static_cast<size_t>(end - cursor) < sizeof(Trace::Record)) return nullptr;
+	const Trace::Record* record = reinterpret_cast<const Trace::Record*>(cursor);
+	if (record->size > static_cast<size_t>(end - cursor) - sizeof(Trace::Record)) return nullptr; // truncated trace
+	cursor += sizeof(Trace::Record) + record->size;
+	return record;
+}
+
+void TraceReplayer::readMap(const Trace::Record* record)
+{
+	PayloadReader in(record);
+	int width = in.get<int32_t>();
+	int height = in.get<int32_t>();
+	mockGame = new MockGame(width, height);
+	mockGame->pathName = in.getString();
+	mockGame->name = in.getString();
+	mockGame->hash = in.getString();
+
+	uint32_t n = in.get<uint32_t>();
+	for (uint32_t i = 0; i < n; ++i) {
+		int x = in.get<int32_t>();
+		int y = in.get<int32_t>();
+		mockGame->startLocations.push_back(TilePosition(x, y));
+	}
+
+	n = in.get<uint32_t>();
+	for (uint32_t i = 0; i < n; ++i) {
+		int id = in.get<int32_t>();
+		int race = in.get<int32_t>();
+		bool neutral = in.get<int32_t>() != 0;
+		bool observer = in.get<int32_t>() != 0;
+		int x = in.get<int32_t>();
+		int y = in.get<int32_t>();
+		MockPlayer* p = mockGame->createPlayer(id, in.getString(), Race(race));
+		p->neutral = neutral;
+		p->observer = observer;
+		p->startLocation = TilePosition(x, y);
+	}
+
+	uint32_t bits = 0;
+	for (int i = 0; i < width * 4 * height * 4; ++i) {
+		if (i % 32 == 0) bits = in.get<uint32_t>();
+		mockGame->setWalkable(i % (width * 4), i / (width * 4), (bits & (uint32_t(1) << (i % 32))) != 0);
+	}
+
+	std::vector<MockRegion*> regions(in.get<uint32_t>());
+	for (auto& r : regions) {
+		int x = in.get<int32_t>();
+		int y = in.get<int32_t>();
+		r = mockGame->createRegion(Position(x, y));
+		x = in.get<int32_t>();
+		y = in.get<int32_t>();
+		r->polygonCenter = Position(x, y);
+		r->polygon.resize(in.get<uint32_t>());
+		for (auto& p : r->polygon) {
+			x = in.get<int32_t>();
+			y = in.get<int32_t>();
+			p = Position(x, y);
+		}
+	}
+	n = in.get<uint32_t>();
+	for (uint32_t i = 0; i < n; ++i) {
+		int x = in.get<int32_t>();
+		int y = in.get<int32_t>();
+		double chokeWidth = in.get<double>();
+		uint32_t r1 = in.get<uint32_t>();
+		uint32_t r2 = in.get<uint32_t>();
+		int s1x = in.get<int32_t>();
+		int s1y = in.get<int32_t>();
+		int s2x = in.get<int32_t>();
+		int s2y = in.get<int32_t>();
+		if (r1 >= regions.size() || r2 >= regions.size()) continue;
+		MockChokepoint* c = mockGame->createChokepoint(Position(x, y), chokeWidth, regions[r1], regions[r2]);
+		c->sides = std::make_pair(Position(s1x, s1y), Position(s2x, s2y));
+	}
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			uint32_t r = in.get<uint32_t>();
+			if (r < regions.size()) mockGame->setRegion(TilePosition(x, y), regions[r]);
+		}
+	}
+	mockGame->computeReachableRegions();
+
+	for (const auto& r1 : regions) {
+		for (const auto& r2 : regions) {
+			mockGame->setGroundDistance(TilePosition(r1->center), TilePosition(r2->center), in.get<double>());
+		}
+	}
+}
+
+void TraceReplayer::applyFrame(const Trace::Record* record)
+{
+	Trace::FrameHeader header;
+	if (record->size < sizeof(header)) throw std::runtime_error("Truncated trace frame");
+	const char* data = reinterpret_cast<const char*>(record + 1);
+	memcpy(&header, data, sizeof(header));
+	if (sizeof(header) + header.players * sizeof(Trace::Player) + header.units * sizeof(Trace::Unit)
+		+ header.removed * sizeof(int32_t) > record->size) throw std::runtime_error("Truncated trace frame");
+
+	// read in place, payloads are 8 bytes aligned
+	const Trace::Player* players = reinterpret_cast<const Trace::Player*>(data + sizeof(header));
+	const Trace::Unit* units = reinterpret_cast<const Trace::Unit*>(players + header.players);
+	const int32_t* removed = reinterpret_cast<const int32_t*>(units + header.units);
+
+	mockGame->frameCount = header.frame;
+	for (uint32_t i = 0; i < header.players; ++i) applyPlayer(players[i]);
+	for (uint32_t i = 0; i < header.removed; ++i) {
+		MockUnit* u = mockGame->getUnit(removed[i]);
+		if (u != nullptr && mockGame->getAllUnits().count(u)) mockGame->destroyUnit(u);
+	}
+	for (uint32_t i = 0; i < header.units; ++i) {
+		MockUnit* u = applyUnit(units[i]);
+		if (!mockGame->getAllUnits().count(u)) mockGame->restoreUnit(u);
+	}
+	// targets can be units appearing later in this frame
+	for (uint32_t i = 0; i < header.units; ++i) applyTargets(units[i]);
+}
+
+void TraceReplayer::dispatch(const Trace::Record* record)
+{
+	switch (record->kind) {
+	case Trace::UnitCreate:
+	case Trace::UnitDestroy:
+	case Trace::UnitMorph:
+	case Trace::UnitRenegade:
+	{
+		Trace::Unit t = PayloadReader(record).get<Trace::Unit>();
+		MockUnit* u = applyUnit(t);
+		applyTargets(t);
+		if (record->kind == Trace::UnitCreate) extractors->onUnitCreate(u);
+		else if (record->kind == Trace::UnitDestroy) {
+			// created and destroyed between two frames
+			if (mockGame->getAllUnits().count(u)) mockGame->destroyUnit(u);
+			extractors->onUnitDestroy(u);
+		}
+		else if (record->kind == Trace::UnitMorph) extractors->onUnitMorph(u);
+		else extractors->onUnitRenegade(u);
+		break;
+	}
+	case Trace::ReceiveText:
+	{
+		PayloadReader in(record);
+		int player = in.get<int32_t>();
+		extractors->onReceiveText(mockGame->getPlayer(player), in.getString());
+		break;
+	}
+	case Trace::PlayerLeft:
+		extractors->onPlayerLeft(mockGame->getPlayer(PayloadReader(record).get<int32_t>()));
+		break;
+	case Trace::NukeDetect:
+	{
+		PayloadReader in(record);
+		int x = in.get<int32_t>();
+		int y = in.get<int32_t>();
+		extractors->onNukeDetect(Position(x, y));
+		break;
+	}
+	default:
+		DEBUG("Unknown trace record " << record->kind);
+	}
+}
+
+MockUnit* TraceReplayer::applyUnit(const Trace::Unit& t)
+{
+	MockPlayer* player = mockGame->getPlayer(t.player);
+	if (player == nullptr) throw std::runtime_error("Trace unit without player");
+	MockUnit* u = mockGame->getUnit(t.id);
+	if (u == nullptr) u = mockGame->createUnit(t.id, UnitType(t.type), player, Position(t.x, t.y));
+	else if (u->player != player) mockGame->changeOwner(u, player);
+
+	u->type = UnitType(t.type);
+	u->position = Position(t.x, t.y);
+	u->hitPoints = t.hitPoints;
+	u->shields = t.shields;
+	u->energy = t.energy;
+	u->resourceGroup = t.resourceGroup;
+	u->spaceRemaining = t.spaceRemaining;
+	u->groundWeaponCooldown = t.groundWeaponCooldown;
+	u->airWeaponCooldown = t.airWeaponCooldown;
+	u->spellCooldown = t.spellCooldown;
+	u->lastAttackingPlayer = mockGame->getPlayer(t.lastAttackingPlayer);
+	u->order = Order(t.order);
+	u->orderTargetPosition = Position(t.orderTargetX, t.orderTargetY);
+	u->targetPosition = Position(t.targetX, t.targetY);
+	u->flags = t.flags;
+	return u;
+}
+
+void TraceReplayer::applyPlayer(const Trace::Player& t)
+{
+	MockPlayer* p = mockGame->getPlayer(t.id);
+	if (p == nullptr) return;
+	p->mineralCount = t.minerals;
+	p->gasCount = t.gas;
+	p->gatheredMineralCount = t.gatheredMinerals;
+	p->gatheredGasCount = t.gatheredGas;
+	p->supplyUsedCount = t.supplyUsed;
+	p->supplyTotalCount = t.supplyTotal;
+	p->researching.clear();
+	p->researched.clear();
+	p->upgrading.clear();
+	p->upgradeLevels.clear();
+	for (int id = 0; id < 64; ++id) {
+		uint64_t bit = uint64_t(1) << id;
+		if (t.researching & bit) p->researching.insert(TechType(id));
+		if (t.researched & bit) p->researched.insert(TechType(id));
+		if (t.upgrading & bit) p->upgrading.insert(UpgradeType(id));
+		int level = static_cast<int>((t.upgradeLevels[id / 32] >> ((id % 32) * 2)) & 3);
+		if (level > 0) p->upgradeLevels[UpgradeType(id)] = level;
+	}
+}
+
+void TraceReplayer::applyTargets(const Trace::Unit& t)
+{
+	MockUnit* u = mockGame->getUnit(t.id);
+	u->orderTarget = mockGame->getUnit(t.orderTarget);
+	u->target = mockGame->getUnit(t.target);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "boost/iostreams/device/mapped_file.hpp"
+
+#include "MockGame.h"
+#include "Extractors.h"
+#include "TraceFormat.h"
+
+// Drives the extractors offline from a RTD file (see TraceRecorder), the trace is memory mapped
+// and applied frame by frame to a MockGame.
+// Output files are written next to the trace (mapPathName is the trace path without ".rtd").
+class TraceReplayer
+{
+public:
+	TraceReplayer(const std::string& tracePath); // throws std::runtime_error if the trace is not valid
+	~TraceReplayer();
+	void run(); // until the end of the recorded game, then closes the extractors files
+
+	MockGame* getGame() const { return mockGame; }
+
+private:
+	boost::iostreams::mapped_file_source file;
+	const char* cursor;
+	const char* end;
+	MockGame* mockGame;
+	Extractors* extractors;
+
+	const Trace::Record* nextRecord();
+	void readMap(const Trace::Record* record);
+	void applyFrame(const Trace::Record* record);
+	void dispatch(const Trace::Record* record);
+	MockUnit* applyUnit(const Trace::Unit& t);
+	void applyPlayer(const Trace::Player& t);
+	void applyTargets(const Trace::Unit& t);
+};
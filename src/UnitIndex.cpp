@@ -0,0 +1,96 @@
+#include "UnitIndex.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Utils.h"
+
+using namespace BWAPI;
+
+UnitIndex unitIndex;
+
+void UnitIndex::update()
+{
+	if (valid && frame == game->getFrameCount()) return;
+	valid = true;
+	frame = game->getFrameCount();
+	width = std::max(1, (game->mapWidth() * TILE_SIZE + CELL_SIZE - 1) / CELL_SIZE);
+	height = std::max(1, (game->mapHeight() * TILE_SIZE + CELL_SIZE - 1) / CELL_SIZE);
+	auto cellOf = [&](const Position& p) {
+		int cx = std::max(0, std::min(width - 1, p.x / CELL_SIZE));
+		int cy = std::max(0, std::min(height - 1, p.y / CELL_SIZE));
+		return cx + cy * width;
+	};
+
+	// counting sort of the units by cell, the loaded units are not on the map
+	const Dump::Unitset& all = game->getAllUnits();
+	std::vector<std::pair<Dump::Unit, Position> > onMap;
+	onMap.reserve(all.size());
+	cellStart.assign(width * height + 1, 0);
+	maxExtent = 0;
+	for (const auto& u : all) {
+		if (u->isLoaded()) continue;
+		Position p = u->getPosition();
+		onMap.push_back(std::make_pair(u, p));
+		cellStart[cellOf(p) + 1]++;
+		UnitType t = u->getType();
+		maxExtent = std::max(maxExtent, std::max(std::max(t.dimensionLeft(), t.dimensionRight()), std::max(t.dimensionUp(), t.dimensionDown())) + 1);
+	}
+	for (size_t c = 1; c < cellStart.size(); ++c) cellStart[c] += cellStart[c - 1];
+	xs.resize(onMap.size());
+	ys.resize(onMap.size());
+	players.resize(onMap.size());
+	units.resize(onMap.size());
+	std::vector<int> next(cellStart.begin(), cellStart.end() - 1);
+	for (const auto& up : onMap) {
+		int i = next[cellOf(up.second)]++;
+		xs[i] = up.second.x;
+		ys[i] = up.second.y;
+		players[i] = up.first->getPlayer();
+		units[i] = up.first;
+	}
+}
+
+template <class F>
+void UnitIndex::candidates(Position center, int reach, Dump::Player ignored, F f) const
+{
+	auto clamp = [](int v, int size) { return std::max(0, std::min(size - 1, v / CELL_SIZE)); };
+	int left = clamp(center.x - reach, width);
+	int right = clamp(center.x + reach, width);
+	int top = clamp(center.y - reach, height);
+	int bottom = clamp(center.y + reach, height);
+	int64_t reach2 = static_cast<int64_t>(reach) * reach;
+	for (int cy = top; cy <= bottom; ++cy) {
+		for (int cx = left; cx <= right; ++cx) {
+			for (int i = cellStart[cx + cy * width]; i < cellStart[cx + cy * width + 1]; ++i) {
+				if (players[i] == ignored && ignored != nullptr) continue;
+				int64_t dx = xs[i] - center.x;
+				int64_t dy = ys[i] - center.y;
+				if (dx * dx + dy * dy <= reach2) f(units[i]);
+			}
+		}
+	}
+}
+
+// The distances of BWAPI are from the boxes of the units and approximated (at most ~9% shorter than
+// the euclidean distance), the reach covers both
+Dump::Unitset UnitIndex::getUnitsInRadius(Position center, int radius)
+{
+	update();
+	Dump::Unitset ret;
+	candidates(center, radius + radius / 8 + 2 * maxExtent + 2, nullptr, [&](Dump::Unit u) {
+		if (u->getDistance(center) <= radius) ret.insert(u);
+	});
+	return ret;
+}
+
+Dump::Unitset UnitIndex::getUnitsInRadius(Dump::Unit unit, int radius, Dump::Player ignored)
+{
+	update();
+	Dump::Unitset ret;
+	if (!unit->exists()) return ret;
+	candidates(unit->getPosition(), radius + radius / 8 + 4 * maxExtent + 2, ignored, [&](Dump::Unit u) {
+		if (u != unit && unit->getDistance(u) <= radius) ret.insert(u);
+	});
+	return ret;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "GameInterface.h"
+
+// Uniform grid (CELL_SIZE pixels) of the units of the game, the radius queries of CombatTracker and
+// GameData look at the units of the cells around the center instead of asking the game for all of
+// them. Positions and players are kept per cell in flat arrays (units sorted by cell, cellStart[c]
+// first of cell c) so the cells are scanned without touching the units.
+// The grid only selects the candidates, the distance of the backend decides: the results are the
+// ones of game->getUnitsInRadius and unit->getUnitsInRadius.
+// Built on the first query of a frame, and again after invalidate() (Extractors, at each callback:
+// the headless backends change the units between two callbacks of a frame).
+class UnitIndex
+{
+public:
+	static const int CELL_SIZE = 128;
+
+	UnitIndex() : valid(false), frame(-1), width(0), height(0), maxExtent(0) {}
+	void invalidate() { valid = false; }
+
+	// as game->getUnitsInRadius(center, radius)
+	Dump::Unitset getUnitsInRadius(BWAPI::Position center, int radius);
+	// as unit->getUnitsInRadius(radius), without the units of ignored if it is not nullptr
+	Dump::Unitset getUnitsInRadius(Dump::Unit unit, int radius, Dump::Player ignored = nullptr);
+
+private:
+	bool valid;
+	int frame;
+	int width; // in cells
+	int height;
+	int maxExtent; // max distance from the position of a unit to the border of its box
+	std::vector<int> cellStart; // width * height + 1
+	std::vector<int> xs;
+	std::vector<int> ys;
+	std::vector<Dump::Player> players;
+	std::vector<Dump::Unit> units;
+
+	void update();
+	// units of the cells around center whose position is at most reach away (the units out of the
+	// map are in the border cells), f(unit) for each
+	template <class F>
+	void candidates(BWAPI::Position center, int reach, Dump::Player ignored, F f) const;
+};
+
+extern UnitIndex unitIndex; // of game
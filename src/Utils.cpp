@@ -1,28 +1,44 @@
 #include "Utils.h"
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 // config variables
 bool CREATE_RGD = true;
+bool CREATE_RGD_BINARY = false; // RGD events also as typed columns (.rgdb, see RGDSchema.h)
 bool CREATE_RLD = false;
 bool CREATE_ROD = true;
 bool CREATE_RCD = true;
 bool CREATE_ASD = true;
+bool CREATE_RVD = false; // fog of war of each player, see VisionData.h
+bool COMPRESS_ROD_RLD = false; // LZ4 blocks with a frame index (.rodz, .rldz, .rvdz), see CompressedFile.h
+std::string COMPRESSION_DICTIONARY = "bwapi-data/AI/BWRepDump.dict"; // used if it exists (bwrepdump_lz train)
+bool CREATE_RTD = false; // frame trace to re-run the extractors offline (TraceReplayer)
+bool PROFILE_SPANS = false; // modules timings, written as Chrome trace JSON
+std::string CORPUS_ARCHIVE = ""; // if set, the replay files are appended to this archive (see CorpusArchive.h)
+int TERRAIN_THREADS = 0; // threads computing the terrain cache (.terrain), 0: one per core
+std::string TERRAIN_CACHE_FOLDER = "bwapi-data/AI/BWRepDumpCache/"; // $mapHash.terrain files, can be shared (bwrepdump_warm)
 
 int REPLAY_TIME_LIMIT = 60 * 45 * 24;
 
 // Global variables for CombatTracker
 int SECONDS_SINCE_LAST_ATTACK_2 = 24 * 6;
-int ATTACK_RANGE = 12 * TILE_SIZE; // siege tanks have the biggest range
+int ATTACK_RANGE = 12 * BWAPI::TILE_SIZE; // siege tanks have the biggest range
 int FRAMES_UNTIL_REINFORCEMENT = 12;
 
 // global variables
 std::ofstream fileLog;
+Dump::Game* game;
+MapModel* mapModel;
 TerrainAnalyzer* terrain;
 CombatTracker* combatTracker;
-BWAPI::Playerset activePlayers;
+Dump::Playerset activePlayers;
 bool unitDestroyedThisTurn;
 
 // global functions
-bool isInofensiveUnit(BWAPI::Unit u)
+bool isInofensiveUnit(Dump::Unit u)
 {
 	return (u->getPlayer()->isNeutral() || u->getPlayer()->isObserver()
 		|| u->isGatheringGas() || u->isGatheringMinerals() || u->isRepairing()
@@ -36,7 +52,7 @@ bool isInofensiveUnit(BWAPI::Unit u)
 		);
 }
 
-bool isMilitaryUnit(BWAPI::Unit unit)
+bool isMilitaryUnit(Dump::Unit unit)
 {
 	if (unit->getPlayer()->getID() < 0) return false; // omit neutral players
 	if (!unit->isCompleted()) return false;
@@ -54,10 +70,10 @@ bool isMilitaryUnit(BWAPI::Unit unit)
 		|| uType == BWAPI::UnitTypes::Protoss_Reaver;
 }
 
-std::map<BWAPI::Player, BWAPI::Unitset> getPlayerMilitaryUnits(const BWAPI::Unitset& unitsAround)
+std::map<Dump::Player, Dump::Unitset, Dump::ByID> getPlayerMilitaryUnits(const Dump::Unitset& unitsAround)
 {
-	std::map<BWAPI::Player, BWAPI::Unitset> playerUnits;
-	for (const auto& p : activePlayers) playerUnits.insert(make_pair(p, BWAPI::Unitset()));
+	std::map<Dump::Player, Dump::Unitset, Dump::ByID> playerUnits;
+	for (const auto& p : activePlayers) playerUnits.insert(make_pair(p, Dump::Unitset()));
 	for (const auto& u : unitsAround) {
 		if (isInofensiveUnit(u)) continue;
 		playerUnits[u->getPlayer()].insert(u);
@@ -65,7 +81,32 @@ std::map<BWAPI::Player, BWAPI::Unitset> getPlayerMilitaryUnits(const BWAPI::Unit
 	return playerUnits;
 }
 
-bool isGatheringResources(BWAPI::Unit u)
+bool isGatheringResources(Dump::Unit u)
 {
 	return u->isGatheringMinerals() || u->isGatheringGas();
-}
\ No newline at end of file
+}
+
+void parallelFor(size_t count, const std::function<void(size_t)>& task)
+{
+	unsigned threads = TERRAIN_THREADS > 0 ? TERRAIN_THREADS : std::max(1u, std::thread::hardware_concurrency());
+	threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+	std::atomic<size_t> next(0);
+	std::exception_ptr error;
+	std::mutex errorMutex;
+	auto worker = [&]() {
+		for (size_t i = next++; i < count; i = next++) {
+			try {
+				task(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error) error = std::current_exception();
+				next = count;
+			}
+		}
+	};
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads; ++t) pool.push_back(std::thread(worker));
+	worker();
+	for (auto& t : pool) t.join();
+	if (error) std::rethrow_exception(error);
+}
@@ -2,9 +2,15 @@
 
 #include <fstream>
 #include <iomanip>
+#include <sstream>
+#include <cfloat>
+#include <functional>
 
 #include <BWAPI.h>
-#include <BWTA.h>
+
+#include "GameInterface.h"
+#include "AsyncWriter.h"
+#include "Profiler.h"
 
 #define SECONDS_SINCE_LAST_ATTACK 13
 #define MAX_ATTACK_RADIUS 21.0*TILE_SIZE
@@ -14,6 +20,7 @@
 
 #define RESOURCES_REFRESH 25
 #define LOCATION_REFRESH 100
+#define VISION_REFRESH 24
 
 //#define __DEBUG_OUTPUT__
 //#define __DEBUG_CDR__
@@ -27,16 +34,25 @@ extern std::ofstream fileLog;
 
 // A "promise" of classes that we will have
 // ==========================================
+class MapModel;
 class TerrainAnalyzer;
 class CombatTracker;
 
 // A "promise" of global variables
 // ==========================================
 extern bool CREATE_RGD;
+extern bool CREATE_RGD_BINARY;
 extern bool CREATE_RLD;
 extern bool CREATE_ROD;
 extern bool CREATE_RCD;
 extern bool CREATE_ASD;
+extern bool CREATE_RVD;
+extern bool COMPRESS_ROD_RLD;
+extern std::string COMPRESSION_DICTIONARY;
+extern bool CREATE_RTD;
+extern std::string CORPUS_ARCHIVE;
+extern int TERRAIN_THREADS;
+extern std::string TERRAIN_CACHE_FOLDER;
 
 extern int REPLAY_TIME_LIMIT;
 
@@ -44,14 +60,18 @@ extern int SECONDS_SINCE_LAST_ATTACK_2;
 extern int ATTACK_RANGE;
 extern int FRAMES_UNTIL_REINFORCEMENT;
 
+extern Dump::Game* game; // BWAPIGame in StarCraft, MockGame when running headless
+extern MapModel* mapModel; // static analysis of the map, shared by the extractors
 extern TerrainAnalyzer* terrain;
 extern CombatTracker* combatTracker;
-extern BWAPI::Playerset activePlayers; // real Players (removing neutrals and observers) 
-									   // to be used instead of Broodwar->getPlayers()
+extern Dump::Playerset activePlayers; // real Players (removing neutrals and observers) 
+									   // to be used instead of game->getPlayers()
 extern bool unitDestroyedThisTurn;
 
 
-bool isInofensiveUnit(BWAPI::Unit u);
-bool isMilitaryUnit(BWAPI::Unit unit);
-std::map<BWAPI::Player, BWAPI::Unitset> getPlayerMilitaryUnits(const BWAPI::Unitset& unitsAround);
-bool isGatheringResources(BWAPI::Unit u);
\ No newline at end of file
+bool isInofensiveUnit(Dump::Unit u);
+bool isMilitaryUnit(Dump::Unit unit);
+std::map<Dump::Player, Dump::Unitset, Dump::ByID> getPlayerMilitaryUnits(const Dump::Unitset& unitsAround);
+bool isGatheringResources(Dump::Unit u);
+// task(0) ... task(count - 1) on TERRAIN_THREADS threads, rethrows the first exception of a task
+void parallelFor(size_t count, const std::function<void(size_t)>& task);
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "VisionData.h"
+
+#include <algorithm>
+
+using namespace BWAPI;
+
+VisionData::VisionData()
+	: width(game->mapWidth()), height(game->mapHeight())
+{
+	if (COMPRESS_ROD_RLD) {
+		replayVisionDat.open(game->mapPathName() + ".rvdz", true, Compressed::loadDictionary(COMPRESSION_DICTIONARY));
+	} else {
+		replayVisionDat.open(game->mapPathName() + ".rvd", false);
+	}
+
+	// detect real players
+	for (const auto& player : game->getPlayers()) {
+		if (!player->getUnits().empty() && !player->isNeutral()) {
+			activePlayers.insert(player);
+			PlayerVision vision = { player, std::vector<uint16_t>(width * height, 0), std::vector<uint8_t>(width * height, 0), true, true };
+			players.push_back(vision);
+		}
+	}
+
+	replayVisionDat << "Map," << width << "," << height << "\n";
+	replayVisionDat << "Players";
+	for (const auto& vision : players) replayVisionDat << "," << vision.player->getID();
+	replayVisionDat << "\n[Replay Start]\n";
+}
+
+VisionData::~VisionData()
+{
+	replayVisionDat.close();
+}
+
+const std::vector<int>& VisionData::circle(int sight)
+{
+	auto it = halfWidths.find(sight);
+	if (it != halfWidths.end()) return it->second;
+	int radius = sight / TILE_SIZE;
+	std::vector<int>& rows = halfWidths[sight];
+	for (int dy = -radius; dy <= radius; ++dy) {
+		int halfWidth = -1;
+		while ((halfWidth + 1) * (halfWidth + 1) * TILE_SIZE * TILE_SIZE + dy * dy * TILE_SIZE * TILE_SIZE <= sight * sight) ++halfWidth;
+		rows.push_back(halfWidth);
+	}
+	return rows;
+}
+
+void VisionData::stamp(const Stamp& s, int delta)
+{
+	PlayerVision& vision = players[s.player];
+	const std::vector<int>& rows = circle(s.sight);
+	int radius = static_cast<int>(rows.size()) / 2;
+	uint8_t fresh = 0;
+	for (int dy = -radius; dy <= radius; ++dy) {
+		int y = s.y + dy;
+		int halfWidth = rows[dy + radius];
+		if (y < 0 || y >= height || halfWidth < 0) continue;
+		int begin = std::max(0, s.x - halfWidth);
+		int end = std::min(width - 1, s.x + halfWidth) + 1;
+		uint16_t* circles = vision.circles.data() + y * width;
+		uint8_t* explored = vision.explored.data() + y * width;
+		if (delta > 0) {
+			for (int x = begin; x < end; ++x) {
+				++circles[x];
+				fresh |= explored[x] ^ 1;
+				explored[x] = 1;
+			}
+		} else {
+			for (int x = begin; x < end; ++x) --circles[x];
+		}
+	}
+	vision.visibleChanged = true;
+	if (fresh) vision.exploredChanged = true;
+}
+
+void VisionData::onFrame()
+{
+	int frame = game->getFrameCount();
+	replayVisionDat.beginFrame(frame);
+
+	for (size_t p = 0; p < players.size(); ++p) {
+		for (const auto& u : players[p].player->getUnits()) {
+			if (!u->exists() || u->isLoaded()) continue;
+			TilePosition tile(u->getPosition());
+			Stamp s = { p, tile.x, tile.y, u->getType().sightRange(), frame };
+			auto it = stamps.find(u);
+			if (it == stamps.end()) {
+				stamps.insert(std::make_pair(u, s));
+				stamp(s, 1);
+			} else if (it->second.player != s.player || it->second.x != s.x || it->second.y != s.y || it->second.sight != s.sight) {
+				stamp(it->second, -1);
+				it->second = s;
+				stamp(s, 1);
+			} else {
+				it->second.frame = frame;
+			}
+		}
+	}
+	// dead, loaded or given to another player
+	for (auto it = stamps.begin(); it != stamps.end();) {
+		if (it->second.frame != frame) {
+			stamp(it->second, -1);
+			it = stamps.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	if (frame % VISION_REFRESH != 0) return;
+	std::vector<uint8_t> visible(width * height);
+	for (auto& vision : players) {
+		if (vision.visibleChanged) {
+			for (size_t i = 0; i < visible.size(); ++i) visible[i] = vision.circles[i] != 0;
+			writeRuns(vision.player->getID(), 'V', visible);
+			vision.visibleChanged = false;
+		}
+		if (vision.exploredChanged) {
+			writeRuns(vision.player->getID(), 'E', vision.explored);
+			vision.exploredChanged = false;
+		}
+	}
+}
+
+// lengths of the runs of 0 and 1 of the mask (row-major), the first run is of 0 and can be empty
+void VisionData::writeRuns(int playerID, char kind, const std::vector<uint8_t>& mask)
+{
+	replayVisionDat << game->getFrameCount() << "," << playerID << "," << kind;
+	uint8_t value = 0;
+	size_t start = 0;
+	for (size_t i = 0; i < mask.size(); ++i) {
+		if (mask[i] == value) continue;
+		replayVisionDat << "," << i - start;
+		start = i;
+		value = mask[i];
+	}
+	replayVisionDat << "," << mask.size() - start << "\n";
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "Utils.h"
+#include "CompressedFile.h"
+
+// Fog of war of each player (RVD file): the tiles its units see now and the ones they have ever
+// seen, without game->setVision. A tile is seen by a unit if its center is within the sight range
+// of the center of the unit's tile (no high ground nor detection, loaded units do not see).
+// Each player has a count of the sight circles over each tile, a circle is stamped as one span
+// per row (+1 or -1 on contiguous counts) and only when its unit changed tile, sight or owner.
+// Every VISION_REFRESH frames the masks that changed are written run-length encoded.
+class VisionData
+{
+public:
+	VisionData(); // Generates RVD file
+	~VisionData();
+	void onFrame();
+
+private:
+	struct Stamp
+	{
+		size_t player;
+		int x; // tile of the unit
+		int y;
+		int sight; // in pixels
+		int frame; // last frame the unit was seen
+	};
+	struct PlayerVision
+	{
+		Dump::Player player;
+		std::vector<uint16_t> circles; // sight circles over each tile, row-major
+		std::vector<uint8_t> explored;
+		bool visibleChanged;
+		bool exploredChanged;
+	};
+
+	CompressedOutputFile replayVisionDat;
+	int width;
+	int height;
+	std::vector<PlayerVision> players;
+	std::unordered_map<Dump::Unit, Stamp> stamps;
+	std::map<int, std::vector<int> > halfWidths; // per sight, the half width in tiles of each row of the circle
+
+	const std::vector<int>& circle(int sight);
+	void stamp(const Stamp& s, int delta);
+	void writeRuns(int playerID, char kind, const std::vector<uint8_t>& mask);
+};
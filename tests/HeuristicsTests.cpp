@@ -0,0 +1,95 @@
+// The attack scores of a HeuristicsAnalyzer kept for the whole game (GameData) against the ones of an
+// analyzer built from the units at the time of the attack, as each attack used to do, while the units
+// move, gather, morph, die and change owner between the attacks.
+
+#include <cmath>
+
+#include "Tests.h"
+#include "MapModel.h"
+#include "GameData.h"
+
+using namespace BWAPI;
+
+namespace
+{
+	bool same(double a, double b) // the shares are NaN when the player has no working peon
+	{
+		return a == b || (std::isnan(a) && std::isnan(b));
+	}
+
+	void checkScores(const HeuristicsAnalyzer& kept, const HeuristicsAnalyzer& fresh, int attack)
+	{
+		CHECK(kept.workingPeons == fresh.workingPeons && kept.armySize == fresh.armySize && kept.armyX == fresh.armyX
+			&& kept.armyY == fresh.armyY && kept.townhalls == fresh.townhalls, "attack " << attack << ": sums of the player");
+		for (const auto& r : game->getRegions()) {
+			CHECK(same(kept.scoreGround(r), fresh.scoreGround(r)) && same(kept.scoreAir(r), fresh.scoreAir(r))
+				&& same(kept.scoreDetect(r), fresh.scoreDetect(r)) && same(kept.economicImportance(r), fresh.economicImportance(r)),
+				"attack " << attack << ": scores of region " << mapModel->hashRegionCenter(r));
+			if (fresh.armySize > 0) {
+				CHECK(same(kept.tacticalImportance(r), fresh.tacticalImportance(r)), "attack " << attack << ": tactical importance of region " << mapModel->hashRegionCenter(r));
+			}
+		}
+		for (const auto& cdr : mapModel->allChokeDepRegs) {
+			CHECK(same(kept.scoreGround(cdr), fresh.scoreGround(cdr)) && same(kept.scoreAir(cdr), fresh.scoreAir(cdr))
+				&& same(kept.scoreDetect(cdr), fresh.scoreDetect(cdr)) && same(kept.economicImportance(cdr), fresh.economicImportance(cdr)),
+				"attack " << attack << ": scores of CDR " << cdr);
+			if (fresh.armySize > 0) {
+				CHECK(same(kept.tacticalImportance(cdr), fresh.tacticalImportance(cdr)), "attack " << attack << ": tactical importance of CDR " << cdr);
+			}
+		}
+	}
+}
+
+int main()
+{
+	TemporaryFolder cache;
+	TERRAIN_CACHE_FOLDER = cache.path.string() + "/";
+	const UnitType types[] = { UnitTypes::Terran_SCV, UnitTypes::Terran_Marine, UnitTypes::Terran_Siege_Tank_Tank_Mode,
+		UnitTypes::Terran_Siege_Tank_Siege_Mode, UnitTypes::Terran_Command_Center, UnitTypes::Zerg_Mutalisk,
+		UnitTypes::Terran_Science_Vessel, UnitTypes::Protoss_Probe, UnitTypes::Protoss_Dragoon, UnitTypes::Protoss_Observer,
+		UnitTypes::Protoss_Nexus, UnitTypes::Zerg_Drone, UnitTypes::Zerg_Overlord, UnitTypes::Zerg_Hatchery };
+	const int typeCount = sizeof(types) / sizeof(types[0]);
+	for (unsigned seed = 1; seed <= 4; ++seed) {
+		std::mt19937 rng(seed);
+		auto random = [&](int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); };
+		int size = 32 + 16 * seed;
+		MockGame* map = randomMap(seed, size, 3);
+		game = map;
+		mapModel = new MapModel;
+		int pixels = size * TILE_SIZE;
+		std::vector<MockPlayer*> players;
+		for (int p = 0; p < 2 + static_cast<int>(seed % 2); ++p) players.push_back(map->createPlayer(p, "Player " + std::to_string(p), Races::Terran));
+		std::vector<MockUnit*> units;
+		for (int id = 0; id < 150; ++id) {
+			units.push_back(map->createUnit(id, types[random(typeCount)], players[random(static_cast<int>(players.size()))],
+				Position(random(pixels), random(pixels))));
+		}
+		std::map<Dump::Player, HeuristicsAnalyzer, Dump::ByID> heuristics;
+		for (int attack = 0; attack < 40; ++attack) {
+			for (const auto& u : units) {
+				if (random(3) == 0) {
+					u->position = Position(std::max(0, std::min(pixels - 1, u->position.x + random(257) - 128)),
+						std::max(0, std::min(pixels - 1, u->position.y + random(257) - 128)));
+				}
+				u->setFlag(MockUnit::GatheringMinerals, random(2) == 0);
+				u->setFlag(MockUnit::Constructing, random(8) == 0);
+				u->setFlag(MockUnit::Loaded, random(10) == 0);
+				if (random(30) == 0) u->type = types[random(typeCount)];
+				if (random(40) == 0) map->changeOwner(u, players[random(static_cast<int>(players.size()))]);
+				if (!u->exists() && random(4) == 0) map->restoreUnit(u);
+				else if (u->exists() && random(25) == 0) map->destroyUnit(u);
+			}
+			// an attack on a random player, scored as GameData does
+			MockPlayer* defender = players[random(static_cast<int>(players.size()))];
+			HeuristicsAnalyzer& kept = heuristics.insert(std::make_pair(defender, HeuristicsAnalyzer(defender))).first->second;
+			kept.update();
+			HeuristicsAnalyzer fresh(defender);
+			fresh.update();
+			checkScores(kept, fresh, attack);
+		}
+		delete mapModel;
+		delete map;
+	}
+	std::cout << failures << " failed checks" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
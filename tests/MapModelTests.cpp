@@ -0,0 +1,275 @@
+// MapModel against the per pair and per tile computations it replaced: the ChokeDepRegs against the loop
+// over the tiles and the chokes, the region pathfinding centers and the distance matrices against
+// getShortestPath / getGroundDistance, the closest region, CDR and walkable tile grids and the
+// ActionSelection regions against scans, and a MapModel read from its cache file against the one which
+// computed it.
+
+#include <cfloat>
+#include <climits>
+#include <cstring>
+
+#include "Tests.h"
+#include "MapModel.h"
+
+using namespace BWAPI;
+
+namespace
+{
+	float quantized(double distance) // as stored in a DistanceMatrix
+	{
+		if (distance < 0.0) return -1.0f;
+		return static_cast<float>(std::min(static_cast<int>(distance), static_cast<int>(TerrainCache::MAX_DISTANCE)));
+	}
+
+	int squared(int dx, int dy)
+	{
+		return dx * dx + dy * dy;
+	}
+
+	// the loop over the tiles and the chokes with a getGroundDistance per candidate
+	void checkChokeDependantRegions(const MapModel& model)
+	{
+		for (int x = 0; x < game->mapWidth(); ++x) {
+			for (int y = 0; y < game->mapHeight(); ++y) {
+				TilePosition tmp(x, y);
+				Dump::Region* r = game->getRegion(tmp);
+				ChokeDepReg expected = -1;
+				double minDist = DBL_MAX - 100.0;
+				for (const auto& c : game->getChokepoints()) {
+					TilePosition chokeCenter(c->getCenter().x / TILE_SIZE, c->getCenter().y / TILE_SIZE);
+					double tmpDist = tmp.getDistance(chokeCenter);
+					double pathFindDist = DBL_MAX;
+					if (tmpDist < minDist && tmpDist <= 1.0 * std::max(9, static_cast<int>(c->getWidth()) / TILE_SIZE)
+						&& (pathFindDist = game->getGroundDistance(tmp, chokeCenter)) < minDist
+						&& pathFindDist >= 0.0
+						&& (c->getRegions().first == r || c->getRegions().second == r))
+					{
+						minDist = pathFindDist;
+						expected = ((chokeCenter.x + 1) << 16) | chokeCenter.y;
+					}
+				}
+				if (expected == -1 && r != nullptr) expected = model.hashRegionCenter(r);
+				CHECK(model.regionData.tiles(x, y).cdr == expected, "CDR of " << x << "," << y << ": " << model.regionData.tiles(x, y).cdr << " instead of " << expected);
+			}
+		}
+	}
+
+	void checkRegionDistances(const MapModel& model)
+	{
+		std::vector<Dump::Region*> regions(game->getRegions().begin(), game->getRegions().end());
+		std::vector<Position> centers;
+		for (const auto& r : regions) {
+			// min of the sum of the distances to the chokes on the paths between the chokes
+			std::vector<Position> chokes;
+			for (const auto& c : r->getChokepoints()) chokes.push_back(c->getCenter());
+			TilePosition center(r->getCenter());
+			double minDist = DBL_MAX;
+			for (const auto& c1 : chokes) {
+				for (const auto& c2 : chokes) {
+					if (c1 == c2) continue;
+					for (const auto& tp : game->getShortestPath(TilePosition(c1), TilePosition(c2))) {
+						double d = 0.0;
+						for (const auto& c : chokes) d += game->getGroundDistance(TilePosition(c), tp);
+						if (d < minDist) {
+							minDist = d;
+							center = tp;
+						}
+					}
+				}
+			}
+			centers.push_back(chokes.empty() ? r->getCenter() : Position(center));
+			int i = model._pfMaps.distRegions.index(model.hashRegionCenter(r));
+			CHECK(i >= 0, "region " << model.hashRegionCenter(r) << " not in distRegions");
+			Position cached(model._pfMaps.regionsPFCenters[i * 2], model._pfMaps.regionsPFCenters[i * 2 + 1]);
+			CHECK(cached == centers.back(), "center of region " << model.hashRegionCenter(r) << ": " << cached << " instead of " << centers.back());
+		}
+		// from the first region (game order) to the second
+		for (size_t i = 0; i < regions.size(); ++i) {
+			for (size_t j = i; j < regions.size(); ++j) {
+				float d = i == j ? 0.0f : quantized(game->getGroundDistance(TilePosition(centers[i]), TilePosition(centers[j])));
+				CHECK(model.regionDistance(regions[i], regions[j]) == d && model.regionDistance(regions[j], regions[i]) == d,
+					"distance of regions " << i << " and " << j << ": " << model.regionDistance(regions[i], regions[j]) << " instead of " << d);
+			}
+		}
+	}
+
+	void checkCDRDistances(const MapModel& model)
+	{
+		// from the closest walkable tile of the CDR to its center, or the closest walkable tile if it has none
+		int width = game->mapWidth();
+		int height = game->mapHeight();
+		const DistanceMatrix& m = model._pfMaps.distCDR;
+		std::vector<TilePosition> sources;
+		for (int i = 0; i < m.size; ++i) {
+			TilePosition center = model.cdrCenter(m.ids[i]);
+			TilePosition source(-1, -1);
+			TilePosition walkable(-1, -1);
+			int minDist = INT_MAX;
+			int minWalkable = INT_MAX;
+			for (int x = 0; x < width; ++x) {
+				for (int y = 0; y < height; ++y) {
+					if (!model.regionData.tiles(x, y).walkable) continue;
+					int d = squared(x - center.x, y - center.y);
+					if (model.regionData.tiles(x, y).cdr == m.ids[i] && d < minDist) {
+						minDist = d;
+						source = TilePosition(x, y);
+					}
+					if (d < minWalkable) {
+						minWalkable = d;
+						walkable = TilePosition(x, y);
+					}
+				}
+			}
+			sources.push_back(minDist != INT_MAX ? source : minWalkable != INT_MAX ? walkable : center);
+		}
+		for (int i = 0; i < m.size; ++i) {
+			for (int j = i; j < m.size; ++j) {
+				float d = i == j ? 0.0f : quantized(game->getGroundDistance(sources[i], sources[j]));
+				CHECK(m.at(i, j) == d && m.at(j, i) == d, "distance of CDRs " << m.ids[i] << " and " << m.ids[j] << ": " << m.at(i, j) << " instead of " << d);
+			}
+		}
+	}
+
+	// ActionSelection's region of a tile without one: the first tile with a region on a spiral around it
+	Dump::Region* spiralRegion(int x, int y)
+	{
+		int length = 1;
+		int j = 0;
+		bool first = true;
+		int dx = 0;
+		int dy = 1;
+		while (length < game->mapWidth()) {
+			Dump::Region* r = game->getRegion(TilePosition(x, y));
+			if (r != nullptr) return r;
+			x += dx;
+			y += dy;
+			if (++j == length) {
+				j = 0;
+				if (!first) length++;
+				first = !first;
+				if (dx == 0) {
+					dx = dy;
+					dy = 0;
+				} else {
+					dy = -dx;
+					dx = 0;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	void checkGrids(const MapModel& model)
+	{
+		int width = game->mapWidth();
+		int height = game->mapHeight();
+		const DistanceMatrix& cdrs = model._pfMaps.distCDR;
+		for (int x = 0; x < width; ++x) {
+			for (int y = 0; y < height; ++y) {
+				// first region (game order) or CDR (id order) on ties
+				Dump::Region* region = nullptr;
+				int m = INT_MAX;
+				for (const auto& r : game->getRegions()) {
+					if (squared(r->getCenter().x - x * TILE_SIZE, r->getCenter().y - y * TILE_SIZE) < m) {
+						m = squared(r->getCenter().x - x * TILE_SIZE, r->getCenter().y - y * TILE_SIZE);
+						region = r;
+					}
+				}
+				int expected = region == nullptr ? -1 : model._pfMaps.distRegions.index(model.hashRegionCenter(region));
+				CHECK(model.regionData.closestRegion(x, y) == expected, "closest region of " << x << "," << y);
+				expected = -1;
+				m = INT_MAX;
+				for (int i = 0; i < cdrs.size; ++i) {
+					TilePosition center = model.cdrCenter(cdrs.ids[i]);
+					if (squared(center.x - x, center.y - y) < m) {
+						m = squared(center.x - x, center.y - y);
+						expected = i;
+					}
+				}
+				CHECK(model.regionData.closestCDR(x, y) == expected, "closest CDR of " << x << "," << y);
+				// first in x then y order on ties
+				expected = -1;
+				m = INT_MAX;
+				for (int wx = 0; wx < width; ++wx) {
+					for (int wy = 0; wy < height; ++wy) {
+						if (model.regionData.tiles(wx, wy).walkable && squared(wx - x, wy - y) < m) {
+							m = squared(wx - x, wy - y);
+							expected = wx + wy * width;
+						}
+					}
+				}
+				CHECK(model.regionData.closestWalkable(x, y) == expected, "closest walkable tile of " << x << "," << y);
+				Dump::Region* nearest = spiralRegion(x, y);
+				auto id = model.regionID.find(nearest);
+				CHECK(model.regionIdMap(x, y) == static_cast<int32_t>(id == model.regionID.end() ? 0 : id->second),
+					"ActionSelection region of " << x << "," << y);
+			}
+		}
+		for (size_t i = 0; i < model.regionFromID.size(); ++i) {
+			for (size_t j = 0; j < model.regionFromID.size(); ++j) {
+				Position p1 = model.regionFromID[i]->getCenter();
+				Position p2 = model.regionFromID[j]->getCenter();
+				int d = game->isWalkable(WalkPosition(p1)) && game->isWalkable(WalkPosition(p2))
+					? static_cast<int>(game->getGroundDistance(TilePosition(p1), TilePosition(p2))) : static_cast<int>(p1.getDistance(p2));
+				CHECK(model.distanceBetweenRegions(i, j) == d, "distance between the centers of regions " << i << " and " << j);
+			}
+		}
+	}
+
+	template <class T>
+	bool sameGrid(const TileGrid<T>& a, const TileGrid<T>& b)
+	{
+		return a.getWidth() == b.getWidth() && a.getHeight() == b.getHeight()
+			&& memcmp(a.data(), b.data(), a.getWidth() * a.getHeight() * sizeof(T)) == 0;
+	}
+
+	bool sameMatrix(const DistanceMatrix& a, const DistanceMatrix& b)
+	{
+		return a.size == b.size && std::equal(a.ids, a.ids + a.size, b.ids) && std::equal(a.distances, a.distances + a.size * a.size, b.distances);
+	}
+
+	void checkCache(const MapModel& computed, const MapModel& cached)
+	{
+		CHECK(sameGrid(computed.regionData.tiles, cached.regionData.tiles), "tiles");
+		CHECK(sameGrid(computed.regionData.closestRegion, cached.regionData.closestRegion), "closest regions");
+		CHECK(sameGrid(computed.regionData.closestCDR, cached.regionData.closestCDR), "closest CDRs");
+		CHECK(sameGrid(computed.regionData.closestWalkable, cached.regionData.closestWalkable), "closest walkable tiles");
+		CHECK(sameGrid(computed.regionIdMap, cached.regionIdMap), "ActionSelection regions");
+		CHECK(sameMatrix(computed._pfMaps.distRegions, cached._pfMaps.distRegions), "region distances");
+		CHECK(sameMatrix(computed._pfMaps.distCDR, cached._pfMaps.distCDR), "CDR distances");
+		int regions = computed._pfMaps.distRegions.size;
+		CHECK(std::equal(computed._pfMaps.regionsPFCenters, computed._pfMaps.regionsPFCenters + regions * 2, cached._pfMaps.regionsPFCenters),
+			"region centers");
+		CHECK(computed.allChokeDepRegs == cached.allChokeDepRegs, "CDRs");
+		CHECK(computed.regionID == cached.regionID, "ActionSelection numbering");
+		for (size_t i = 0; i < computed.regionFromID.size(); ++i) {
+			for (size_t j = 0; j < computed.regionFromID.size(); ++j) {
+				CHECK(computed.distanceBetweenRegions(i, j) == cached.distanceBetweenRegions(i, j), "distance between the centers of regions");
+			}
+		}
+	}
+}
+
+int main()
+{
+	TemporaryFolder cache;
+	TERRAIN_CACHE_FOLDER = cache.path.string() + "/";
+	const int maps[][3] = { { 1, 36, 3 }, { 2, 48, 3 }, { 3, 48, 4 }, { 4, 64, 4 }, { 5, 64, 5 }, { 6, 40, 2 } }; // seed, size, blocks
+	for (const auto& m : maps) {
+		MockGame* map = randomMap(m[0], m[1], m[2]);
+		game = map;
+		{
+			MapModel computed;
+			checkChokeDependantRegions(computed);
+			checkRegionDistances(computed);
+			checkCDRDistances(computed);
+			checkGrids(computed);
+			CHECK(boost::filesystem::exists(cache.path / (map->mapHash() + ".terrain")), "cache not written");
+			MapModel cached;
+			checkCache(computed, cached);
+		}
+		delete map;
+	}
+	std::cout << failures << " failed checks" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
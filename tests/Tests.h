@@ -0,0 +1,108 @@
+#pragma once
+
+// Checks of the headless build (ctest): the fast paths against the straightforward computations they
+// replaced, on random MockGame maps. Each test program prints the failed checks and returns 1 if any.
+
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "boost/filesystem.hpp"
+
+#include "MockGame.h"
+#include "Utils.h"
+
+static int failures = 0;
+
+#define CHECK(cond, what) do { \
+	if (!(cond)) { \
+		++failures; \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": " << what << std::endl; \
+	} \
+} while (0)
+
+// A size x size map cut in blocks x blocks square regions by 1 tile walls, each wall with a gap (the
+// chokepoint) of random width and position, a few walls closed (unreachable regions), and random
+// obstacles in walk tiles so that some build tiles are partly walkable. The obstacles and the walls
+// keep or lose their region at random, the choke centers are anywhere in their gap tile.
+inline MockGame* randomMap(unsigned seed, int size, int blocks)
+{
+	std::mt19937 rng(seed);
+	auto random = [&](int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); };
+	MockGame* map = new MockGame(size, size, "test_" + std::to_string(seed) + "_" + std::to_string(size));
+	int block = size / blocks;
+
+	std::vector<MockRegion*> regions;
+	for (int by = 0; by < blocks; ++by) {
+		for (int bx = 0; bx < blocks; ++bx) {
+			MockRegion* r = map->createRegion(BWAPI::Position((bx * block + block / 2) * BWAPI::TILE_SIZE + random(BWAPI::TILE_SIZE),
+				(by * block + block / 2) * BWAPI::TILE_SIZE + random(BWAPI::TILE_SIZE)));
+			r->polygonCenter = r->center;
+			for (int x = bx * block; x < (bx + 1) * block; ++x) {
+				for (int y = by * block; y < (by + 1) * block; ++y) map->setRegion(BWAPI::TilePosition(x, y), r);
+			}
+			regions.push_back(r);
+		}
+	}
+	int obstacles = random(4 * size);
+	for (int k = 0; k < obstacles; ++k) {
+		int wx = random(size * 4);
+		int wy = random(size * 4);
+		int w = 1 + random(12);
+		int h = 1 + random(12);
+		for (int i = wx; i < std::min(size * 4, wx + w); ++i) {
+			for (int j = wy; j < std::min(size * 4, wy + h); ++j) map->setWalkable(i, j, false);
+		}
+		if (random(2) == 0) {
+			for (int x = wx / 4; x < std::min(size, (wx + w) / 4); ++x) {
+				for (int y = wy / 4; y < std::min(size, (wy + h) / 4); ++y) map->setRegion(BWAPI::TilePosition(x, y), nullptr);
+			}
+		}
+	}
+	auto wall = [&](int x, int y) {
+		for (int i = 0; i < 4; ++i) {
+			for (int j = 0; j < 4; ++j) map->setWalkable(x * 4 + i, y * 4 + j, false);
+		}
+		if (random(2) == 0) map->setRegion(BWAPI::TilePosition(x, y), nullptr);
+	};
+	for (int by = 0; by < blocks; ++by) {
+		for (int bx = 0; bx < blocks; ++bx) {
+			for (int vertical = 0; vertical < 2; ++vertical) {
+				if ((vertical ? bx : by) + 1 >= blocks) continue;
+				int line = ((vertical ? bx : by) + 1) * block;
+				int from = (vertical ? by : bx) * block;
+				bool closed = random(6) == 0;
+				int gap = 2 + random(block / 2);
+				int start = from + 1 + random(block - gap - 1);
+				for (int i = from; i < from + block; ++i) {
+					if (closed || i < start || i >= start + gap) {
+						if (vertical) wall(line, i); else wall(i, line);
+					}
+				}
+				if (closed) continue;
+				BWAPI::TilePosition c = vertical ? BWAPI::TilePosition(line, start + gap / 2) : BWAPI::TilePosition(start + gap / 2, line);
+				MockRegion* other = regions[bx + vertical + (by + 1 - vertical) * blocks];
+				map->createChokepoint(BWAPI::Position(c) + BWAPI::Position(random(BWAPI::TILE_SIZE), random(BWAPI::TILE_SIZE)),
+					random(3) == 0 ? (10 + random(8)) * BWAPI::TILE_SIZE : gap * BWAPI::TILE_SIZE, regions[bx + by * blocks], other);
+			}
+		}
+	}
+	map->computeReachableRegions();
+	return map;
+}
+
+// a new empty folder for the terrain caches, removed with the object
+struct TemporaryFolder
+{
+	boost::filesystem::path path;
+
+	TemporaryFolder() : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("bwrepdump-%%%%-%%%%"))
+	{
+		boost::filesystem::create_directories(path);
+	}
+	~TemporaryFolder()
+	{
+		boost::system::error_code ignored;
+		boost::filesystem::remove_all(path, ignored);
+	}
+};
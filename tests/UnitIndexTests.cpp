@@ -0,0 +1,58 @@
+// UnitIndex against the radius queries of the game it replaced (game->getUnitsInRadius and
+// unit->getUnitsInRadius), on random units moving over the frames, some of them out of the map,
+// loaded or dead.
+
+#include "Tests.h"
+#include "UnitIndex.h"
+
+using namespace BWAPI;
+
+int main()
+{
+	const UnitType types[] = { UnitTypes::Terran_Marine, UnitTypes::Terran_Siege_Tank_Tank_Mode, UnitTypes::Terran_Command_Center,
+		UnitTypes::Protoss_Zealot, UnitTypes::Protoss_Carrier, UnitTypes::Protoss_Nexus, UnitTypes::Zerg_Zergling,
+		UnitTypes::Zerg_Hydralisk, UnitTypes::Zerg_Hatchery, UnitTypes::Resource_Mineral_Field };
+	for (unsigned seed = 1; seed <= 3; ++seed) {
+		std::mt19937 rng(seed);
+		auto random = [&](int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); };
+		int size = 32 + 32 * seed;
+		MockGame* map = new MockGame(size, size);
+		game = map;
+		int pixels = size * TILE_SIZE;
+		std::vector<MockPlayer*> players;
+		for (int p = 0; p < 3; ++p) players.push_back(map->createPlayer(p, "Player " + std::to_string(p), Races::Terran));
+		std::vector<MockUnit*> units;
+		for (int id = 0; id < 100 * static_cast<int>(seed); ++id) {
+			Position p(random(pixels + 200) - 100, random(pixels + 200) - 100);
+			units.push_back(map->createUnit(id, types[random(10)], players[random(3)], p));
+		}
+		UnitIndex index;
+		for (int frame = 0; frame < 30; ++frame) {
+			map->frameCount = frame;
+			for (const auto& u : units) {
+				u->position += Position(random(97) - 48, random(97) - 48);
+				u->setFlag(MockUnit::Loaded, random(10) == 0);
+				if (!u->exists() && random(3) == 0) map->restoreUnit(u);
+				else if (u->exists() && random(20) == 0) map->destroyUnit(u);
+			}
+			for (int q = 0; q < 100; ++q) {
+				Position center(random(pixels + 400) - 200, random(pixels + 400) - 200);
+				int radius = random(600);
+				CHECK(index.getUnitsInRadius(center, radius) == map->getUnitsInRadius(center, radius),
+					"frame " << frame << ": units in " << radius << " of " << center);
+				MockUnit* unit = units[random(static_cast<int>(units.size()))];
+				Dump::Player ignored = random(2) == 0 ? nullptr : players[random(3)];
+				Dump::Unitset expected;
+				if (unit->exists()) {
+					for (const auto& u : unit->getUnitsInRadius(radius)) {
+						if (u->getPlayer() != ignored) expected.insert(u);
+					}
+				}
+				CHECK(index.getUnitsInRadius(unit, radius, ignored) == expected, "frame " << frame << ": units in " << radius << " of unit " << unit->id);
+			}
+		}
+		delete map;
+	}
+	std::cout << failures << " failed checks" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+// Probabilities of the abstract actions of the ASD files (ActionSelection), printed as the C++
+// basicProb / priorProb initializers, replacing scripts/probs.py (same counting, same output).
+// Usage: bwrepdump_probs [--threads n] [--state probs.state] [--rebuild] [--out tables.h] input...
+// An input is an .asd file, a folder (searched recursively for .asd files) or a corpus archive
+// (.bwca, the .asd stream of each replay). The files are counted in parallel, one counter per
+// thread, merged at the end.
+// With --state the counters and the list of the counted files are kept in that file, a next run
+// only counts the new files and prints the tables of everything. A counted file that changed since
+// is reported and skipped, --rebuild counts everything again.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "boost/archive/binary_iarchive.hpp"
+#include "boost/archive/binary_oarchive.hpp"
+#include "boost/filesystem.hpp"
+#include "boost/serialization/map.hpp"
+#include "boost/serialization/utility.hpp"
+
+#include "CorpusArchive.h"
+#include "ReplayParser.h"
+
+// ====================================================================================
+// Counters
+// ====================================================================================
+
+// the options of probs.py: Idle, Attack, then Move$f$e$tf$te (region features of the move target)
+const int IDLE = 0;
+const int ATTACK = 1;
+const int MOVE = 2; // + features as a 4 bits number, $f the highest
+const int OPTIONS = MOVE + 16;
+
+std::string optionName(int option)
+{
+	if (option == IDLE) return "Idle";
+	if (option == ATTACK) return "Attack";
+	std::string name("Move");
+	for (int bit = 3; bit >= 0; --bit) name += ((option - MOVE) >> bit) & 1 ? '1' : '0';
+	return name;
+}
+
+struct Counts
+{
+	uint64_t selected[OPTIONS];              // sIdle, sAttack, sMove
+	uint64_t available[OPTIONS];             // totalCount
+	uint64_t selectedWhen[OPTIONS][OPTIONS]; // sIdleWhen, sAttackWhen, sMoveWhen
+	uint64_t samples;
+	uint64_t skipped;                        // unknown possible action or region (probs.py skips or fails)
+	uint64_t otherOrders;                    // selected action not Idle/Attack/Move (Nothing, Gas, ...)
+
+	Counts() { memset(this, 0, sizeof(*this)); }
+
+	void add(const Counts& other)
+	{
+		for (int i = 0; i < OPTIONS; ++i) {
+			selected[i] += other.selected[i];
+			available[i] += other.available[i];
+			for (int j = 0; j < OPTIONS; ++j) selectedWhen[i][j] += other.selectedWhen[i][j];
+		}
+		samples += other.samples;
+		skipped += other.skipped;
+		otherOrders += other.otherOrders;
+	}
+
+	template<class Archive>
+	void serialize(Archive& ar, const unsigned int /*version*/)
+	{
+		ar & selected & available & selectedWhen & samples & skipped & otherOrders;
+	}
+};
+
+// Move option of the region, -1 if the sample has no features for it
+int moveOption(const ASDSample& sample, int region)
+{
+	for (const auto& r : sample.regions) {
+		if (r.region == region) {
+			return MOVE + (r.hasFriend << 3) + (r.hasEnemy << 2) + (r.towardsFriendBase << 1) + r.towardsEnemyBase;
+		}
+	}
+	return -1;
+}
+
+void count(const ASDSample& sample, Counts& counts)
+{
+	counts.samples++;
+
+	// Idle is always possible, then the moves with different target features
+	bool options[OPTIONS] = { true };
+	const char* p = sample.actions.begin;
+	do {
+		const char* comma = Parse::find(p, sample.actions.end, ',');
+		Parse::Token action = { p, comma };
+		if (action == "ATTACK") {
+			options[ATTACK] = true;
+		} else if (action.size() > 5 && memcmp(action.begin, "MOVE:", 5) == 0) {
+			int option = moveOption(sample, Parse::Token{ action.begin + 5, action.end }.toInt());
+			if (option < 0) {
+				counts.skipped++;
+				return;
+			}
+			options[option] = true;
+		} else { // includes the empty action of "" and "ATTACK,", as probs.py
+			counts.skipped++;
+			return;
+		}
+		p = comma + 1;
+	} while (p <= sample.actions.end);
+
+	int selected;
+	if (sample.order == "Idle") selected = IDLE;
+	else if (sample.order == "Attack") selected = ATTACK;
+	else if (sample.order == "Move") selected = moveOption(sample, sample.targetRegion);
+	else selected = -2;
+	if (selected == -1) {
+		counts.skipped++;
+		return;
+	}
+
+	for (int option = 0; option < OPTIONS; ++option) {
+		if (!options[option]) continue;
+		counts.available[option]++;
+		if (selected >= 0) counts.selectedWhen[selected][option]++;
+	}
+	if (selected >= 0) counts.selected[selected]++;
+	else counts.otherOrders++;
+}
+
+void countText(const char* data, size_t size, Counts& counts)
+{
+	ASDParser parser(data, size);
+	for (const auto& sample : parser) count(sample, counts);
+}
+
+// ====================================================================================
+// Output, as printed by probs.py (Python 2)
+// ====================================================================================
+
+// str() of a Python 2 float
+std::string pythonFloat(double value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.12g", value);
+	std::string s(buffer);
+	if (s.find_first_of(".en") == std::string::npos) s += ".0";
+	return s;
+}
+
+std::string probability(uint64_t count, uint64_t total)
+{
+	return count == 0 || total == 0 ? "0.0" : pythonFloat(count / static_cast<double>(total));
+}
+
+void printTables(const Counts& counts, std::ostream& out)
+{
+	out << "std::map<uint8_t, double> basicProb = {\n";
+	for (int option = 0; option < OPTIONS; ++option) {
+		out << "  { probName::" << optionName(option) << ", " << probability(counts.selected[option], counts.available[option])
+			<< " }" << (option + 1 < OPTIONS ? "," : "") << "\n";
+	}
+	out << "};\n\n";
+
+	out << "std::map<uint8_t, std::map<uint8_t, double> > priorProb = {\n";
+	for (int selected = 0; selected < OPTIONS; ++selected) {
+		if (selected > 0) out << "  } },\n";
+		out << "  { probName::" << optionName(selected) << ", {\n";
+		for (int option = 0; option < OPTIONS; ++option) {
+			out << "    { probName::" << optionName(option) << ", "
+				<< probability(counts.selectedWhen[selected][option], counts.selected[selected])
+				<< " }" << (option + 1 < OPTIONS ? "," : "") << "\n";
+		}
+	}
+	out << "  } }\n};\n";
+}
+
+// ====================================================================================
+// Inputs and incremental state
+// ====================================================================================
+
+struct Input
+{
+	std::string key;              // file path, or archive path + "|" + replay path
+	std::pair<uint64_t, int64_t> stamp; // size and modification time (replay hash in an archive)
+	const CorpusReader* archive;
+	const CorpusReader::Replay* replay;
+};
+
+struct State
+{
+	Counts counts;
+	std::map<std::string, std::pair<uint64_t, int64_t> > files;
+
+	template<class Archive>
+	void serialize(Archive& ar, const unsigned int /*version*/)
+	{
+		ar & counts & files;
+	}
+};
+
+void addFile(const boost::filesystem::path& path, std::vector<Input>& inputs)
+{
+	Input input = { path.string(), std::make_pair(static_cast<uint64_t>(boost::filesystem::file_size(path)),
+		static_cast<int64_t>(boost::filesystem::last_write_time(path))), nullptr, nullptr };
+	inputs.push_back(input);
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	std::string statePath, outPath;
+	bool rebuild = false;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (i + 1 < argc && arg == "--threads") threads = std::max(1, atoi(argv[++i]));
+		else if (i + 1 < argc && arg == "--state") statePath = argv[++i];
+		else if (i + 1 < argc && arg == "--out") outPath = argv[++i];
+		else if (arg == "--rebuild") rebuild = true;
+		else paths.push_back(arg);
+	}
+	if (paths.empty() && statePath.empty()) {
+		std::cerr << "Usage: " << argv[0] << " [--threads n] [--state probs.state] [--rebuild] [--out tables.h] file.asd|folder|corpus.bwca ..." << std::endl;
+		return 1;
+	}
+
+	try {
+		State state;
+		if (!statePath.empty() && !rebuild && boost::filesystem::exists(statePath)) {
+			std::ifstream ifs(statePath.c_str(), std::ios::binary);
+			boost::archive::binary_iarchive ia(ifs);
+			ia >> state;
+		}
+
+		// inputs not counted yet
+		std::vector<std::unique_ptr<CorpusReader> > archives;
+		std::vector<Input> inputs;
+		for (const auto& path : paths) {
+			if (boost::filesystem::is_directory(path)) {
+				for (boost::filesystem::recursive_directory_iterator it(path), end; it != end; ++it) {
+					if (boost::filesystem::is_regular_file(it->path()) && it->path().extension() == ".asd") addFile(it->path(), inputs);
+				}
+			} else if (boost::filesystem::path(path).extension() == ".bwca") {
+				archives.emplace_back(new CorpusReader(path));
+				for (const auto& replay : archives.back()->getReplays()) {
+					size_t size;
+					if (archives.back()->stream(replay, ".asd", size) == nullptr) continue;
+					Input input = { path + "|" + replay.path, std::make_pair(static_cast<uint64_t>(size), static_cast<int64_t>(replay.hash)),
+						archives.back().get(), &replay };
+					inputs.push_back(input);
+				}
+			} else {
+				addFile(path, inputs);
+			}
+		}
+		std::vector<Input> pending;
+		for (const auto& input : inputs) {
+			auto counted = state.files.find(input.key);
+			if (counted == state.files.end()) pending.push_back(input);
+			else if (counted->second != input.stamp) std::cerr << input.key << " changed since it was counted, use --rebuild to count it again" << std::endl;
+		}
+
+		// map: one Counts per thread, reduce: sum
+		std::atomic<size_t> next(0);
+		std::vector<Counts> partial(threads);
+		std::vector<std::string> errors;
+		std::mutex errorsMutex;
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < threads; ++t) {
+			workers.emplace_back([&, t]() {
+				for (size_t i = next++; i < pending.size(); i = next++) {
+					const Input& input = pending[i];
+					try {
+						if (input.archive != nullptr) {
+							size_t size;
+							const char* data = input.archive->stream(*input.replay, ".asd", size);
+							countText(data, size, partial[t]);
+						} else {
+							Parse::Source source(input.key);
+							countText(source.data(), source.size(), partial[t]);
+						}
+					} catch (const std::exception& e) {
+						std::lock_guard<std::mutex> lock(errorsMutex);
+						errors.push_back(input.key + ": " + e.what());
+					}
+				}
+			});
+		}
+		for (auto& worker : workers) worker.join();
+		for (const auto& counts : partial) state.counts.add(counts);
+		for (const auto& error : errors) std::cerr << error << std::endl;
+		for (const auto& input : pending) state.files[input.key] = input.stamp;
+
+		if (!statePath.empty()) {
+			std::ofstream ofs(statePath.c_str(), std::ios::binary);
+			boost::archive::binary_oarchive oa(ofs);
+			oa << state;
+		}
+
+		std::cerr << pending.size() << " new files, " << state.files.size() << " files, " << state.counts.samples << " samples ("
+			<< state.counts.skipped << " skipped, " << state.counts.otherOrders << " with another order)" << std::endl;
+		if (outPath.empty()) {
+			printTables(state.counts, std::cout);
+		} else {
+			std::ofstream out(outPath.c_str());
+			printTables(state.counts, out);
+		}
+		return errors.empty() ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,477 @@
+// Benchmarks of the extractors hot paths on synthetic games (MockGame), to see how each module
+// scales with the number of players, units and the map size.
+// Usage: bwrepdump_bench [--maps 64,128,256] [--players 2,4,8] [--units 100,500,2000] [--frames 300] [--csv]
+// For each workload it reports the time and heap allocations per frame of every module onFrame and
+// callbacks, of the helpers timed with PROFILE_SPAN, and per call of the MapModel lookups.
+// The extractors output files go to the temp directory, the terrain cache to the working directory.
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "MockGame.h"
+#include "Extractors.h"
+
+using namespace BWAPI;
+
+extern std::atomic<size_t> allocations; // heap allocations so far, counted by BenchmarkAllocations.cpp
+
+// ====================================================================================
+// Synthetic game
+// ====================================================================================
+
+struct Workload
+{
+	int mapSize; // build tiles
+	int players;
+	int units;   // without the neutral minerals
+};
+
+// The map is a 4x4 grid of square regions separated by 1 tile walls, with a 4 tiles wide
+// chokepoint in the middle of each wall. Each player has a base (townhall, workers mining)
+// and an army wandering between the regions and the enemy bases, fighting what it meets.
+// Dead units respawn at their base.
+class SyntheticGame
+{
+public:
+	MockGame* game;
+
+	SyntheticGame(const Workload& w, unsigned seed);
+	~SyntheticGame() { delete game; }
+	// plays one frame, the callbacks to forward to the extractors are returned
+	void step(std::vector<MockUnit*>& created, std::vector<MockUnit*>& destroyed);
+
+private:
+	static const int REGIONS_PER_SIDE = 4;
+	static const int CELL_SIZE = 128; // pixels, to find the enemies near a unit
+	Workload workload;
+	std::mt19937 rng;
+	int nextUnitID;
+	int block; // region side in build tiles
+	std::vector<MockPlayer*> players;
+	std::vector<Position> bases;
+	std::map<MockPlayer*, std::vector<UnitType> > raceTypes; // townhall, worker, 2 military types
+	std::map<MockPlayer*, std::vector<MockUnit*> > baseMinerals;
+	std::map<MockUnit*, Position> destinations;
+	std::vector<std::pair<int, MockUnit*> > respawns; // frame, dead unit
+	std::vector<std::vector<MockUnit*> > cells;
+
+	int random(int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); }
+	void setTileWalkable(int x, int y, bool walkable);
+	Position blockCenter(int bx, int by) const;
+	Position nearBase(int player, int spread);
+	MockUnit* createUnit(UnitType type, MockPlayer* player, Position p);
+	Position newDestination(MockUnit* u);
+	MockUnit* findEnemy(MockUnit* u);
+};
+
+SyntheticGame::SyntheticGame(const Workload& w, unsigned seed)
+	: workload(w), rng(seed), nextUnitID(0), block(w.mapSize / REGIONS_PER_SIDE)
+{
+	int size = w.mapSize;
+	game = new MockGame(size, size, "bench" + std::to_string(size));
+	game->name = "Synthetic " + std::to_string(size) + "x" + std::to_string(size);
+	game->pathName = (boost::filesystem::temp_directory_path() / ("bench_" + std::to_string(size) + "_"
+		+ std::to_string(w.players) + "_" + std::to_string(w.units) + ".rep")).string();
+
+	// walls and chokepoints
+	for (int k = 1; k < REGIONS_PER_SIDE; ++k) {
+		for (int i = 0; i < size; ++i) {
+			int inBlock = i % block;
+			if (inBlock >= block / 2 - 2 && inBlock < block / 2 + 2) continue;
+			setTileWalkable(k * block, i, false);
+			setTileWalkable(i, k * block, false);
+		}
+	}
+	std::vector<MockRegion*> regions;
+	for (int by = 0; by < REGIONS_PER_SIDE; ++by) {
+		for (int bx = 0; bx < REGIONS_PER_SIDE; ++bx) {
+			MockRegion* r = game->createRegion(blockCenter(bx, by));
+			int left = bx * block * TILE_SIZE;
+			int top = by * block * TILE_SIZE;
+			r->polygon.push_back(Position(left, top));
+			r->polygon.push_back(Position(left + block * TILE_SIZE, top));
+			r->polygon.push_back(Position(left + block * TILE_SIZE, top + block * TILE_SIZE));
+			r->polygon.push_back(Position(left, top + block * TILE_SIZE));
+			for (int x = bx * block; x < (bx + 1) * block; ++x) {
+				for (int y = by * block; y < (by + 1) * block; ++y) {
+					bool wall = (x % block == 0 && x != 0) || (y % block == 0 && y != 0);
+					game->setRegion(TilePosition(x, y), wall ? nullptr : r);
+				}
+			}
+			regions.push_back(r);
+		}
+	}
+	for (int by = 0; by < REGIONS_PER_SIDE; ++by) {
+		for (int bx = 0; bx < REGIONS_PER_SIDE; ++bx) {
+			MockRegion* r = regions[bx + by * REGIONS_PER_SIDE];
+			if (bx + 1 < REGIONS_PER_SIDE) {
+				TilePosition c((bx + 1) * block, by * block + block / 2);
+				MockChokepoint* choke = game->createChokepoint(Position(c), 4 * TILE_SIZE, r, regions[bx + 1 + by * REGIONS_PER_SIDE]);
+				choke->sides = std::make_pair(Position(TilePosition(c.x, c.y - 2)), Position(TilePosition(c.x, c.y + 2)));
+			}
+			if (by + 1 < REGIONS_PER_SIDE) {
+				TilePosition c(bx * block + block / 2, (by + 1) * block);
+				MockChokepoint* choke = game->createChokepoint(Position(c), 4 * TILE_SIZE, r, regions[bx + (by + 1) * REGIONS_PER_SIDE]);
+				choke->sides = std::make_pair(Position(TilePosition(c.x - 2, c.y)), Position(TilePosition(c.x + 2, c.y)));
+			}
+		}
+	}
+	game->computeReachableRegions();
+
+	// players and bases, spread over the regions (corners first)
+	const int baseBlocks[8][2] = { { 0, 0 }, { 3, 3 }, { 3, 0 }, { 0, 3 }, { 1, 2 }, { 2, 1 }, { 2, 3 }, { 1, 0 } };
+	const Race races[3] = { Races::Terran, Races::Protoss, Races::Zerg };
+	MockPlayer* neutral = game->createPlayer(11, "Neutral", Races::None);
+	neutral->neutral = true;
+	for (int i = 0; i < w.players; ++i) {
+		MockPlayer* p = game->createPlayer(i, "Player " + std::to_string(i), races[i % 3]);
+		if (p->race == Races::Terran) {
+			raceTypes[p] = { UnitTypes::Terran_Command_Center, UnitTypes::Terran_SCV, UnitTypes::Terran_Marine, UnitTypes::Terran_Siege_Tank_Tank_Mode };
+		} else if (p->race == Races::Protoss) {
+			raceTypes[p] = { UnitTypes::Protoss_Nexus, UnitTypes::Protoss_Probe, UnitTypes::Protoss_Zealot, UnitTypes::Protoss_Dragoon };
+		} else {
+			raceTypes[p] = { UnitTypes::Zerg_Hatchery, UnitTypes::Zerg_Drone, UnitTypes::Zerg_Zergling, UnitTypes::Zerg_Hydralisk };
+		}
+		Position base = blockCenter(baseBlocks[i % 8][0], baseBlocks[i % 8][1]);
+		bases.push_back(base);
+		p->startLocation = TilePosition(base) - TilePosition(2, 1);
+		game->startLocations.push_back(p->startLocation);
+		players.push_back(p);
+
+		for (int m = 0; m < 8; ++m) {
+			MockUnit* mineral = createUnit(UnitTypes::Resource_Mineral_Field, neutral, base + Position(-160 + m * 40, -128));
+			mineral->resourceGroup = i;
+			baseMinerals[p].push_back(mineral);
+		}
+	}
+
+	int perPlayer = std::max(3, w.units / w.players);
+	for (int i = 0; i < w.players; ++i) {
+		MockPlayer* p = players[i];
+		createUnit(raceTypes[p][0], p, bases[i]);
+		int workers = perPlayer * 3 / 10;
+		for (int k = 0; k < workers; ++k) createUnit(raceTypes[p][1], p, nearBase(i, 96));
+		for (int k = workers + 1; k < perPlayer; ++k) createUnit(raceTypes[p][2 + k % 2], p, nearBase(i, 256));
+	}
+	cells.resize((size * TILE_SIZE / CELL_SIZE + 1) * (size * TILE_SIZE / CELL_SIZE + 1));
+}
+
+void SyntheticGame::setTileWalkable(int x, int y, bool walkable)
+{
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) game->setWalkable(x * 4 + i, y * 4 + j, walkable);
+	}
+}
+
+Position SyntheticGame::blockCenter(int bx, int by) const
+{
+	return Position(TilePosition(bx * block + block / 2, by * block + block / 2)) + Position(16, 16);
+}
+
+Position SyntheticGame::nearBase(int player, int spread)
+{
+	return bases[player] + Position(random(2 * spread) - spread, random(2 * spread) - spread);
+}
+
+MockUnit* SyntheticGame::createUnit(UnitType type, MockPlayer* player, Position p)
+{
+	MockUnit* u = game->createUnit(nextUnitID++, type, player, p);
+	if (type.canMove() && !type.isWorker()) destinations[u] = newDestination(u);
+	return u;
+}
+
+Position SyntheticGame::newDestination(MockUnit* u)
+{
+	if (random(2) == 0 && players.size() > 1) {
+		int enemy = random(static_cast<int>(players.size()));
+		if (players[enemy] != u->player) return nearBase(enemy, 128);
+	}
+	return blockCenter(random(REGIONS_PER_SIDE), random(REGIONS_PER_SIDE));
+}
+
+MockUnit* SyntheticGame::findEnemy(MockUnit* u)
+{
+	int side = game->mapWidth() * TILE_SIZE / CELL_SIZE + 1;
+	int cx = u->position.x / CELL_SIZE;
+	int cy = u->position.y / CELL_SIZE;
+	MockUnit* ret = nullptr;
+	int best = 5 * TILE_SIZE;
+	for (int x = std::max(0, cx - 1); x <= std::min(side - 1, cx + 1); ++x) {
+		for (int y = std::max(0, cy - 1); y <= std::min(side - 1, cy + 1); ++y) {
+			for (const auto& e : cells[x + y * side]) {
+				if (e->player == u->player || e->hitPoints <= 0) continue;
+				int d = u->getDistance(e->position);
+				if (d < best) {
+					best = d;
+					ret = e;
+				}
+			}
+		}
+	}
+	return ret;
+}
+
+void SyntheticGame::step(std::vector<MockUnit*>& created, std::vector<MockUnit*>& destroyed)
+{
+	int frame = game->frameCount;
+	std::vector<MockUnit*> units;
+	for (const auto& u : game->getAllUnits()) {
+		MockUnit* m = static_cast<MockUnit*>(u);
+		if (!m->player->isNeutral()) units.push_back(m);
+	}
+
+	int side = game->mapWidth() * TILE_SIZE / CELL_SIZE + 1;
+	for (auto& cell : cells) cell.clear();
+	for (const auto& u : units) cells[u->position.x / CELL_SIZE + u->position.y / CELL_SIZE * side].push_back(u);
+
+	for (const auto& u : units) {
+		u->setFlag(MockUnit::UnderAttack, false);
+		if (u->groundWeaponCooldown > 0) u->groundWeaponCooldown--;
+	}
+
+	for (const auto& u : units) {
+		int playerIndex = u->player->getID();
+		if (u->type.isWorker()) {
+			// mining trips
+			bool mining = (frame / 60 + u->id) % 2 == 0;
+			const std::vector<MockUnit*>& minerals = baseMinerals[u->player];
+			u->order = mining ? Orders::MiningMinerals : Orders::ReturnMinerals;
+			u->orderTarget = mining ? minerals[u->id % minerals.size()] : nullptr;
+			u->setFlag(MockUnit::GatheringMinerals, true);
+			u->position = bases[playerIndex] + Position(random(64) - 32, mining ? -96 : 32);
+			u->targetPosition = u->position;
+			if (frame % 60 == 0) u->player->gatheredMineralCount += 8;
+			continue;
+		}
+		if (!u->type.canMove()) continue;
+
+		MockUnit* enemy = findEnemy(u);
+		if (enemy != nullptr) {
+			u->order = Orders::AttackUnit;
+			u->orderTarget = u->target = enemy;
+			u->targetPosition = u->orderTargetPosition = enemy->position;
+			u->setFlag(MockUnit::Attacking, true);
+			if (u->groundWeaponCooldown == 0) {
+				u->groundWeaponCooldown = 15;
+				enemy->setFlag(MockUnit::UnderAttack, true);
+				enemy->lastAttackingPlayer = u->player;
+				int damage = 10;
+				int onShields = std::min(enemy->shields, damage);
+				enemy->shields -= onShields;
+				enemy->hitPoints -= damage - onShields;
+			}
+			continue;
+		}
+
+		// walk to the destination
+		Position& destination = destinations[u];
+		Position delta = destination - u->position;
+		int length = static_cast<int>(delta.getLength());
+		if (length < 32 || random(400) == 0) destination = newDestination(u);
+		Position next = length > 0 ? u->position + Position(delta.x * 4 / length, delta.y * 4 / length) : u->position;
+		if (game->isWalkable(next.x / 8, next.y / 8)) u->position = next;
+		else destination = newDestination(u);
+		u->order = random(2) ? Orders::Move : Orders::AttackMove;
+		u->orderTarget = u->target = nullptr;
+		u->targetPosition = u->orderTargetPosition = destination;
+		u->setFlag(MockUnit::Attacking, false);
+	}
+
+	for (const auto& u : units) {
+		if (u->hitPoints > 0) continue;
+		game->destroyUnit(u);
+		destroyed.push_back(u);
+		respawns.push_back(std::make_pair(frame + 48, u));
+	}
+	for (auto it = respawns.begin(); it != respawns.end();) {
+		if (it->first > frame) {
+			++it;
+			continue;
+		}
+		MockUnit* dead = it->second;
+		created.push_back(createUnit(dead->type, dead->player, nearBase(dead->player->getID(), 256)));
+		it = respawns.erase(it);
+	}
+
+	for (const auto& p : players) {
+		p->mineralCount = 50 + p->gatheredMineralCount;
+		p->supplyUsedCount = 2 * static_cast<int>(p->units.size());
+		p->supplyTotalCount = std::max(p->supplyUsedCount, 200);
+	}
+}
+
+// ====================================================================================
+// Measures
+// ====================================================================================
+
+struct Measure
+{
+	int64_t ns;
+	size_t allocations;
+	size_t calls;
+	Measure() : ns(0), allocations(0), calls(0) {}
+};
+
+class Results
+{
+public:
+	Results(bool countAllocations = true) : countAllocations(countAllocations) {}
+
+	void time(const std::string& name, const std::function<void()>& f)
+	{
+		size_t allocs = allocations.load(std::memory_order_relaxed);
+		int64_t start = Profiler::now();
+		f();
+		add(name, Profiler::now() - start, allocations.load(std::memory_order_relaxed) - allocs);
+	}
+
+	void add(const std::string& name, int64_t ns, size_t allocs)
+	{
+		if (!measures.count(name)) names.push_back(name);
+		Measure& m = measures[name];
+		m.ns += ns;
+		m.allocations += allocs;
+		m.calls++;
+	}
+
+	// per "divider" (frames or calls), in microseconds or nanoseconds
+	void print(const std::string& title, const Workload& w, double divider, double unit, const std::string& unitName, bool csv) const
+	{
+		if (!csv) {
+			std::cout << "  " << std::left << std::setw(44) << title << std::right << std::setw(14) << unitName
+				<< std::setw(14) << "allocs" << std::setw(10) << "calls" << "\n";
+		}
+		for (const auto& name : names) {
+			const Measure& m = measures.at(name);
+			double d = divider > 0 ? divider : m.calls;
+			if (csv) {
+				std::cout << w.mapSize << "," << w.players << "," << w.units << "," << title << "," << name << ","
+					<< m.ns / unit / d << ",";
+				if (countAllocations) std::cout << m.allocations / d;
+				std::cout << "," << m.calls << "\n";
+			} else {
+				std::cout << "    " << std::left << std::setw(42) << name << std::right << std::fixed << std::setprecision(2)
+					<< std::setw(14) << m.ns / unit / d << std::setw(14);
+				if (countAllocations) std::cout << m.allocations / d;
+				else std::cout << "-";
+				std::cout << std::setw(10) << m.calls << "\n";
+			}
+		}
+	}
+
+private:
+	bool countAllocations; // false for the spans
+	std::vector<std::string> names;
+	std::map<std::string, Measure> measures;
+};
+
+void runWorkload(const Workload& w, int frames, bool csv)
+{
+	SyntheticGame synthetic(w, 42);
+	MockGame* game = synthetic.game;
+
+	// setup, the constructors are timed by the spans of Extractors
+	Profiler::collect();
+	Extractors* extractors = new Extractors(game);
+	Results setup(false);
+	for (const auto& span : Profiler::collect()) setup.add(span.name, span.duration, 0);
+
+	Results perFrame;
+	for (int frame = 1; frame <= frames; ++frame) {
+		game->frameCount = frame;
+		std::vector<MockUnit*> created, destroyed;
+		synthetic.step(created, destroyed);
+
+		for (const auto& u : destroyed) perFrame.time("callbacks onUnitDestroy", [&] { extractors->onUnitDestroy(u); });
+		for (const auto& u : created) perFrame.time("callbacks onUnitCreate", [&] { extractors->onUnitCreate(u); });
+		perFrame.time("GameData::onFrame", [&] { extractors->gameData->onFrame(); });
+		perFrame.time("CombatTracker::onFrame", [&] { combatTracker->onFrame(); });
+		perFrame.time("TerrainAnalyzer::onFrame", [&] { terrain->onFrame(); });
+		perFrame.time("OrderData::onFrame", [&] { extractors->orderData->onFrame(); });
+		perFrame.time("ActionSelection::onFrame", [&] { extractors->actionSelection->onFrame(); });
+		perFrame.time("VisionData::onFrame", [&] { extractors->visionData->onFrame(); });
+		unitDestroyedThisTurn = false;
+	}
+	// spans inside the modules, the callbacks included (without allocations count)
+	Results helpers(false);
+	for (const auto& span : Profiler::collect()) helpers.add(span.name, span.duration, 0);
+
+	Results lookups;
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> tile(0, w.mapSize - 1);
+	const int calls = 10000;
+	for (int i = 0; i < calls; ++i) {
+		TilePosition tp(tile(rng), tile(rng));
+		lookups.time("MapModel::isWalkable", [&] { mapModel->isWalkable(tp); });
+		lookups.time("MapModel::findClosestWalkable", [&] { mapModel->findClosestWalkable(tp); });
+		lookups.time("MapModel::findClosestRegion", [&] { mapModel->findClosestRegion(tp); });
+		lookups.time("MapModel::findClosestCDR", [&] { mapModel->findClosestCDR(tp); });
+	}
+
+	Results teardown;
+	teardown.time("Extractors::~Extractors", [&] { delete extractors; });
+
+	if (!csv) {
+		std::cout << "== map " << w.mapSize << "x" << w.mapSize << ", " << w.players << " players, " << w.units
+			<< " units, " << frames << " frames ==\n";
+	}
+	setup.print("setup", w, 0, 1e6, "ms/call", csv);
+	perFrame.print("per frame", w, frames, 1e3, "us/frame", csv);
+	helpers.print("helpers (spans)", w, frames, 1e3, "us/frame", csv);
+	lookups.print("lookups", w, 0, 1, "ns/call", csv);
+	teardown.print("teardown", w, 0, 1e6, "ms/call", csv);
+	if (!csv) std::cout << std::endl;
+}
+
+std::vector<int> parseList(const char* arg)
+{
+	std::vector<int> ret;
+	std::stringstream ss(arg);
+	std::string item;
+	while (std::getline(ss, item, ',')) ret.push_back(atoi(item.c_str()));
+	return ret;
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<int> maps = { 64, 128, 256 };
+	std::vector<int> players = { 2, 4, 8 };
+	std::vector<int> units = { 100, 500, 2000 };
+	int frames = 300;
+	bool csv = false;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (arg == "--csv") csv = true;
+		else if (i + 1 < argc && arg == "--maps") maps = parseList(argv[++i]);
+		else if (i + 1 < argc && arg == "--players") players = parseList(argv[++i]);
+		else if (i + 1 < argc && arg == "--units") units = parseList(argv[++i]);
+		else if (i + 1 < argc && arg == "--frames") frames = atoi(argv[++i]);
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--maps 64,128,256] [--players 2,4,8] [--units 100,500,2000] [--frames 300] [--csv]" << std::endl;
+			return 1;
+		}
+	}
+
+	// every extractor, RLD included (GameData attacks need it)
+	CREATE_RGD = CREATE_RLD = CREATE_ROD = CREATE_RCD = CREATE_ASD = CREATE_RVD = true;
+	CREATE_RTD = false;
+	PROFILE_SPANS = true;
+	fileLog.open((boost::filesystem::temp_directory_path() / "bwrepdump_bench.log").string().c_str());
+	boost::filesystem::create_directories("bwapi-data/AI"); // TerrainAnalyzer cache, as in StarCraft
+
+	if (csv) std::cout << "map,players,units,section,name,time,allocs,calls\n";
+	for (const auto& m : maps) {
+		for (const auto& p : players) {
+			for (const auto& u : units) {
+				Workload w = { m, std::min(std::max(p, 1), 8), u };
+				runWorkload(w, frames, csv);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,53 @@
+// Replacements of the global new and delete for bwrepdump_bench, to count the heap allocations of
+// the extractors. In their own file so that the compiler doesn't pair an inlined delete (free)
+// with the new expressions of the benchmark (-Wmismatched-new-delete).
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+std::atomic<size_t> allocations(0); // also from the worker and writer threads
+
+// every replaceable new/delete pair, so that all the allocations are counted and freed the same way
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size ? size : 1);
+}
+void* operator new(size_t size)
+{
+	void* p = operator new(size, std::nothrow);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return operator new(size, std::nothrow); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { free(p); }
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	size_t align = static_cast<size_t>(alignment);
+	void* p = nullptr;
+	return posix_memalign(&p, align < sizeof(void*) ? sizeof(void*) : align, size ? size : 1) == 0 ? p : nullptr;
+}
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* p = operator new(size, alignment, std::nothrow);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return operator new(size, alignment, std::nothrow); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { free(p); }
+#endif
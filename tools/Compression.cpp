@@ -0,0 +1,108 @@
+// Compressed ROD/RLD files (COMPRESS_ROD_RLD) tool.
+// Usage:
+//   bwrepdump_lz cat file.rodz [--frames first-last] [--dict file.dict]   prints the text (of the blocks of a frame range)
+//   bwrepdump_lz compress file.rod [--dict file.dict]                    writes file.rodz (or .rldz) from a text output
+//   bwrepdump_lz train out.dict [--size bytes] file.rod [file.rld ...]   trains a dictionary on existing text outputs
+// The dictionary used by BWRepDump is COMPRESSION_DICTIONARY (bwapi-data/AI/BWRepDump.dict).
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "CompressedFile.h"
+
+const size_t MAX_SAMPLE = 1 << 20; // bytes read from each file to train
+
+int usage(const char* name)
+{
+	std::cerr << "Usage: " << name << " cat file.rodz [--frames first-last] [--dict file.dict]\n"
+		<< "       " << name << " compress file.rod [--dict file.dict]\n"
+		<< "       " << name << " train out.dict [--size bytes] file.rod [file.rld ...]" << std::endl;
+	return 1;
+}
+
+int cat(const std::string& path, int firstFrame, int lastFrame, const std::string& dictionary)
+{
+	CompressedFileReader reader(path, dictionary);
+	std::cout << reader.read(firstFrame, lastFrame);
+	return 0;
+}
+
+int compress(const std::string& path, const std::string& dictionary)
+{
+	std::ifstream in(path.c_str());
+	if (!in) throw std::runtime_error("cannot open " + path);
+	CompressedOutputFile out;
+	out.open(path + "z", true, dictionary);
+	// the data lines start with their frame, after the distances header for the RLD
+	bool header = path.size() > 4 && path.compare(path.size() - 4, 4, ".rld") == 0;
+	std::string line;
+	int frame = -1;
+	while (std::getline(in, line)) {
+		if (!header) {
+			char* end;
+			long lineFrame = strtol(line.c_str(), &end, 10);
+			if (end != line.c_str() && *end == ',' && lineFrame != frame) {
+				frame = static_cast<int>(lineFrame);
+				out.beginFrame(frame);
+			}
+		}
+		out << line << '\n';
+		if (line == "[Replay Start]") header = false;
+	}
+	out.close();
+	return 0;
+}
+
+int train(const std::string& outPath, size_t size, const std::vector<std::string>& paths)
+{
+	std::vector<std::string> samples;
+	for (const auto& path : paths) {
+		std::ifstream in(path.c_str(), std::ios::binary);
+		if (!in) throw std::runtime_error("cannot open " + path);
+		std::string sample(MAX_SAMPLE, '\0');
+		in.read(&sample[0], sample.size());
+		sample.resize(static_cast<size_t>(in.gcount()));
+		samples.push_back(sample);
+	}
+	std::string dictionary = Compressed::trainDictionary(samples, size);
+	std::ofstream out(outPath.c_str(), std::ios::binary);
+	out.write(dictionary.data(), dictionary.size());
+	std::cout << outPath << ": " << dictionary.size() << " bytes from " << samples.size() << " files" << std::endl;
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) return usage(argv[0]);
+	std::string command(argv[1]);
+	std::string dictionary;
+	int firstFrame = -1;
+	int lastFrame = INT32_MAX;
+	size_t size = 32 * 1024;
+	std::vector<std::string> files;
+	for (int i = 2; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (i + 1 < argc && arg == "--dict") dictionary = Compressed::loadDictionary(argv[++i]);
+		else if (i + 1 < argc && arg == "--size") size = static_cast<size_t>(atoi(argv[++i]));
+		else if (i + 1 < argc && arg == "--frames") {
+			std::string range(argv[++i]);
+			size_t dash = range.find('-', 1);
+			firstFrame = atoi(range.substr(0, dash).c_str());
+			lastFrame = dash == std::string::npos ? firstFrame : atoi(range.substr(dash + 1).c_str());
+		}
+		else files.push_back(arg);
+	}
+
+	try {
+		if (command == "cat" && files.size() == 1) return cat(files[0], firstFrame, lastFrame, dictionary);
+		if (command == "compress" && files.size() == 1) return compress(files[0], dictionary);
+		if (command == "train" && files.size() >= 2) return train(files[0], size, std::vector<std::string>(files.begin() + 1, files.end()));
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return usage(argv[0]);
+}
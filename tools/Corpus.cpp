@@ -0,0 +1,133 @@
+// Corpus archive (CORPUS_ARCHIVE) tool.
+// Usage:
+//   bwrepdump_corpus list archive [--matchup PvT]              replays of the archive (path, frames, matchup, streams)
+//   bwrepdump_corpus extract archive replay.rep .rgd           prints a stream of a replay
+//   bwrepdump_corpus add archive replay.rep [replay.rep ...]   appends the loose files of already extracted replays
+//   bwrepdump_corpus index archive                             appends a full index if the last one is not, faster to open
+// A stream is named by the extension of the file it replaces (.rgd, .rodz, .rtd, ...).
+// Replays added from loose files get their matchup from the RGD, and the frame of its last event.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "boost/filesystem.hpp"
+
+#include "CorpusArchive.h"
+
+const char* STREAMS[] = { ".rgd", ".rgdb", ".rld", ".rldz", ".rod", ".rodz", ".rcd", ".asd", ".rvd", ".rvdz", ".rtd" };
+
+int usage(const char* name)
+{
+	std::cerr << "Usage: " << name << " list archive [--matchup PvT]\n"
+		<< "       " << name << " extract archive replay.rep stream\n"
+		<< "       " << name << " add archive replay.rep [replay.rep ...]\n"
+		<< "       " << name << " index archive" << std::endl;
+	return 1;
+}
+
+int list(const std::string& archive, const std::string& matchup)
+{
+	CorpusReader reader(archive);
+	for (const auto& replay : reader.getReplays()) {
+		if (!matchup.empty() && replay.matchup != matchup) continue;
+		std::cout << replay.path << "," << replay.frames << "," << replay.matchup;
+		for (const auto& stream : replay.streams) std::cout << "," << stream.name << ":" << stream.size;
+		std::cout << '\n';
+	}
+	return 0;
+}
+
+int extract(const std::string& archive, const std::string& replayPath, const std::string& name)
+{
+	CorpusReader reader(archive);
+	const CorpusReader::Replay* replay = reader.find(replayPath);
+	if (replay == nullptr) throw std::runtime_error(replayPath + " is not in " + archive);
+	size_t size;
+	const char* data = reader.stream(*replay, name, size);
+	if (data == nullptr) throw std::runtime_error(replayPath + " does not have a " + name + " stream");
+	std::cout.write(data, size);
+	return 0;
+}
+
+// frames and matchup of a replay from its RGD, as the extractors would have archived it
+void readRGD(const std::string& rgd, int& frames, std::string& matchup)
+{
+	std::istringstream in(rgd);
+	std::string line, races;
+	bool players = false;
+	while (std::getline(in, line)) {
+		if (line == "The following players are in this replay:") players = true;
+		else if (line == "Begin replay data:") players = false;
+		else if (players) {
+			size_t race = line.find(", ", line.find(", ") + 2);
+			if (race != std::string::npos && race + 2 < line.size()) races += line[race + 2];
+		} else {
+			char* end;
+			long frame = strtol(line.c_str(), &end, 10);
+			if (end != line.c_str() && *end == ',') frames = static_cast<int>(frame);
+		}
+	}
+	std::sort(races.begin(), races.end());
+	for (const auto& r : races) {
+		if (!matchup.empty()) matchup += 'v';
+		matchup += r;
+	}
+}
+
+int add(const std::string& archive, const std::vector<std::string>& replayPaths)
+{
+	bool added = false;
+	for (const auto& replayPath : replayPaths) {
+		Corpus::Streams streams;
+		int frames = -1;
+		std::string matchup;
+		for (const auto& name : STREAMS) {
+			std::string path = replayPath + name;
+			if (!boost::filesystem::exists(path)) continue;
+			std::ifstream in(path.c_str(), std::ios::binary);
+			std::ostringstream data;
+			data << in.rdbuf();
+			streams.push_back(std::make_pair(std::string(name), data.str()));
+			if (streams.back().first == ".rgd") readRGD(streams.back().second, frames, matchup);
+		}
+		if (streams.empty()) {
+			std::cerr << replayPath << ": no extracted files" << std::endl;
+			continue;
+		}
+		Corpus::appendReplay(archive, replayPath, matchup, frames, streams);
+		std::cout << replayPath << ": " << streams.size() << " streams" << std::endl;
+		added = true;
+	}
+	if (added) Corpus::appendFullIndex(archive);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) return usage(argv[0]);
+	std::string command(argv[1]);
+	std::string matchup;
+	std::vector<std::string> args;
+	for (int i = 2; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (i + 1 < argc && arg == "--matchup") matchup = argv[++i];
+		else args.push_back(arg);
+	}
+
+	try {
+		if (command == "list" && args.size() == 1) return list(args[0], matchup);
+		if (command == "extract" && args.size() == 3) return extract(args[0], args[1], args[2]);
+		if (command == "add" && args.size() >= 2) return add(args[0], std::vector<std::string>(args.begin() + 1, args.end()));
+		if (command == "index" && args.size() == 1) {
+			Corpus::appendFullIndex(args[0]);
+			return 0;
+		}
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return usage(argv[0]);
+}
@@ -0,0 +1,132 @@
+// Prints a binary RGD (.rgdb, see CREATE_RGD_BINARY) as the events lines of the text RGD,
+// the example consumer of RGDReader.
+// Usage: bwrepdump_rgdb replay.rep.rgdb [replay.rep.rgdb ...]
+
+#include <iomanip>
+#include <iostream>
+
+#include "boost/iostreams/device/mapped_file.hpp"
+
+#include <BWAPI.h>
+
+#include "RGDReader.h"
+
+using namespace BWAPI;
+
+// {player:{type:count,..},..}, the type -1 being a player without any unit
+void printUnitCounts(const RGDB::UnitCount* counts, uint32_t n)
+{
+	std::cout << "{";
+	for (uint32_t k = 0; k < n; ++k) {
+		if (k == 0 || counts[k].player != counts[k - 1].player) std::cout << (k > 0 ? "}," : "") << counts[k].player << ":{";
+		else std::cout << ",";
+		if (counts[k].type >= 0) std::cout << UnitType(counts[k].type).getName() << ":" << counts[k].count;
+	}
+	std::cout << (n > 0 ? "}}" : "}");
+}
+
+void printAttack(const RGDB::Attack& a, int x, int y)
+{
+	const char* names[] = { "DropAttack", "GroundAttack", "AirAttack", "InvisAttack" };
+	std::cout << ",(";
+	bool first = true;
+	for (int t = 0; t < 4; ++t) {
+		if (!(a.types & (1u << t))) continue;
+		std::cout << (first ? "" : ",") << names[t];
+		first = false;
+	}
+	std::cout << "),(" << x << "," << y << ")," << a.cdr << "," << a.region << ",";
+	printUnitCounts(a.involvedCounts(), a.involved);
+	std::cout << std::fixed << std::setprecision(4) << ",(" << a.scoreGroundCDR << "," << a.scoreGroundRegion << ","
+		<< a.scoreAirCDR << "," << a.scoreAirRegion << "," << a.scoreDetectCDR << "," << a.scoreDetectRegion << ","
+		<< a.economicImportanceCDR << "," << a.economicImportanceRegion << ","
+		<< a.tacticalImportanceCDR << "," << a.tacticalImportanceRegion << "),";
+	std::cout.unsetf(std::ios::floatfield);
+	printUnitCounts(a.atEndCounts(), a.atEnd);
+	std::cout << ",(" << a.lastX << "," << a.lastY << "),";
+	const RGDB::PlayerCount* workers = a.workersDead();
+	for (uint32_t k = 0; k < a.workers; ++k) std::cout << (k == 0 ? "{" : ",") << workers[k].player << ":" << workers[k].count;
+	std::cout << "}," << a.lastFrame; // the RGD line has no "{" without workers
+	if (a.winner >= 0) std::cout << ",winner:" << a.winner;
+}
+
+void printEvent(const RGDReader::Block& block, uint32_t i)
+{
+	int32_t frame = block.frame()[i];
+	int32_t player = block.player()[i];
+	uint8_t kind = block.kind()[i];
+	int32_t type = block.type()[i];
+	std::cout << frame << "," << player << "," << RGDB::eventName(kind);
+	switch (kind) {
+	case RGDB::RepPath:
+	case RGDB::SendMessage:
+		std::cout << "," << block.textString(i);
+		break;
+	case RGDB::IsAttacked:
+		if (const RGDB::Attack* a = block.attack(i)) printAttack(*a, block.x()[i], block.y()[i]);
+		break;
+	case RGDB::MapName:
+		std::cout << "," << block.textString(i) << "," << block.x()[i];
+		break;
+	case RGDB::PlayerInfo:
+		std::cout << "," << block.textString(i) << "," << Race(type).getName() << "," << block.x()[i];
+		break;
+	case RGDB::Created:
+	case RGDB::Destroyed:
+	case RGDB::Morph:
+		std::cout << "," << block.unit()[i] << "," << UnitType(type).getName() << ",(" << block.x()[i] << "," << block.y()[i] << ")";
+		break;
+	case RGDB::Discovered:
+		std::cout << "," << block.unit()[i] << "," << UnitType(type).getName();
+		break;
+	case RGDB::R: {
+		const RGDB::Resources* r = block.resources(i);
+		if (r == nullptr) break;
+		std::cout << "," << r->minerals << "," << r->gas << "," << r->gatheredMinerals << "," << r->gatheredGas
+			<< "," << r->supplyUsed << "," << r->supplyTotal;
+		break;
+	}
+	case RGDB::ChangedOwnership:
+		std::cout << "," << block.unit()[i];
+		break;
+	case RGDB::StartResearch:
+	case RGDB::FinishResearch:
+	case RGDB::CancelResearch:
+		std::cout << "," << TechType(type).getName();
+		break;
+	case RGDB::StartUpgrade:
+	case RGDB::FinishUpgrade:
+	case RGDB::CancelUpgrade:
+		std::cout << "," << UpgradeType(type).getName() << "," << block.payload()[i];
+		break;
+	case RGDB::NuclearLaunch:
+		std::cout << ",(" << block.x()[i] << "," << block.y()[i] << ")";
+		break;
+	default:
+		break;
+	}
+	std::cout << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " replay.rep.rgdb [replay.rep.rgdb ...]" << std::endl;
+		return 1;
+	}
+
+	int errors = 0;
+	for (int i = 1; i < argc; ++i) {
+		try {
+			boost::iostreams::mapped_file_source file(argv[i]);
+			RGDReader reader(file.data(), file.size());
+			for (const auto& block : reader.getBlocks()) {
+				for (uint32_t e = 0; e < block.size(); ++e) printEvent(block, e);
+			}
+		} catch (const std::exception& e) {
+			std::cerr << argv[i] << ": " << e.what() << std::endl;
+			errors++;
+		}
+	}
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Throughput of the text output parsers (ReplayParser.h), against reading the same text with
+// std::getline and splitting each line into std::strings (what the Python scripts do).
+// Usage: bwrepdump_parse_bench [--size MB] [--repeat n] [replay.rep.rgd replay.rep.rodz ...]
+// Without files it parses synthetic RGD, ROD, RLD, RCD and ASD texts of --size MB (default 256)
+// each. The files are read through Parse::Source, .rodz/.rldz are decompressed before timing.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "ReplayParser.h"
+
+// ====================================================================================
+// Synthetic outputs, lines like the ones of a real replay
+// ====================================================================================
+
+const char* UNIT_TYPES[] = { "Terran Marine", "Terran SCV", "Protoss Zealot", "Protoss Dragoon", "Zerg Zergling",
+	"Zerg Hydralisk", "Terran Siege Tank Tank Mode", "Protoss Probe", "Zerg Drone", "Resource Mineral Field" };
+const char* ORDERS[] = { "PlayerGuard", "Move", "AttackUnit", "MoveToMinerals", "WaitForMinerals", "MiningMinerals",
+	"ReturnMinerals", "AttackMove", "Stop", "BuildingLand" };
+
+std::string synthetic(const std::string& format, size_t size)
+{
+	std::mt19937 rng(42);
+	auto r = [&rng](int n) { return static_cast<int>(rng() % n); };
+	std::ostringstream out;
+	int frame = 0;
+	if (format == "rgd") {
+		out << "[Replay Start]\nRepPath: maps/replays/synthetic.rep\nMapName: Synthetic\nNumStartPositions: 2\n"
+			"The following players are in this replay:\n0, p1, Terran, 0\n1, p2, Zerg, 1\nBegin replay data:\n";
+	} else if (format == "rld") {
+		out << "Regions,1048591,2097183,3080238\n3080238,1402,678\n2097183,724\n1048591\n"
+			"ChokeDepReg,1048591,2097183,3080238\n3080238,1402,678\n2097183,724\n1048591\n[Replay Start]\n";
+	} else if (format == "rcd") {
+		out << "maps/replays/synthetic.rep,0123456789abcdef\n";
+	}
+	while (static_cast<size_t>(out.tellp()) < size) {
+		frame += r(8);
+		if (format == "rgd") {
+			switch (r(4)) {
+			case 0: out << frame << "," << r(2) << ",R," << r(3000) << "," << r(1000) << "," << r(30000) << "," << r(9000) << "," << r(400) << ",400\n"; break;
+			case 1: out << frame << "," << r(2) << ",Created," << r(2000) << "," << UNIT_TYPES[r(10)] << ",(" << r(4096) << "," << r(4096) << ")\n"; break;
+			case 2: out << frame << "," << r(2) << ",Destroyed," << r(2000) << "," << UNIT_TYPES[r(10)] << ",(" << r(4096) << "," << r(4096) << ")\n"; break;
+			default: out << frame << "," << r(2) << ",Discovered," << r(2000) << "," << UNIT_TYPES[r(10)] << "\n"; break;
+			}
+		} else if (format == "rod") {
+			out << frame << "," << r(2000) << "," << ORDERS[r(10)] << "," << (r(2) ? "T" : "P") << "," << r(4096) << "," << r(4096) << "\n";
+		} else if (format == "rld") {
+			switch (r(3)) {
+			case 0: out << frame << "," << r(2000) << "," << r(4096) << "," << r(4096) << "\n"; break;
+			case 1: out << frame << "," << r(2000) << ",Reg," << 1048591 + r(3) * 1031647 << "\n"; break;
+			default: out << frame << "," << r(2000) << ",CDR," << 1048591 + r(3) * 1031647 << "\n"; break;
+			}
+		} else if (format == "rcd") {
+			out << "NEW_COMBAT," << frame << "," << frame + r(500) << ",PEACE\nARMY_UPGRADES 0,Terran Infantry Weapons:1\n";
+			for (int p = 0; p < 2; ++p) {
+				out << "ARMY_START " << p << "\n";
+				for (int u = r(20); u >= 0; --u) out << r(2000) << "," << UNIT_TYPES[r(10)] << "," << r(128) << "," << r(128) << "," << r(200) << ",0,0\n";
+			}
+			for (int p = 0; p < 2; ++p) {
+				out << "ARMY_END " << p << "\n";
+				for (int u = r(20); u >= 0; --u) out << r(2000) << "," << UNIT_TYPES[r(10)] << "," << r(128) << "," << r(128) << "," << r(200) << ",0,0\n";
+			}
+			out << "KILLS\n" << r(2000) << "," << frame << "\nUNITS_NOT_PARTICIPATED\n" << r(2000) << "," << r(2000) << "\n";
+		} else {
+			out << r(200) << "," << UNIT_TYPES[r(10)] << "," << r(50) << ",Move," << r(50) << "#ATTACK,MOVE:" << r(50) << ",MOVE:" << r(50)
+				<< "#" << r(50) << ":1,0,0,0#" << r(50) << ":0,1,1,0#" << r(50) << ":1,1,0,1\n";
+		}
+	}
+	return out.str();
+}
+
+// ====================================================================================
+// Timing
+// ====================================================================================
+
+struct Result
+{
+	double seconds;
+	size_t items;
+};
+
+template <class F>
+Result best(int repeat, F parse)
+{
+	Result result = { 1e30, 0 };
+	for (int i = 0; i < repeat; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		size_t items = parse();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (seconds < result.seconds) result.seconds = seconds;
+		result.items = items;
+	}
+	return result;
+}
+
+template <class Parser>
+size_t parseAll(const char* data, size_t size)
+{
+	Parser parser(data, size);
+	size_t n = 0;
+	for (const auto& e : parser) {
+		(void)e;
+		++n;
+	}
+	return n;
+}
+
+size_t parse(const std::string& format, const char* data, size_t size)
+{
+	if (format == "rgd") return parseAll<RGDParser>(data, size);
+	if (format == "rod") return parseAll<RODParser>(data, size);
+	if (format == "rld") return parseAll<RLDParser>(data, size);
+	if (format == "rcd") return parseAll<RCDParser>(data, size);
+	return parseAll<ASDParser>(data, size);
+}
+
+// std::getline and a std::vector<std::string> of the fields of each line
+size_t naive(const char* data, size_t size)
+{
+	std::istringstream in(std::string(data, size));
+	std::string line;
+	size_t fields = 0;
+	while (std::getline(in, line)) {
+		std::vector<std::string> split;
+		std::istringstream lineStream(line);
+		std::string field;
+		while (std::getline(lineStream, field, ',')) split.push_back(field);
+		fields += split.size();
+	}
+	return fields;
+}
+
+void report(const std::string& name, const std::string& format, size_t bytes, int repeat, const char* data)
+{
+	Result parsed = best(repeat, [&]() { return parse(format, data, bytes); });
+	Result baseline = best(1, [&]() { return naive(data, bytes); });
+	double gb = bytes / 1e9;
+	std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(10) << bytes / 1e6 << " MB" << std::setw(12) << parsed.items
+		<< std::setprecision(2) << std::setw(10) << gb / parsed.seconds << " GB/s"
+		<< std::setw(10) << gb / baseline.seconds << " GB/s" << std::setprecision(1)
+		<< std::setw(8) << baseline.seconds / parsed.seconds << "x\n";
+}
+
+int main(int argc, char* argv[])
+{
+	size_t size = 256;
+	int repeat = 5;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (i + 1 < argc && arg == "--size") size = static_cast<size_t>(atoi(argv[++i]));
+		else if (i + 1 < argc && arg == "--repeat") repeat = std::max(1, atoi(argv[++i]));
+		else files.push_back(arg);
+	}
+
+	std::cout << std::left << std::setw(36) << "input" << std::right << std::setw(13) << "size" << std::setw(12) << "events"
+		<< std::setw(15) << "parser" << std::setw(15) << "getline" << std::setw(9) << "speedup" << "\n";
+	try {
+		if (files.empty()) {
+			const char* formats[] = { "rgd", "rod", "rld", "rcd", "asd" };
+			for (const auto& format : formats) {
+				std::string text = synthetic(format, size << 20);
+				report(std::string("synthetic .") + format, format, text.size(), repeat, text.data());
+			}
+		}
+		for (const auto& path : files) {
+			Parse::Source source(path);
+			std::string format = path.substr(path.rfind('.') + 1, 3);
+			report(path, format, source.size(), repeat, source.data());
+		}
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,35 @@
+// Re-runs the extractors on recorded traces (RTD files, see CREATE_RTD) without StarCraft.
+// Usage: bwrepdump_replay trace.rtd [trace.rtd ...]
+// The extractors output (RGD, ROD, RCD, ...) is written next to each trace.
+
+#include <chrono>
+#include <iostream>
+
+#include "TraceReplayer.h"
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " trace.rtd [trace.rtd ...]" << std::endl;
+		return 1;
+	}
+
+	fileLog.open("BWRepDump.log", std::ios_base::app);
+	int errors = 0;
+	for (int i = 1; i < argc; ++i) {
+		LOG("[NEW TRACE] " << argv[i]);
+		auto start = std::chrono::steady_clock::now();
+		try {
+			TraceReplayer replayer(argv[i]);
+			replayer.run();
+		} catch (const std::exception& e) {
+			std::cerr << argv[i] << ": " << e.what() << std::endl;
+			errors++;
+			continue;
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << argv[i] << ": " << elapsed.count() << " ms" << std::endl;
+	}
+	fileLog.close();
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Precomputes the terrain caches ($mapHash.terrain, see TerrainCache.h) of a map pool offline, so
+// that the first replay of each map does not compute them inside StarCraft.
+// Usage: bwrepdump_warm [--cache folder] [--threads n] [--stale seconds] input...
+// An input is a trace (.rtd, see CREATE_RTD) or a folder searched recursively for traces, only the
+// map of each trace is read (walkability, regions and chokepoints). Each map is done once, the
+// ground distances of a map are spread on --threads threads (TERRAIN_THREADS).
+// Several workers (on one machine or on a farm) can warm the same cache folder: a worker claims a
+// map with a $mapHash.terrain.claim file before computing it and the others skip it. A claim older
+// than --stale seconds (default 3600) belongs to a dead worker and is taken over.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <set>
+
+#include "boost/filesystem.hpp"
+
+#include "MapModel.h"
+#include "TraceReplayer.h"
+
+enum Result { Computed, Cached, Claimed, NotWritten };
+
+// true if this worker now owns the claim of the cache file
+bool claim(const boost::filesystem::path& claimPath, int staleSeconds)
+{
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		FILE* f = fopen(claimPath.string().c_str(), "wx"); // fails if another worker claimed it
+		if (f != nullptr) {
+			fclose(f);
+			return true;
+		}
+		boost::system::error_code error;
+		std::time_t claimed = boost::filesystem::last_write_time(claimPath, error);
+		if (error || std::time(nullptr) - claimed < staleSeconds) return false;
+		boost::filesystem::remove(claimPath, error);
+	}
+	return false;
+}
+
+Result warm(MockGame* map, int staleSeconds)
+{
+	boost::filesystem::path cachePath(TERRAIN_CACHE_FOLDER);
+	boost::filesystem::create_directories(cachePath);
+	boost::filesystem::path filePath = cachePath / (map->mapHash() + ".terrain");
+	boost::filesystem::path claimPath = cachePath / (map->mapHash() + ".terrain.claim");
+
+	TerrainCacheFile cached;
+	if (cached.open(filePath.string(), map->mapWidth(), map->mapHeight())) return Cached;
+	if (!claim(claimPath, staleSeconds)) return Claimed;
+	try {
+		// another worker may have written it between the check and the claim
+		if (cached.open(filePath.string(), map->mapWidth(), map->mapHeight())) {
+			boost::filesystem::remove(claimPath);
+			return Cached;
+		}
+		{
+			MapModel model; // writes the file, or only keeps the cache in memory if it cannot (logged)
+		}
+	} catch (...) {
+		boost::filesystem::remove(claimPath);
+		throw;
+	}
+	boost::filesystem::remove(claimPath);
+	return cached.open(filePath.string(), map->mapWidth(), map->mapHeight()) ? Computed : NotWritten;
+}
+
+int main(int argc, char* argv[])
+{
+	int staleSeconds = 3600;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (i + 1 < argc && arg == "--cache") TERRAIN_CACHE_FOLDER = argv[++i];
+		else if (i + 1 < argc && arg == "--threads") TERRAIN_THREADS = std::max(1, atoi(argv[++i]));
+		else if (i + 1 < argc && arg == "--stale") staleSeconds = std::max(0, atoi(argv[++i]));
+		else paths.push_back(arg);
+	}
+	if (paths.empty()) {
+		std::cerr << "Usage: " << argv[0] << " [--cache folder] [--threads n] [--stale seconds] trace.rtd|folder ..." << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> traces;
+	for (const auto& path : paths) {
+		if (boost::filesystem::is_directory(path)) {
+			for (boost::filesystem::recursive_directory_iterator it(path), end; it != end; ++it) {
+				if (boost::filesystem::is_regular_file(it->path()) && it->path().extension() == ".rtd") traces.push_back(it->path().string());
+			}
+		} else {
+			traces.push_back(path);
+		}
+	}
+	std::sort(traces.begin(), traces.end());
+
+	fileLog.open("BWRepDump.log", std::ios_base::app);
+	std::set<std::string> done; // map hashes
+	int computed = 0, cached = 0, claimed = 0, errors = 0;
+	for (const auto& trace : traces) {
+		auto start = std::chrono::steady_clock::now();
+		try {
+			TraceReplayer replayer(trace);
+			MockGame* map = replayer.getGame();
+			if (!done.insert(map->mapHash()).second) continue;
+			game = map;
+			Result result = warm(map, staleSeconds);
+			game = nullptr;
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			if (result == Computed) {
+				computed++;
+				std::cout << map->mapHash() << " (" << map->mapName() << "): computed in " << elapsed.count() << " ms" << std::endl;
+			} else if (result == Cached) {
+				cached++;
+			} else if (result == NotWritten) {
+				errors++;
+				std::cerr << map->mapHash() << " (" << map->mapName() << "): computed but not written (see BWRepDump.log)" << std::endl;
+			} else {
+				claimed++;
+				std::cout << map->mapHash() << " (" << map->mapName() << "): claimed by another worker" << std::endl;
+			}
+		} catch (const std::exception& e) {
+			game = nullptr;
+			std::cerr << trace << ": " << e.what() << std::endl;
+			errors++;
+		}
+	}
+	fileLog.close();
+	std::cerr << done.size() << " maps: " << computed << " computed, " << cached << " already cached, "
+		<< claimed << " claimed by other workers, " << errors << " errors" << std::endl;
+	return errors == 0 ? 0 : 1;
+}